@@ -0,0 +1,42 @@
+//
+// Copyright 2018 Marcin Radomski. All rights reserved.
+//
+// Licensed under the MIT license. See LICENSE file in the project root for
+// details.
+//
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+#include <cstdint>
+
+#include <nestl/allocator.hpp>
+#include <nestl/caching_allocator.hpp>
+#include <nestl/vector.hpp>
+
+namespace {
+
+// short-lived vectors, created and destroyed by every benchmark thread
+template <typename Allocator>
+void churn_vectors(benchmark::State& state) {
+    auto count = static_cast<uint32_t>(state.range(0));
+    for (auto _ : state) {
+        nestl::vector<uint32_t, Allocator> v;
+        for (uint32_t i = 0; i < count; ++i) {
+            benchmark::DoNotOptimize(v.push_back(i));
+        }
+        benchmark::ClobberMemory();
+    }
+}
+
+void BM_system_allocator_churn(benchmark::State& state) {
+    churn_vectors<nestl::system_allocator>(state);
+}
+
+void BM_caching_allocator_churn(benchmark::State& state) {
+    churn_vectors<nestl::caching_allocator<>>(state);
+}
+
+}  // namespace
+
+BENCHMARK(BM_system_allocator_churn)->Arg(4)->Arg(64)->ThreadRange(1, 32);
+BENCHMARK(BM_caching_allocator_churn)->Arg(4)->Arg(64)->ThreadRange(1, 32);
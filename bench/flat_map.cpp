@@ -0,0 +1,61 @@
+//
+// Copyright 2018 Marcin Radomski. All rights reserved.
+//
+// Licensed under the MIT license. See LICENSE file in the project root for
+// details.
+//
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+#include <cstdint>
+
+#include <map>
+#include <utility>
+
+#include <nestl/flat_map.hpp>
+#include <nestl/vector.hpp>
+
+namespace {
+
+// xorshift: cheap enough not to show up next to the lookup
+uint32_t next_random(uint32_t& state) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+// half of the lookups miss
+template <typename Map>
+void lookup(benchmark::State& state, const Map& map, uint32_t num_keys) {
+    uint32_t rng = 2463534242u;
+    for (auto _ : state) {
+        uint32_t key = next_random(rng) % (num_keys * 2);
+        benchmark::DoNotOptimize(map.find(key) != map.end());
+    }
+}
+
+void BM_std_map_lookup(benchmark::State& state) {
+    auto num_keys = static_cast<uint32_t>(state.range(0));
+    std::map<uint32_t, uint32_t> map;
+    for (uint32_t i = 0; i < num_keys; ++i) {
+        map.emplace(i * 2, i);
+    }
+    lookup(state, map, num_keys);
+}
+BENCHMARK(BM_std_map_lookup)->Range(16, 16 * 1024);
+
+void BM_flat_map_lookup(benchmark::State& state) {
+    auto num_keys = static_cast<uint32_t>(state.range(0));
+    nestl::vector<std::pair<uint32_t, uint32_t>> elems;
+    for (uint32_t i = 0; i < num_keys; ++i) {
+        (void)elems.emplace_back(i * 2, i);
+    }
+
+    nestl::flat_map<uint32_t, uint32_t> map;
+    (void)map.insert_sorted_range(elems.begin(), elems.end());
+    lookup(state, map, num_keys);
+}
+BENCHMARK(BM_flat_map_lookup)->Range(16, 16 * 1024);
+
+}  // namespace
@@ -0,0 +1,51 @@
+//
+// Copyright 2018 Marcin Radomski. All rights reserved.
+//
+// Licensed under the MIT license. See LICENSE file in the project root for
+// details.
+//
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+#include <cstdint>
+
+#include <nestl/allocator.hpp>
+#include <nestl/mmap_allocator.hpp>
+#include <nestl/vector.hpp>
+
+namespace {
+
+// fills a vector element by element, so growth goes through reallocate()
+template <typename Allocator>
+void grow_vector(benchmark::State& state, const Allocator& alloc) {
+    auto count = static_cast<uint64_t>(state.range(0));
+    for (auto _ : state) {
+        nestl::vector<uint64_t, Allocator> v{alloc};
+        for (uint64_t i = 0; i < count; ++i) {
+            benchmark::DoNotOptimize(v.push_back(i));
+        }
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * count
+                                                 * sizeof(uint64_t)));
+}
+
+void BM_system_allocator_grow(benchmark::State& state) {
+    grow_vector(state, nestl::system_allocator{});
+}
+
+void BM_mmap_allocator_grow(benchmark::State& state) {
+    grow_vector(state, nestl::mmap_allocator<>{});
+}
+
+void BM_mmap_allocator_grow_huge(benchmark::State& state) {
+    grow_vector(state, nestl::mmap_allocator<>{
+                           nestl::mmap_allocator<>::default_threshold,
+                           nestl::huge_pages::transparent});
+}
+
+}  // namespace
+
+BENCHMARK(BM_system_allocator_grow)->Range(1 << 16, 1 << 24);
+BENCHMARK(BM_mmap_allocator_grow)->Range(1 << 16, 1 << 24);
+BENCHMARK(BM_mmap_allocator_grow_huge)->Range(1 << 16, 1 << 24);
@@ -0,0 +1,123 @@
+//
+// Copyright 2018 Marcin Radomski. All rights reserved.
+//
+// Licensed under the MIT license. See LICENSE file in the project root for
+// details.
+//
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+#include <cstdint>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <nestl/mpmc_queue.hpp>
+
+namespace {
+
+constexpr uint64_t items_per_iteration = 1 << 18;
+constexpr size_t queue_capacity = 1024;
+
+/*
+ * Bounded queue guarded by a single mutex, with the same blocking interface
+ * as mpmc_queue.
+ */
+class locked_queue {
+    std::mutex m_mutex;
+    std::condition_variable m_not_empty;
+    std::condition_variable m_not_full;
+    std::deque<uint64_t> m_items;
+
+public:
+    void push(uint64_t e) {
+        std::unique_lock<std::mutex> lock{m_mutex};
+        m_not_full.wait(lock,
+                        [this] { return m_items.size() < queue_capacity; });
+        m_items.push_back(e);
+        lock.unlock();
+        m_not_empty.notify_one();
+    }
+
+    uint64_t pop() {
+        std::unique_lock<std::mutex> lock{m_mutex};
+        m_not_empty.wait(lock, [this] { return !m_items.empty(); });
+        uint64_t e = m_items.front();
+        m_items.pop_front();
+        lock.unlock();
+        m_not_full.notify_one();
+        return e;
+    }
+};
+
+/*
+ * Moves items_per_iteration integers from `producers` to `consumers`
+ * threads. The item counts are split evenly, any remainder goes to the
+ * first thread.
+ */
+template <typename Queue>
+void transfer(benchmark::State& state, Queue& q) {
+    auto producers = static_cast<uint64_t>(state.range(0));
+    auto consumers = static_cast<uint64_t>(state.range(1));
+
+    auto share = [](uint64_t threads, uint64_t idx) {
+        uint64_t n = items_per_iteration / threads;
+        return idx == 0 ? n + items_per_iteration % threads : n;
+    };
+
+    for (auto _ : state) {
+        std::atomic<uint64_t> sum{0};
+        std::vector<std::thread> threads;
+        for (uint64_t p = 0; p < producers; ++p) {
+            threads.emplace_back([&q, n = share(producers, p)] {
+                for (uint64_t i = 0; i < n; ++i) {
+                    q.push(i);
+                }
+            });
+        }
+        for (uint64_t c = 0; c < consumers; ++c) {
+            threads.emplace_back([&q, &sum, n = share(consumers, c)] {
+                uint64_t local = 0;
+                for (uint64_t i = 0; i < n; ++i) {
+                    local += q.pop();
+                }
+                sum += local;
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        benchmark::DoNotOptimize(sum.load());
+    }
+    state.SetItemsProcessed(state.iterations()
+                            * static_cast<int64_t>(items_per_iteration));
+}
+
+void BM_mpmc_queue(benchmark::State& state) {
+    nestl::mpmc_queue<uint64_t> q;
+    if (!q.init(queue_capacity)) {
+        state.SkipWithError("out of memory");
+        return;
+    }
+    transfer(state, q);
+}
+
+void BM_locked_queue(benchmark::State& state) {
+    locked_queue q;
+    transfer(state, q);
+}
+
+void thread_counts(benchmark::internal::Benchmark* b) {
+    b->ArgNames({"producers", "consumers"});
+    b->ArgsProduct({{1, 2, 4, 8, 16, 32}, {1, 2, 4, 8, 16, 32}});
+    b->UseRealTime();
+}
+
+}  // namespace
+
+BENCHMARK(BM_mpmc_queue)->Apply(thread_counts);
+BENCHMARK(BM_locked_queue)->Apply(thread_counts);
@@ -0,0 +1,96 @@
+//
+// Copyright 2018 Marcin Radomski. All rights reserved.
+//
+// Licensed under the MIT license. See LICENSE file in the project root for
+// details.
+//
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+#include <cstdint>
+
+#include <algorithm>
+#include <numeric>
+#include <random>
+
+#include <nestl/parallel.hpp>
+#include <nestl/thread_pool.hpp>
+#include <nestl/vector.hpp>
+
+namespace {
+
+constexpr size_t element_count = size_t{1} << 22;
+
+nestl::vector<uint64_t> random_values() {
+    std::mt19937_64 rng{42};
+    nestl::vector<uint64_t> v;
+    (void)v.reserve(element_count);
+    for (size_t i = 0; i < element_count; ++i) {
+        (void)v.push_back(rng());
+    }
+    return v;
+}
+
+void BM_std_sort(benchmark::State& state) {
+    const auto input = random_values();
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto v = input.copy().ok();
+        state.ResumeTiming();
+        std::sort(v.begin(), v.end());
+        benchmark::DoNotOptimize(v.data());
+    }
+    state.SetItemsProcessed(state.iterations()
+                            * static_cast<int64_t>(element_count));
+}
+BENCHMARK(BM_std_sort)->UseRealTime();
+
+void BM_par_sort(benchmark::State& state) {
+    nestl::thread_pool<> pool;
+    if (!pool.start(static_cast<size_t>(state.range(0)))) {
+        state.SkipWithError("out of memory");
+        return;
+    }
+    const auto input = random_values();
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto v = input.copy().ok();
+        state.ResumeTiming();
+        if (!nestl::par::sort(pool, v)) {
+            state.SkipWithError("out of memory");
+            return;
+        }
+        benchmark::DoNotOptimize(v.data());
+    }
+    state.SetItemsProcessed(state.iterations()
+                            * static_cast<int64_t>(element_count));
+}
+BENCHMARK(BM_par_sort)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->UseRealTime();
+
+void BM_std_reduce(benchmark::State& state) {
+    const auto v = random_values();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(
+            std::accumulate(v.begin(), v.end(), uint64_t{0}));
+    }
+    state.SetItemsProcessed(state.iterations()
+                            * static_cast<int64_t>(element_count));
+}
+BENCHMARK(BM_std_reduce)->UseRealTime();
+
+void BM_par_reduce(benchmark::State& state) {
+    nestl::thread_pool<> pool;
+    if (!pool.start(static_cast<size_t>(state.range(0)))) {
+        state.SkipWithError("out of memory");
+        return;
+    }
+    const auto v = random_values();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(nestl::par::reduce(pool, v, uint64_t{0}));
+    }
+    state.SetItemsProcessed(state.iterations()
+                            * static_cast<int64_t>(element_count));
+}
+BENCHMARK(BM_par_reduce)->Arg(1)->Arg(4)->UseRealTime();
+
+}  // namespace
@@ -0,0 +1,95 @@
+//
+// Copyright 2018 Marcin Radomski. All rights reserved.
+//
+// Licensed under the MIT license. See LICENSE file in the project root for
+// details.
+//
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+#include <cstdint>
+
+#include <nestl/allocator.hpp>
+#include <nestl/pool_allocator.hpp>
+#include <nestl/vector.hpp>
+
+namespace {
+
+constexpr size_t live_vectors = 4096;
+
+// xorshift: cheap enough not to show up next to the allocator
+uint32_t next_random(uint32_t& state) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+template <typename Allocator>
+void churn_vectors(benchmark::State& state, const Allocator& alloc) {
+    using vec = nestl::vector<uint32_t, Allocator>;
+
+    // storage for vectors that get replaced at random
+    vec* slots = static_cast<vec*>(::operator new(sizeof(vec) * live_vectors));
+    for (size_t i = 0; i < live_vectors; ++i) {
+        new (&slots[i]) vec{alloc};
+    }
+
+    uint32_t rng = 2463534242u;
+    for (auto _ : state) {
+        vec& v = slots[next_random(rng) % live_vectors];
+        v.~vec();
+        new (&v) vec{alloc};
+
+        uint32_t n = next_random(rng) % 8 + 1;
+        for (uint32_t i = 0; i < n; ++i) {
+            benchmark::DoNotOptimize(v.push_back(i));
+        }
+    }
+
+    for (size_t i = 0; i < live_vectors; ++i) {
+        slots[i].~vec();
+    }
+    ::operator delete(slots);
+}
+
+template <typename Allocator>
+void churn_blocks(benchmark::State& state, Allocator alloc) {
+    void* blocks[live_vectors] = {};
+
+    uint32_t rng = 2463534242u;
+    for (auto _ : state) {
+        void*& block = blocks[next_random(rng) % live_vectors];
+        alloc.free(block);
+        block = alloc.allocate(next_random(rng) % 128 + 1).ok();
+        benchmark::DoNotOptimize(block);
+    }
+
+    for (void* block : blocks) {
+        alloc.free(block);
+    }
+}
+
+void BM_system_churn_vectors(benchmark::State& state) {
+    churn_vectors(state, nestl::system_allocator{});
+}
+BENCHMARK(BM_system_churn_vectors);
+
+void BM_pool_churn_vectors(benchmark::State& state) {
+    nestl::slab_pool<> pool{64 * 1024 * 1024};
+    churn_vectors(state, nestl::pool_allocator<>{pool});
+}
+BENCHMARK(BM_pool_churn_vectors);
+
+void BM_system_churn_blocks(benchmark::State& state) {
+    churn_blocks(state, nestl::system_allocator{});
+}
+BENCHMARK(BM_system_churn_blocks);
+
+void BM_pool_churn_blocks(benchmark::State& state) {
+    nestl::slab_pool<> pool{64 * 1024 * 1024};
+    churn_blocks(state, nestl::pool_allocator<>{pool});
+}
+BENCHMARK(BM_pool_churn_blocks);
+
+}  // namespace
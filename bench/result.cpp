@@ -0,0 +1,93 @@
+//
+// Copyright 2018 Marcin Radomski. All rights reserved.
+//
+// Licensed under the MIT license. See LICENSE file in the project root for
+// details.
+//
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+#include <cstdint>
+
+#include <nestl/result.hpp>
+
+namespace {
+
+/*
+ * An error raised at the bottom of a few non-inlined calls and propagated
+ * to the top, once every `period` calls (or never, if period is 0), either
+ * as a nestl::result or as an exception.
+ */
+class parse_error {};
+
+#define NOINLINE __attribute__((noinline))
+
+NOINLINE nestl::result<uint64_t, parse_error> leaf_result(uint64_t i,
+                                                          uint64_t period) {
+    if (period != 0 && i % period == 0) {
+        return {parse_error{}};
+    }
+    return {i * 3};
+}
+
+NOINLINE nestl::result<uint64_t, parse_error> mid_result(uint64_t i,
+                                                         uint64_t period) {
+    auto res = leaf_result(i, period);
+    if (!res) {
+        return {res.err()};
+    }
+    return {res.ok() + 1};
+}
+
+NOINLINE nestl::result<uint64_t, parse_error> top_result(uint64_t i,
+                                                         uint64_t period) {
+    return mid_result(i, period).map([](uint64_t v) noexcept { return v * 2; });
+}
+
+NOINLINE uint64_t leaf_throw(uint64_t i, uint64_t period) {
+    if (period != 0 && i % period == 0) {
+        throw parse_error{};
+    }
+    return i * 3;
+}
+
+NOINLINE uint64_t mid_throw(uint64_t i, uint64_t period) {
+    return leaf_throw(i, period) + 1;
+}
+
+NOINLINE uint64_t top_throw(uint64_t i, uint64_t period) {
+    return mid_throw(i, period) * 2;
+}
+
+void BM_result_propagation(benchmark::State& state) {
+    auto period = static_cast<uint64_t>(state.range(0));
+    uint64_t i = 0;
+    uint64_t errors = 0;
+    for (auto _ : state) {
+        auto res = top_result(++i, period);
+        if (res) {
+            benchmark::DoNotOptimize(res.ok());
+        } else {
+            ++errors;
+        }
+    }
+    benchmark::DoNotOptimize(errors);
+}
+BENCHMARK(BM_result_propagation)->Arg(0)->Arg(1000)->Arg(10)->Arg(2);
+
+void BM_exception_propagation(benchmark::State& state) {
+    auto period = static_cast<uint64_t>(state.range(0));
+    uint64_t i = 0;
+    uint64_t errors = 0;
+    for (auto _ : state) {
+        try {
+            benchmark::DoNotOptimize(top_throw(++i, period));
+        } catch (const parse_error&) {
+            ++errors;
+        }
+    }
+    benchmark::DoNotOptimize(errors);
+}
+BENCHMARK(BM_exception_propagation)->Arg(0)->Arg(1000)->Arg(10)->Arg(2);
+
+}  // namespace
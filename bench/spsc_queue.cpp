@@ -0,0 +1,126 @@
+//
+// Copyright 2018 Marcin Radomski. All rights reserved.
+//
+// Licensed under the MIT license. See LICENSE file in the project root for
+// details.
+//
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+#include <cstdint>
+
+#include <algorithm>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#include <nestl/spsc_queue.hpp>
+
+namespace {
+
+constexpr uint64_t items_per_iteration = 1 << 20;
+
+/*
+ * Handoff between two threads through a mutex-guarded std::deque, with the
+ * same interface as spsc_queue.
+ */
+class locked_deque {
+    std::mutex m_mutex;
+    std::deque<uint64_t> m_items;
+
+public:
+    static constexpr size_t capacity = 4096;
+
+    size_t push_n(const uint64_t* items, size_t count) {
+        std::lock_guard<std::mutex> lock{m_mutex};
+        size_t n = std::min(count, capacity - m_items.size());
+        m_items.insert(m_items.end(), items, items + n);
+        return n;
+    }
+
+    size_t pop_n(uint64_t* out, size_t max_count) {
+        std::lock_guard<std::mutex> lock{m_mutex};
+        size_t n = std::min(max_count, m_items.size());
+        std::copy(m_items.begin(), m_items.begin() + n, out);
+        m_items.erase(m_items.begin(), m_items.begin() + n);
+        return n;
+    }
+};
+
+// moves items_per_iteration integers from a producer thread, `batch` at once
+template <typename Queue>
+void transfer(benchmark::State& state, Queue& q) {
+    auto batch = static_cast<size_t>(state.range(0));
+    for (auto _ : state) {
+        std::thread producer([&q, batch] {
+            uint64_t items[64];
+            for (uint64_t next = 0; next < items_per_iteration;) {
+                for (size_t i = 0; i < batch; ++i) {
+                    items[i] = next + i;
+                }
+                next += q.push_n(items, batch);
+            }
+        });
+
+        uint64_t items[64];
+        uint64_t sum = 0;
+        for (uint64_t received = 0; received < items_per_iteration;) {
+            size_t n = q.pop_n(items, batch);
+            for (size_t i = 0; i < n; ++i) {
+                sum += items[i];
+            }
+            received += n;
+        }
+        producer.join();
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations()
+                            * static_cast<int64_t>(items_per_iteration));
+}
+
+void BM_spsc_queue(benchmark::State& state) {
+    nestl::spsc_queue<uint64_t> q;
+    if (!q.init(locked_deque::capacity)) {
+        state.SkipWithError("out of memory");
+        return;
+    }
+    transfer(state, q);
+}
+BENCHMARK(BM_spsc_queue)->Arg(1)->Arg(8)->Arg(64)->UseRealTime();
+
+void BM_locked_deque(benchmark::State& state) {
+    locked_deque q;
+    transfer(state, q);
+}
+BENCHMARK(BM_locked_deque)->Arg(1)->Arg(8)->Arg(64)->UseRealTime();
+
+// cost of the operations themselves, without cross-core traffic
+template <typename Queue>
+void push_pop(benchmark::State& state, Queue& q) {
+    auto batch = static_cast<size_t>(state.range(0));
+    uint64_t items[64] = {};
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(q.push_n(items, batch));
+        benchmark::DoNotOptimize(q.pop_n(items, batch));
+    }
+    state.SetItemsProcessed(state.iterations()
+                            * static_cast<int64_t>(batch));
+}
+
+void BM_spsc_queue_one_thread(benchmark::State& state) {
+    nestl::spsc_queue<uint64_t> q;
+    if (!q.init(locked_deque::capacity)) {
+        state.SkipWithError("out of memory");
+        return;
+    }
+    push_pop(state, q);
+}
+BENCHMARK(BM_spsc_queue_one_thread)->Arg(1)->Arg(8)->Arg(64);
+
+void BM_locked_deque_one_thread(benchmark::State& state) {
+    locked_deque q;
+    push_pop(state, q);
+}
+BENCHMARK(BM_locked_deque_one_thread)->Arg(1)->Arg(8)->Arg(64);
+
+}  // namespace
@@ -0,0 +1,182 @@
+//
+// Copyright 2018 Marcin Radomski. All rights reserved.
+//
+// Licensed under the MIT license. See LICENSE file in the project root for
+// details.
+//
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+#include <cstdint>
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <nestl/caching_allocator.hpp>
+#include <nestl/thread_pool.hpp>
+
+namespace {
+
+/*
+ * Pool of the usual shape: one mutex-guarded queue of std::functions, and
+ * std::packaged_task/std::future for results.
+ */
+class locked_pool {
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::deque<std::function<void()>> m_tasks;
+    std::vector<std::thread> m_threads;
+    bool m_stopping = false;
+
+    void worker_main() {
+        for (;;) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock{m_mutex};
+                m_cv.wait(lock,
+                          [this] { return m_stopping || !m_tasks.empty(); });
+                if (m_tasks.empty()) {
+                    return;
+                }
+                task = std::move(m_tasks.front());
+                m_tasks.pop_front();
+            }
+            task();
+        }
+    }
+
+public:
+    explicit locked_pool(size_t threads) {
+        for (size_t i = 0; i < threads; ++i) {
+            m_threads.emplace_back([this] { worker_main(); });
+        }
+    }
+
+    ~locked_pool() {
+        {
+            std::lock_guard<std::mutex> lock{m_mutex};
+            m_stopping = true;
+        }
+        m_cv.notify_all();
+        for (auto& thread : m_threads) {
+            thread.join();
+        }
+    }
+
+    template <typename F>
+    auto submit(F f) {
+        using R = decltype(f());
+        auto task = std::make_shared<std::packaged_task<R()>>(std::move(f));
+        std::future<R> result = task->get_future();
+        {
+            std::lock_guard<std::mutex> lock{m_mutex};
+            m_tasks.emplace_back([task] { (*task)(); });
+        }
+        m_cv.notify_one();
+        return result;
+    }
+};
+
+constexpr size_t tasks_per_iteration = 1024;
+
+struct square {
+    uint64_t i;
+
+    uint64_t operator()() const noexcept { return i * i; }
+};
+
+// submits a batch of tiny tasks from outside the pool and waits for them
+template <typename Pool>
+void submit_batch(benchmark::State& state, Pool& pool) {
+    using future_t = decltype(pool.submit(square{0}));
+    std::vector<future_t> futures;
+    futures.reserve(tasks_per_iteration);
+
+    for (auto _ : state) {
+        for (uint64_t i = 0; i < tasks_per_iteration; ++i) {
+            futures.push_back(pool.submit(square{i}));
+        }
+        uint64_t sum = 0;
+        for (auto& f : futures) {
+            sum += f.get();
+        }
+        futures.clear();
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations()
+                            * static_cast<int64_t>(tasks_per_iteration));
+}
+
+// adapts nestl::thread_pool::submit to return the future directly
+template <typename Allocator>
+struct nestl_pool {
+    nestl::thread_pool<Allocator> pool;
+
+    template <typename F>
+    auto submit(F f) {
+        return std::move(pool.submit(std::move(f)).ok());
+    }
+};
+
+template <typename Allocator>
+void BM_thread_pool_submit(benchmark::State& state) {
+    nestl_pool<Allocator> p;
+    if (!p.pool.start(static_cast<size_t>(state.range(0)))) {
+        state.SkipWithError("out of memory");
+        return;
+    }
+    submit_batch(state, p);
+}
+BENCHMARK_TEMPLATE(BM_thread_pool_submit, nestl::system_allocator)
+    ->Arg(1)
+    ->Arg(4)
+    ->UseRealTime();
+BENCHMARK_TEMPLATE(BM_thread_pool_submit, nestl::caching_allocator<>)
+    ->Arg(1)
+    ->Arg(4)
+    ->UseRealTime();
+
+void BM_locked_pool_submit(benchmark::State& state) {
+    locked_pool pool{static_cast<size_t>(state.range(0))};
+    submit_batch(state, pool);
+}
+BENCHMARK(BM_locked_pool_submit)->Arg(1)->Arg(4)->UseRealTime();
+
+// recursive fork-join: each task splits its range and waits for one half
+template <typename Pool>
+uint64_t fork_join_sum(Pool& pool, uint64_t first, uint64_t last) {
+    if (last - first <= 1024) {
+        uint64_t sum = 0;
+        for (uint64_t i = first; i < last; ++i) {
+            sum += i * i;
+        }
+        return sum;
+    }
+
+    uint64_t mid = first + (last - first) / 2;
+    auto right = pool.submit(
+        [&pool, mid, last] { return fork_join_sum(pool, mid, last); });
+    return fork_join_sum(pool, first, mid) + right.ok().get();
+}
+
+void BM_thread_pool_fork_join(benchmark::State& state) {
+    nestl::thread_pool<nestl::caching_allocator<>> pool;
+    if (!pool.start(static_cast<size_t>(state.range(0)))) {
+        state.SkipWithError("out of memory");
+        return;
+    }
+    for (auto _ : state) {
+        auto sum = pool.submit(
+            [&pool] { return fork_join_sum(pool, 0, uint64_t{1} << 20); });
+        benchmark::DoNotOptimize(sum.ok().get());
+    }
+    state.SetItemsProcessed(state.iterations() * (int64_t{1} << 20));
+}
+BENCHMARK(BM_thread_pool_fork_join)->Arg(1)->Arg(4)->UseRealTime();
+
+}  // namespace
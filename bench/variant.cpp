@@ -0,0 +1,277 @@
+//
+// Copyright 2018 Marcin Radomski. All rights reserved.
+//
+// Licensed under the MIT license. See LICENSE file in the project root for
+// details.
+//
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+#include <cstdint>
+
+#include <iterator>
+#include <limits>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+#include <nestl/utility.hpp>
+#include <nestl/variant.hpp>
+#include <nestl/vector.hpp>
+
+#include <nestl/detail/storage.hpp>
+
+namespace {
+
+constexpr size_t num_variants = 1024;
+
+uint64_t sink = 0;
+
+/*
+ * Alternatives of different sizes, with non-trivial move and destructor, so
+ * that the compiler cannot merge them into a single code path.
+ */
+template <size_t I>
+struct alternative {
+    uint64_t values[I % 4 + 1];
+
+    explicit alternative(uint64_t v) noexcept {
+        for (uint64_t& value : values) {
+            value = v;
+        }
+    }
+
+    alternative(alternative&& src) noexcept {
+        for (size_t i = 0; i < std::size(values); ++i) {
+            values[i] = src.values[i] * (I + 1);
+        }
+    }
+
+    // std::variant needs it for its move assignment
+    alternative& operator=(alternative&& src) noexcept {
+        for (size_t i = 0; i < std::size(values); ++i) {
+            values[i] = src.values[i] * (I + 1);
+        }
+        return *this;
+    }
+
+    uint64_t sum() const noexcept {
+        uint64_t sum = 0;
+        for (uint64_t value : values) {
+            sum += value;
+        }
+        return sum;
+    }
+
+    ~alternative() noexcept {
+        for (uint64_t value : values) {
+            sink ^= value;
+        }
+    }
+};
+
+/*
+ * Reference implementation dispatching the way variant_base used to: by
+ * walking the type list and comparing the index against each alternative.
+ */
+template <typename... Ts>
+class linear_variant {
+    uint8_t m_current;
+    nestl::detail::storage<Ts...> m_storage;
+
+    template <uint8_t N, typename T, typename... Rest>
+    void destruct() noexcept {
+        if (m_current == N) {
+            m_storage.template destroy<T>();
+        } else {
+            destruct<N + 1, Rest...>();
+        }
+    }
+
+    template <uint8_t>
+    void destruct() noexcept {}
+
+    template <uint8_t N, typename T, typename... Rest>
+    void move_from(linear_variant& src) noexcept {
+        if (src.m_current == N) {
+            new (m_storage.data) T(std::move(src.m_storage.template as<T>()));
+            m_current = N;
+            src.destruct<0, Ts...>();
+            src.m_current = std::numeric_limits<uint8_t>::max();
+        } else {
+            move_from<N + 1, Rest...>(src);
+        }
+    }
+
+    template <uint8_t>
+    void move_from(linear_variant&) noexcept {}
+
+public:
+    template <typename T>
+    linear_variant(nestl::tag<T> tag, uint64_t value) noexcept
+        : m_current(static_cast<uint8_t>(nestl::type_index<T, Ts...>)),
+          m_storage(tag, value) {}
+
+    linear_variant(linear_variant&& src) noexcept
+        : m_current(std::numeric_limits<uint8_t>::max()) {
+        move_from<0, Ts...>(src);
+    }
+
+    linear_variant& operator=(linear_variant&& src) noexcept {
+        if (this != &src) {
+            destruct<0, Ts...>();
+            m_current = std::numeric_limits<uint8_t>::max();
+            move_from<0, Ts...>(src);
+        }
+        return *this;
+    }
+
+    ~linear_variant() noexcept { destruct<0, Ts...>(); }
+};
+
+template <typename Seq>
+struct variants_of;
+
+template <size_t... Is>
+struct variants_of<std::index_sequence<Is...>> {
+    using table = nestl::variant<alternative<Is>...>;
+    using linear = linear_variant<alternative<Is>...>;
+    using std_variant = std::variant<alternative<Is>...>;
+
+    template <typename V, size_t I>
+    static V make(uint64_t value) noexcept {
+        if constexpr (std::is_same_v<V, std_variant>) {
+            return V{std::in_place_type<alternative<I>>, value};
+        } else {
+            return V{nestl::tag<alternative<I>>{}, value};
+        }
+    }
+
+    // variants holding alternatives picked at random
+    template <typename V>
+    static nestl::vector<V> make_random() noexcept {
+        using make_fn = V (*)(uint64_t) noexcept;
+        static constexpr make_fn makers[] = {&make<V, Is>...};
+
+        nestl::vector<V> variants;
+        (void)variants.reserve(num_variants);
+        uint32_t rng = 2463534242u;
+        for (size_t i = 0; i < num_variants; ++i) {
+            rng ^= rng << 13;
+            rng ^= rng >> 17;
+            rng ^= rng << 5;
+            (void)variants.push_back(makers[rng % sizeof...(Is)](i));
+        }
+        return variants;
+    }
+
+    // what a visitor has to look like without visit()
+    static uint64_t get_chain(const table& v) noexcept {
+        uint64_t value = 0;
+        (void)([&] {
+            if (auto res = v.template get<alternative<Is>>()) {
+                value = res.ok().get().sum();
+                return true;
+            }
+            return false;
+        }() || ...);
+        return value;
+    }
+};
+
+// every iteration moves each variant out and back, destroying both sources
+template <typename V>
+void move_around(benchmark::State& state, nestl::vector<V>& variants) {
+    for (auto _ : state) {
+        for (V& v : variants) {
+            V tmp{std::move(v)};
+            v = std::move(tmp);
+        }
+        benchmark::DoNotOptimize(sink);
+    }
+    state.SetItemsProcessed(state.iterations()
+                            * static_cast<int64_t>(variants.size()));
+}
+
+template <size_t N>
+void BM_variant_dispatch(benchmark::State& state) {
+    using variants = variants_of<std::make_index_sequence<N>>;
+    auto v = variants::template make_random<typename variants::table>();
+    move_around(state, v);
+}
+BENCHMARK_TEMPLATE(BM_variant_dispatch, 2);
+BENCHMARK_TEMPLATE(BM_variant_dispatch, 8);
+BENCHMARK_TEMPLATE(BM_variant_dispatch, 32);
+
+template <size_t N>
+void BM_linear_dispatch(benchmark::State& state) {
+    using variants = variants_of<std::make_index_sequence<N>>;
+    auto v = variants::template make_random<typename variants::linear>();
+    move_around(state, v);
+}
+BENCHMARK_TEMPLATE(BM_linear_dispatch, 2);
+BENCHMARK_TEMPLATE(BM_linear_dispatch, 8);
+BENCHMARK_TEMPLATE(BM_linear_dispatch, 32);
+
+template <size_t N>
+void BM_std_variant_dispatch(benchmark::State& state) {
+    using variants = variants_of<std::make_index_sequence<N>>;
+    auto v = variants::template make_random<typename variants::std_variant>();
+    move_around(state, v);
+}
+BENCHMARK_TEMPLATE(BM_std_variant_dispatch, 2);
+BENCHMARK_TEMPLATE(BM_std_variant_dispatch, 8);
+BENCHMARK_TEMPLATE(BM_std_variant_dispatch, 32);
+
+template <size_t N>
+void BM_visit(benchmark::State& state) {
+    using variants = variants_of<std::make_index_sequence<N>>;
+    auto v = variants::template make_random<typename variants::table>();
+    for (auto _ : state) {
+        for (const auto& e : v) {
+            benchmark::DoNotOptimize(nestl::visit(
+                [](const auto& a) noexcept { return a.sum(); }, e));
+        }
+    }
+    state.SetItemsProcessed(state.iterations()
+                            * static_cast<int64_t>(v.size()));
+}
+BENCHMARK_TEMPLATE(BM_visit, 2);
+BENCHMARK_TEMPLATE(BM_visit, 8);
+BENCHMARK_TEMPLATE(BM_visit, 32);
+
+template <size_t N>
+void BM_std_visit(benchmark::State& state) {
+    using variants = variants_of<std::make_index_sequence<N>>;
+    auto v = variants::template make_random<typename variants::std_variant>();
+    for (auto _ : state) {
+        for (const auto& e : v) {
+            benchmark::DoNotOptimize(
+                std::visit([](const auto& a) noexcept { return a.sum(); }, e));
+        }
+    }
+    state.SetItemsProcessed(state.iterations()
+                            * static_cast<int64_t>(v.size()));
+}
+BENCHMARK_TEMPLATE(BM_std_visit, 2);
+BENCHMARK_TEMPLATE(BM_std_visit, 8);
+BENCHMARK_TEMPLATE(BM_std_visit, 32);
+
+template <size_t N>
+void BM_get_chain(benchmark::State& state) {
+    using variants = variants_of<std::make_index_sequence<N>>;
+    auto v = variants::template make_random<typename variants::table>();
+    for (auto _ : state) {
+        for (const auto& e : v) {
+            benchmark::DoNotOptimize(variants::get_chain(e));
+        }
+    }
+    state.SetItemsProcessed(state.iterations()
+                            * static_cast<int64_t>(v.size()));
+}
+BENCHMARK_TEMPLATE(BM_get_chain, 2);
+BENCHMARK_TEMPLATE(BM_get_chain, 8);
+BENCHMARK_TEMPLATE(BM_get_chain, 32);
+
+}  // namespace
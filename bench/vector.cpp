@@ -0,0 +1,180 @@
+//
+// Copyright 2018 Marcin Radomski. All rights reserved.
+//
+// Licensed under the MIT license. See LICENSE file in the project root for
+// details.
+//
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+#include <cstdint>
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include <nestl/vector.hpp>
+
+namespace {
+
+/*
+ * nestl::vector and std::vector differ in how they report allocation
+ * failures; these wrappers give both the same interface.
+ */
+template <typename T>
+struct nestl_vector {
+    nestl::vector<T> v;
+
+    void push_back(const T& e) { benchmark::DoNotOptimize(v.push_back(e)); }
+    void insert_middle(const T& e) {
+        benchmark::DoNotOptimize(v.insert(v.begin() + v.size() / 2, e));
+    }
+    void erase_middle() { v.erase(v.begin() + v.size() / 2); }
+    nestl::vector<T> copy() const { return std::move(v.copy().ok()); }
+    template <typename Pred>
+    void erase_if(Pred pred) {
+        nestl::erase_if(v, pred);
+    }
+    bool equals(const nestl_vector& o) const { return v == o.v; }
+    bool less(const nestl_vector& o) const { return v < o.v; }
+    const T* find(const T& e) const { return v.find(e); }
+    size_t count(const T& e) const { return v.count(e); }
+    size_t size() const { return v.size(); }
+    T* data() { return v.data(); }
+};
+
+template <typename T>
+struct std_vector {
+    std::vector<T> v;
+
+    void push_back(const T& e) { v.push_back(e); }
+    void insert_middle(const T& e) {
+        v.insert(v.begin() + static_cast<ptrdiff_t>(v.size() / 2), e);
+    }
+    void erase_middle() {
+        v.erase(v.begin() + static_cast<ptrdiff_t>(v.size() / 2));
+    }
+    std::vector<T> copy() const { return v; }
+    template <typename Pred>
+    void erase_if(Pred pred) {
+        v.erase(std::remove_if(v.begin(), v.end(), pred), v.end());
+    }
+    bool equals(const std_vector& o) const { return v == o.v; }
+    bool less(const std_vector& o) const { return v < o.v; }
+    const T* find(const T& e) const {
+        return &*std::find(v.begin(), v.end(), e);
+    }
+    size_t count(const T& e) const {
+        return static_cast<size_t>(std::count(v.begin(), v.end(), e));
+    }
+    size_t size() const { return v.size(); }
+    T* data() { return v.data(); }
+};
+
+template <typename V>
+V make_filled(size_t count) {
+    V v;
+    for (size_t i = 0; i < count; ++i) {
+        v.push_back(static_cast<uint32_t>(i));
+    }
+    return v;
+}
+
+template <typename V>
+void BM_push_back(benchmark::State& state) {
+    auto count = static_cast<size_t>(state.range(0));
+    for (auto _ : state) {
+        V v;
+        for (size_t i = 0; i < count; ++i) {
+            v.push_back(static_cast<uint32_t>(i));
+        }
+        benchmark::DoNotOptimize(v.data());
+    }
+    state.SetItemsProcessed(state.iterations()
+                            * static_cast<int64_t>(count));
+}
+BENCHMARK_TEMPLATE(BM_push_back, nestl_vector<uint32_t>)->Range(8, 1 << 16);
+BENCHMARK_TEMPLATE(BM_push_back, std_vector<uint32_t>)->Range(8, 1 << 16);
+
+// insertion in the middle and erasure of it, so the size stays constant
+template <typename V>
+void BM_insert_erase_middle(benchmark::State& state) {
+    V v = make_filled<V>(static_cast<size_t>(state.range(0)));
+    for (auto _ : state) {
+        v.insert_middle(42);
+        v.erase_middle();
+        benchmark::DoNotOptimize(v.data());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK_TEMPLATE(BM_insert_erase_middle, nestl_vector<uint32_t>)
+    ->Range(8, 1 << 16);
+BENCHMARK_TEMPLATE(BM_insert_erase_middle, std_vector<uint32_t>)
+    ->Range(8, 1 << 16);
+
+template <typename V>
+void BM_copy(benchmark::State& state) {
+    V v = make_filled<V>(static_cast<size_t>(state.range(0)));
+    for (auto _ : state) {
+        auto copy = v.copy();
+        benchmark::DoNotOptimize(copy.data());
+    }
+    state.SetBytesProcessed(state.iterations()
+                            * static_cast<int64_t>(v.size()
+                                                   * sizeof(uint32_t)));
+}
+BENCHMARK_TEMPLATE(BM_copy, nestl_vector<uint32_t>)->Range(8, 1 << 16);
+BENCHMARK_TEMPLATE(BM_copy, std_vector<uint32_t>)->Range(8, 1 << 16);
+
+// drops every 4th element, like a sweep over expired entries
+template <typename V>
+void BM_erase_if(benchmark::State& state) {
+    auto count = static_cast<size_t>(state.range(0));
+    for (auto _ : state) {
+        state.PauseTiming();
+        V v = make_filled<V>(count);
+        state.ResumeTiming();
+        v.erase_if([](uint32_t e) { return e % 4 == 0; });
+        benchmark::DoNotOptimize(v.data());
+    }
+    state.SetItemsProcessed(state.iterations()
+                            * static_cast<int64_t>(count));
+}
+BENCHMARK_TEMPLATE(BM_erase_if, nestl_vector<uint32_t>)->Range(8, 1 << 19);
+BENCHMARK_TEMPLATE(BM_erase_if, std_vector<uint32_t>)->Range(8, 1 << 19);
+
+// keys that differ in the last element only, like near-duplicates in a
+// dedupe pass
+template <typename V>
+void BM_compare(benchmark::State& state) {
+    auto count = static_cast<size_t>(state.range(0));
+    V a = make_filled<V>(count);
+    V b = make_filled<V>(count - 1);
+    b.push_back(0);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(a.equals(b));
+        benchmark::DoNotOptimize(a.less(b));
+    }
+    state.SetItemsProcessed(state.iterations()
+                            * static_cast<int64_t>(2 * count));
+}
+BENCHMARK_TEMPLATE(BM_compare, nestl_vector<uint32_t>)->Range(8, 1 << 16);
+BENCHMARK_TEMPLATE(BM_compare, std_vector<uint32_t>)->Range(8, 1 << 16);
+
+// searches for the last element, then counts it
+template <typename V>
+void BM_find_count(benchmark::State& state) {
+    auto count = static_cast<size_t>(state.range(0));
+    V v = make_filled<V>(count);
+    auto last = static_cast<uint32_t>(count - 1);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(v.find(last));
+        benchmark::DoNotOptimize(v.count(last));
+    }
+    state.SetItemsProcessed(state.iterations()
+                            * static_cast<int64_t>(2 * count));
+}
+BENCHMARK_TEMPLATE(BM_find_count, nestl_vector<uint32_t>)->Range(8, 1 << 16);
+BENCHMARK_TEMPLATE(BM_find_count, std_vector<uint32_t>)->Range(8, 1 << 16);
+
+}  // namespace
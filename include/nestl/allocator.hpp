@@ -11,10 +11,22 @@
 #include <cassert>
 #include <cstdlib>
 
+#include <type_traits>
+#include <utility>
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+#define NESTL_HAS_MALLOC_USABLE_SIZE 1
+#endif
+
 namespace nestl {
 
 class out_of_memory {};
 
+// allocators never return the all-ones address
+template <>
+struct pointer_niche_allowed<out_of_memory> : std::true_type {};
+
 class system_allocator {
 public:
     result<void*, out_of_memory> allocate(size_t size) noexcept {
@@ -40,6 +52,27 @@ public:
     }
 
     void free(void* p) noexcept { ::free(p); }
+
+#if defined(NESTL_HAS_MALLOC_USABLE_SIZE)
+    // malloc often hands out more than requested
+    size_t usable_size(void* p) const noexcept {
+        return ::malloc_usable_size(p);
+    }
+#endif
 };
 
+/*
+ * Allocators may provide size_t usable_size(void* p), returning how many
+ * bytes of the block at p can actually be used. Containers fill that slack
+ * instead of allocating again.
+ */
+template <typename Allocator, typename = void>
+constexpr bool has_usable_size = false;
+
+template <typename Allocator>
+constexpr bool has_usable_size<
+    Allocator, std::void_t<decltype(std::declval<const Allocator&>()
+                                        .usable_size(std::declval<void*>()))>> =
+    true;
+
 }  // namespace nestl
@@ -0,0 +1,240 @@
+//
+// Copyright 2018 Marcin Radomski. All rights reserved.
+//
+// Licensed under the MIT license. See LICENSE file in the project root for
+// details.
+//
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <algorithm>
+
+#include <nestl/allocator.hpp>
+#include <nestl/result.hpp>
+
+namespace nestl {
+
+/*
+ * Monotonic (bump) arena. Allocations are never returned to the backing
+ * allocator one by one - everything is released at once by release() or when
+ * the arena is destroyed.
+ *
+ * Reallocating the most recent allocation grows/shrinks it in place if the
+ * current chunk has enough room left, so a single vector being filled from an
+ * arena never copies its elements.
+ *
+ * An arena constructed over a caller-provided buffer never touches the
+ * backing allocator and reports out_of_memory once the buffer is exhausted.
+ */
+template <typename Backing = system_allocator>
+class arena {
+public:
+    static constexpr size_t alignment = alignof(std::max_align_t);
+    static constexpr size_t default_chunk_size = 64 * 1024;
+
+private:
+    struct chunk {
+        chunk* prev;
+    };
+
+    // every block is preceded by its size, rounded up to alignment
+    static constexpr size_t header_size = alignment;
+    static constexpr size_t chunk_header_size =
+        (sizeof(chunk) + alignment - 1) / alignment * alignment;
+    // largest request whose rounded size, header and chunk header still
+    // fit in a size_t
+    static constexpr size_t max_size = SIZE_MAX - chunk_header_size
+                                       - header_size - alignment;
+
+    Backing m_backing;
+    size_t m_chunk_size;
+    chunk* m_chunks = nullptr;
+    unsigned char* m_buffer = nullptr;
+    unsigned char* m_top = nullptr;
+    unsigned char* m_end = nullptr;
+    unsigned char* m_last = nullptr;
+
+    static size_t round_up(size_t size) noexcept {
+        return (size + alignment - 1) / alignment * alignment;
+    }
+
+    static unsigned char* align_up(unsigned char* p) noexcept {
+        auto addr = reinterpret_cast<uintptr_t>(p);
+        auto aligned = (addr + alignment - 1) / alignment * alignment;
+        return p + (aligned - addr);
+    }
+
+    static size_t& block_size(void* p) noexcept {
+        return *reinterpret_cast<size_t*>(static_cast<unsigned char*>(p)
+                                          - header_size);
+    }
+
+    size_t available() const noexcept {
+        return static_cast<size_t>(m_end - m_top);
+    }
+
+    [[nodiscard]] result<void, out_of_memory> add_chunk(size_t min_size) {
+        if (m_chunk_size == 0) {
+            return {out_of_memory{}};
+        }
+        if (min_size > SIZE_MAX - chunk_header_size) {
+            return {out_of_memory{}};
+        }
+
+        size_t size = chunk_header_size + std::max(m_chunk_size, min_size);
+        if (auto res = m_backing.allocate(size)) {
+            auto* c = static_cast<chunk*>(res.ok());
+            c->prev = m_chunks;
+            m_chunks = c;
+            m_top = reinterpret_cast<unsigned char*>(c) + chunk_header_size;
+            m_end = reinterpret_cast<unsigned char*>(c) + size;
+            m_last = nullptr;
+            return {ok_t{}};
+        } else {
+            return {std::move(res).err()};
+        }
+    }
+
+public:
+    explicit arena(size_t chunk_size = default_chunk_size,
+                   const Backing& backing = Backing()) noexcept
+        : m_backing(backing),
+          m_chunk_size(round_up(chunk_size)) {}
+
+    arena(void* buffer, size_t size) noexcept
+        : m_backing(),
+          m_chunk_size(0),
+          m_buffer(static_cast<unsigned char*>(buffer)) {
+        m_top = std::min(align_up(m_buffer), m_buffer + size);
+        m_end = m_buffer + size;
+    }
+
+    ~arena() noexcept { release(); }
+
+    // allocators refer to the arena by pointer
+    arena(arena&&) = delete;
+    arena& operator=(arena&&) = delete;
+    arena(const arena&) = delete;
+    arena& operator=(const arena&) = delete;
+
+    result<void*, out_of_memory> allocate(size_t size) noexcept {
+        assert(size > 0);
+        if (size > max_size) {
+            return {out_of_memory{}};
+        }
+
+        size_t needed = header_size + round_up(size);
+        if (available() < needed) {
+            if (auto res = add_chunk(needed); !res) {
+                return {res.err()};
+            }
+        }
+
+        unsigned char* p = m_top + header_size;
+        block_size(p) = round_up(size);
+        m_top += needed;
+        m_last = p;
+        return {static_cast<void*>(p)};
+    }
+
+    result<void*, out_of_memory> reallocate(void* p, size_t new_size) noexcept {
+        assert(new_size > 0);
+        if (new_size > max_size) {
+            return {out_of_memory{}};
+        }
+
+        if (!p) {
+            return allocate(new_size);
+        }
+
+        auto* block = static_cast<unsigned char*>(p);
+        size_t old_size = block_size(p);
+        size_t rounded = round_up(new_size);
+        if (p == m_last && rounded <= static_cast<size_t>(m_end - block)) {
+            block_size(p) = rounded;
+            m_top = block + rounded;
+            return {p};
+        } else if (new_size <= old_size) {
+            return {p};
+        }
+
+        if (auto res = allocate(new_size)) {
+            std::memcpy(res.ok(), p, old_size);
+            return {res.ok()};
+        } else {
+            return {std::move(res).err()};
+        }
+    }
+
+    // Only the most recent allocation is actually reclaimed.
+    void free(void* p) noexcept {
+        if (p && p == m_last) {
+            m_top = static_cast<unsigned char*>(p) - header_size;
+            m_last = nullptr;
+        }
+    }
+
+    // Invalidates every pointer handed out by this arena.
+    void release() noexcept {
+        while (m_chunks) {
+            chunk* prev = m_chunks->prev;
+            m_backing.free(m_chunks);
+            m_chunks = prev;
+        }
+
+        if (m_buffer) {
+            m_top = std::min(align_up(m_buffer), m_end);
+        } else {
+            m_top = nullptr;
+            m_end = nullptr;
+        }
+        m_last = nullptr;
+    }
+};
+
+/*
+ * Lightweight handle to an arena, suitable as the Allocator parameter of
+ * nestl containers. The arena must outlive every container using it.
+ */
+template <typename Backing = system_allocator>
+class arena_allocator {
+    arena<Backing>* m_arena = nullptr;
+
+public:
+    arena_allocator() noexcept = default;
+    arena_allocator(arena<Backing>& a) noexcept : m_arena(&a) {}
+
+    result<void*, out_of_memory> allocate(size_t size) noexcept {
+        if (!m_arena) {
+            return {out_of_memory{}};
+        }
+        return m_arena->allocate(size);
+    }
+
+    result<void*, out_of_memory> reallocate(void* p, size_t new_size) noexcept {
+        if (!m_arena) {
+            return {out_of_memory{}};
+        }
+        return m_arena->reallocate(p, new_size);
+    }
+
+    void free(void* p) noexcept {
+        if (m_arena) {
+            m_arena->free(p);
+        }
+    }
+
+    [[nodiscard]] bool operator==(const arena_allocator& other) const noexcept {
+        return m_arena == other.m_arena;
+    }
+
+    [[nodiscard]] bool operator!=(const arena_allocator& other) const noexcept {
+        return !(*this == other);
+    }
+};
+
+}  // namespace nestl
@@ -0,0 +1,247 @@
+//
+// Copyright 2018 Marcin Radomski. All rights reserved.
+//
+// Licensed under the MIT license. See LICENSE file in the project root for
+// details.
+//
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <algorithm>
+#include <type_traits>
+
+#include <nestl/allocator.hpp>
+#include <nestl/result.hpp>
+
+namespace nestl {
+
+/*
+ * Allocator keeping per-thread free lists of small blocks in front of
+ * Backing, so that short-lived containers created and destroyed by many
+ * threads rarely reach the backing allocator and its locks.
+ *
+ * Requests of up to MaxCachedSize bytes are rounded up to a power-of-two
+ * size class. Freed blocks of each class are kept by the freeing thread,
+ * up to MaxBlocksPerClass of them, and the rest go back to Backing. Larger
+ * requests go straight to Backing.
+ *
+ * A block may be freed by a different thread than the one that allocated
+ * it. Backing has to be stateless, since blocks from all instances share
+ * the same caches. A thread's cache is flushed when the thread exits, or
+ * explicitly with flush_thread_cache().
+ */
+template <typename Backing = system_allocator, size_t MaxCachedSize = 1024,
+          size_t MaxBlocksPerClass = 64>
+class caching_allocator {
+    static_assert(std::is_empty_v<Backing>,
+                  "blocks are shared between instances, so Backing must "
+                  "not have state");
+    static_assert(MaxCachedSize >= 16
+                      && (MaxCachedSize & (MaxCachedSize - 1)) == 0,
+                  "MaxCachedSize must be a power of two of at least 16");
+
+public:
+    static constexpr size_t min_block_size = 16;
+    static constexpr size_t max_cached_size = MaxCachedSize;
+    static constexpr size_t max_blocks_per_class = MaxBlocksPerClass;
+
+private:
+    static constexpr size_t num_classes = [] {
+        size_t c = 1;
+        while ((min_block_size << (c - 1)) < MaxCachedSize) {
+            ++c;
+        }
+        return c;
+    }();
+
+    // marks blocks bigger than max_cached_size
+    static constexpr size_t no_class = num_classes;
+
+    struct alignas(std::max_align_t) header {
+        size_t size_class;
+        // usable size of the block
+        size_t size;
+    };
+
+    struct free_block {
+        free_block* next;
+    };
+
+    struct thread_cache {
+        free_block* free[num_classes] = {};
+        size_t count[num_classes] = {};
+
+        thread_cache() noexcept = default;
+        ~thread_cache() noexcept {
+            flush();
+            cache_destroyed() = true;
+        }
+
+        thread_cache(const thread_cache&) = delete;
+        thread_cache& operator=(const thread_cache&) = delete;
+
+        void flush() noexcept {
+            for (size_t c = 0; c < num_classes; ++c) {
+                while (free_block* block = free[c]) {
+                    free[c] = block->next;
+                    Backing{}.free(header_of(block));
+                }
+                count[c] = 0;
+            }
+        }
+    };
+
+    static thread_cache& cache() noexcept {
+        thread_local thread_cache c;
+        return c;
+    }
+
+    /*
+     * Set once the calling thread's cache is destroyed at thread exit.
+     * Destructors of other thread_local objects may still allocate and free
+     * after that, and have to bypass the cache. Trivially destructible, so
+     * it stays valid until the thread is gone.
+     */
+    static bool& cache_destroyed() noexcept {
+        thread_local bool destroyed = false;
+        return destroyed;
+    }
+
+    static header* header_of(void* p) noexcept {
+        return static_cast<header*>(p) - 1;
+    }
+
+    static void* block_of(header* h) noexcept { return h + 1; }
+
+    static size_t size_class(size_t size) noexcept {
+        size_t c = 0;
+        while ((min_block_size << c) < size) {
+            ++c;
+        }
+        return c;
+    }
+
+    static size_t class_size(size_t c) noexcept { return min_block_size << c; }
+
+    [[nodiscard]] static result<void*, out_of_memory> allocate_block(
+        size_t size_class, size_t size) noexcept {
+        auto res = Backing{}.allocate(sizeof(header) + size);
+        if (!res) {
+            return res;
+        }
+
+        auto* h = static_cast<header*>(res.ok());
+        h->size_class = size_class;
+        h->size = size;
+        return {block_of(h)};
+    }
+
+public:
+    result<void*, out_of_memory> allocate(size_t size) noexcept {
+        assert(size > 0);
+
+        if (size > max_cached_size) {
+            return allocate_block(no_class, size);
+        }
+
+        size_t c = size_class(size);
+        if (cache_destroyed()) {
+            return allocate_block(c, class_size(c));
+        }
+
+        thread_cache& tc = cache();
+        if (free_block* block = tc.free[c]) {
+            tc.free[c] = block->next;
+            --tc.count[c];
+            return {static_cast<void*>(block)};
+        }
+        return allocate_block(c, class_size(c));
+    }
+
+    result<void*, out_of_memory> reallocate(void* p, size_t new_size) noexcept {
+        assert(new_size > 0);
+
+        if (!p) {
+            return allocate(new_size);
+        }
+
+        header* h = header_of(p);
+        if (h->size_class == no_class && new_size > max_cached_size) {
+            auto res = Backing{}.reallocate(h, sizeof(header) + new_size);
+            if (!res) {
+                return res;
+            }
+
+            h = static_cast<header*>(res.ok());
+            h->size = new_size;
+            return {block_of(h)};
+        }
+
+        if (new_size <= h->size && h->size_class != no_class) {
+            return {p};
+        }
+
+        auto res = allocate(new_size);
+        if (res) {
+            std::memcpy(res.ok(), p, std::min(h->size, new_size));
+            free(p);
+        }
+        return res;
+    }
+
+    void free(void* p) noexcept {
+        if (!p) {
+            return;
+        }
+
+        header* h = header_of(p);
+        size_t c = h->size_class;
+        if (c != no_class && !cache_destroyed()) {
+            thread_cache& tc = cache();
+            if (tc.count[c] < max_blocks_per_class) {
+                auto* block = static_cast<free_block*>(p);
+                block->next = tc.free[c];
+                tc.free[c] = block;
+                ++tc.count[c];
+                return;
+            }
+        }
+        Backing{}.free(h);
+    }
+
+    size_t usable_size(void* p) const noexcept { return header_of(p)->size; }
+
+    // Returns all blocks cached by the calling thread to Backing.
+    static void flush_thread_cache() noexcept {
+        if (!cache_destroyed()) {
+            cache().flush();
+        }
+    }
+
+    // Number of blocks cached by the calling thread.
+    [[nodiscard]] static size_t thread_cache_size() noexcept {
+        if (cache_destroyed()) {
+            return 0;
+        }
+
+        size_t total = 0;
+        for (size_t count : cache().count) {
+            total += count;
+        }
+        return total;
+    }
+
+    [[nodiscard]] bool operator==(const caching_allocator&) const noexcept {
+        return true;
+    }
+
+    [[nodiscard]] bool operator!=(const caching_allocator&) const noexcept {
+        return false;
+    }
+};
+
+}  // namespace nestl
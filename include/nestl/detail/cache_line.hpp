@@ -0,0 +1,26 @@
+//
+// Copyright 2018 Marcin Radomski. All rights reserved.
+//
+// Licensed under the MIT license. See LICENSE file in the project root for
+// details.
+//
+#pragma once
+
+#include <cstddef>
+
+namespace nestl {
+namespace detail {
+
+/*
+ * Alignment keeping data written by different threads from sharing a cache
+ * line. x86-64 and AArch64 cores prefetch pairs of 64-byte lines, so those
+ * use two lines.
+ */
+#if defined(__x86_64__) || defined(_M_X64) || defined(__aarch64__)
+inline constexpr size_t cache_line_size = 128;
+#else
+inline constexpr size_t cache_line_size = 64;
+#endif
+
+}  // namespace detail
+}  // namespace nestl
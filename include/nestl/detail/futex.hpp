@@ -0,0 +1,73 @@
+//
+// Copyright 2018 Marcin Radomski. All rights reserved.
+//
+// Licensed under the MIT license. See LICENSE file in the project root for
+// details.
+//
+#pragma once
+
+#include <cstdint>
+
+#include <atomic>
+#include <thread>
+
+#if defined(__cpp_lib_atomic_wait)
+#define NESTL_FUTEX_ATOMIC_WAIT 1
+#elif defined(__linux__)
+#define NESTL_FUTEX_LINUX 1
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace nestl {
+namespace detail {
+
+/*
+ * Blocks the calling thread while word == expected, until futex_wake() is
+ * called on word. May return spuriously, so callers have to recheck their
+ * condition.
+ *
+ * Uses std::atomic::wait where available, the futex syscall on Linux, and
+ * falls back to yielding elsewhere.
+ */
+inline void futex_wait(std::atomic<uint32_t>& word,
+                       uint32_t expected) noexcept {
+#if defined(NESTL_FUTEX_ATOMIC_WAIT)
+    word.wait(expected, std::memory_order_acquire);
+#elif defined(NESTL_FUTEX_LINUX)
+    static_assert(sizeof(word) == sizeof(uint32_t));
+    // EAGAIN if word != expected already, EINTR on signals
+    (void)::syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word),
+                    FUTEX_WAIT_PRIVATE, expected, nullptr, nullptr, 0);
+#else
+    if (word.load(std::memory_order_acquire) == expected) {
+        std::this_thread::yield();
+    }
+#endif
+}
+
+inline void futex_wake_one(std::atomic<uint32_t>& word) noexcept {
+#if defined(NESTL_FUTEX_ATOMIC_WAIT)
+    word.notify_one();
+#elif defined(NESTL_FUTEX_LINUX)
+    (void)::syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word),
+                    FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
+#else
+    (void)word;
+#endif
+}
+
+inline void futex_wake_all(std::atomic<uint32_t>& word) noexcept {
+#if defined(NESTL_FUTEX_ATOMIC_WAIT)
+    word.notify_all();
+#elif defined(NESTL_FUTEX_LINUX)
+    (void)::syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word),
+                    FUTEX_WAKE_PRIVATE, INT32_MAX, nullptr, nullptr, 0);
+#else
+    (void)word;
+#endif
+}
+
+}  // namespace detail
+}  // namespace nestl
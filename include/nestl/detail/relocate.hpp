@@ -0,0 +1,100 @@
+//
+// Copyright 2018 Marcin Radomski. All rights reserved.
+//
+// Licensed under the MIT license. See LICENSE file in the project root for
+// details.
+//
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include <nestl/utility.hpp>
+
+namespace nestl {
+namespace detail {
+
+/*
+ * Moves objects from [first, last) into raw memory starting at dst, leaving
+ * [first, last) as raw memory. Ranges may overlap.
+ */
+template <typename T>
+void relocate(T* first, T* last, T* dst) noexcept {
+    if (first == dst || first == last) {
+        return;
+    }
+
+    if constexpr (is_trivially_relocatable_v<T>) {
+        std::memmove(static_cast<void*>(dst), static_cast<const void*>(first),
+                     static_cast<size_t>(last - first) * sizeof(T));
+    } else if (dst < first) {
+        for (; first != last; ++first, ++dst) {
+            new (dst) T(std::move(*first));
+            first->~T();
+        }
+    } else {
+        T* d_last = dst + (last - first);
+        while (last != first) {
+            --last;
+            --d_last;
+            new (d_last) T(std::move(*last));
+            last->~T();
+        }
+    }
+}
+
+/*
+ * Copy-constructs objects from [first, last) into raw memory starting at dst.
+ * Ranges must not overlap.
+ */
+template <typename T>
+void copy_construct(const T* first, const T* last, T* dst) noexcept {
+    if constexpr (std::is_trivially_copyable_v<T>) {
+        if (first != last) {
+            std::memcpy(static_cast<void*>(dst),
+                        static_cast<const void*>(first),
+                        static_cast<size_t>(last - first) * sizeof(T));
+        }
+    } else {
+        for (; first != last; ++first, ++dst) {
+            new (dst) T(*first);
+        }
+    }
+}
+
+template <typename T>
+void destroy(T* first, T* last) noexcept {
+    if constexpr (!std::is_trivially_destructible_v<T>) {
+        for (; first != last; ++first) {
+            first->~T();
+        }
+    }
+}
+
+/*
+ * Destroys objects from [first, last) matching pred and relocates the rest
+ * towards first, preserving their order, in a single pass. Returns the new
+ * end of the range.
+ */
+template <typename T, typename Pred>
+T* relocate_remove_if(T* first, T* last, Pred& pred) noexcept {
+    T* dst = first;
+    for (; first != last; ++first) {
+        if (pred(*first)) {
+            first->~T();
+        } else {
+            // one object at a time: a fixed-size copy is cheaper than
+            // memmove calls on the short runs between erased objects
+            relocate(first, first + 1, dst);
+            ++dst;
+        }
+    }
+    return dst;
+}
+
+}  // namespace detail
+}  // namespace nestl
@@ -0,0 +1,401 @@
+//
+// Copyright 2018 Marcin Radomski. All rights reserved.
+//
+// Licensed under the MIT license. See LICENSE file in the project root for
+// details.
+//
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <algorithm>
+#include <type_traits>
+
+#if !defined(NESTL_DISABLE_SIMD) && defined(__SSE2__)
+#define NESTL_SIMD_SSE2 1
+#include <emmintrin.h>
+#if defined(__AVX2__)
+#define NESTL_SIMD_AVX2 1
+#include <immintrin.h>
+#elif defined(__GNUC__)
+// AVX2 kernels compiled separately, picked at runtime
+#define NESTL_SIMD_AVX2_DISPATCH 1
+#include <immintrin.h>
+#endif
+#elif !defined(NESTL_DISABLE_SIMD) && defined(__ARM_NEON) \
+    && defined(__aarch64__)
+#define NESTL_SIMD_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace nestl {
+namespace detail {
+
+/*
+ * Types whose == is equivalent to comparing object representations, so
+ * that ranges of them can be compared and searched as bytes.
+ */
+template <typename T>
+inline constexpr bool is_bitwise_comparable_v =
+    (std::is_integral_v<T> || std::is_pointer_v<T>)
+    && (sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4
+        || sizeof(T) == 8);
+
+/*
+ * Types whose < is equivalent to memcmp() on their object representation.
+ */
+template <typename T>
+inline constexpr bool is_byte_ordered_v =
+    sizeof(T) == 1
+    && ((std::is_integral_v<T> && std::is_unsigned_v<T>)
+        || std::is_same_v<T, std::byte>);
+
+/*
+ * A block is a number of bytes compared at once. equal() returns a mask
+ * with bits_per_byte bits set for every pair of equal bytes, in address
+ * order starting from the lowest bit.
+ */
+#if defined(NESTL_SIMD_AVX2) || defined(NESTL_SIMD_AVX2_DISPATCH)
+
+struct avx2_block {
+    static constexpr size_t width = 32;
+    static constexpr unsigned bits_per_byte = 1;
+    // every AVX2 CPU has it, the kernels are compiled with it enabled
+    static constexpr bool has_popcnt = true;
+
+    [[gnu::target("avx2")]] static uint64_t equal(
+        const unsigned char* a, const unsigned char* b) noexcept {
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a));
+        __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b));
+        return static_cast<uint32_t>(
+            _mm256_movemask_epi8(_mm256_cmpeq_epi8(x, y)));
+    }
+};
+
+#endif
+
+#if defined(NESTL_SIMD_SSE2)
+
+struct sse2_block {
+    static constexpr size_t width = 16;
+    static constexpr unsigned bits_per_byte = 1;
+    static constexpr bool has_popcnt = false;
+
+    static uint64_t equal(const unsigned char* a,
+                          const unsigned char* b) noexcept {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a));
+        __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b));
+        return static_cast<uint32_t>(
+            _mm_movemask_epi8(_mm_cmpeq_epi8(x, y)));
+    }
+};
+
+#elif defined(NESTL_SIMD_NEON)
+
+struct neon_block {
+    static constexpr size_t width = 16;
+    static constexpr unsigned bits_per_byte = 4;
+    static constexpr bool has_popcnt = false;
+
+    // narrows the 0x00/0xff compare result to a nibble per byte
+    static uint64_t equal(const unsigned char* a,
+                          const unsigned char* b) noexcept {
+        uint8x16_t eq = vceqq_u8(vld1q_u8(a), vld1q_u8(b));
+        uint8x8_t nibbles = vshrn_n_u16(vreinterpretq_u16_u8(eq), 4);
+        return vget_lane_u64(vreinterpret_u64_u8(nibbles), 0);
+    }
+};
+
+#endif
+
+/*
+ * SWAR fallback comparing 8 bytes packed in an uint64_t.
+ */
+struct swar_block {
+    static constexpr size_t width = 8;
+    static constexpr unsigned bits_per_byte = 8;
+    static constexpr bool has_popcnt = false;
+
+    static uint64_t equal(const unsigned char* a,
+                          const unsigned char* b) noexcept {
+        constexpr uint64_t lows = 0x7f7f7f7f7f7f7f7full;
+        uint64_t x;
+        uint64_t y;
+        std::memcpy(&x, a, sizeof(x));
+        std::memcpy(&y, b, sizeof(y));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        x = __builtin_bswap64(x);
+        y = __builtin_bswap64(y);
+#endif
+        // exact: the high bit of every byte of x ^ y that is zero
+        uint64_t diff = x ^ y;
+        uint64_t zero = ~(((diff & lows) + lows) | diff | lows);
+        return (zero >> 7) * 0xff;
+    }
+};
+
+// AVX2, where available, is only used through the wrappers below
+#if defined(NESTL_SIMD_SSE2)
+using native_block = sse2_block;
+#elif defined(NESTL_SIMD_NEON)
+using native_block = neon_block;
+#else
+using native_block = swar_block;
+#endif
+
+template <typename Block>
+constexpr uint64_t block_mask() noexcept {
+    constexpr unsigned bits = Block::width * Block::bits_per_byte;
+    return bits == 64 ? ~uint64_t{0} : (uint64_t{1} << bits) - 1;
+}
+
+/*
+ * Reduces a mask of equal bytes to the lowest bit of every Size-byte
+ * element whose bytes are all equal.
+ */
+template <typename Block, size_t Size>
+uint64_t element_mask(uint64_t bytes) noexcept {
+    constexpr unsigned bits = Block::bits_per_byte * Size;
+    for (unsigned shift = 1; shift < bits; shift *= 2) {
+        bytes &= bytes >> shift;
+    }
+    if constexpr (bits == 64) {
+        return bytes & 1;
+    } else {
+        return bytes & (~uint64_t{0} / ((uint64_t{1} << bits) - 1));
+    }
+}
+
+// baseline x86-64 has no popcnt, and __builtin_popcountll becomes a call
+template <typename Block>
+size_t popcount(uint64_t x) noexcept {
+#if (defined(__x86_64__) || defined(__i386__)) && !defined(__POPCNT__)
+    if constexpr (Block::has_popcnt) {
+        return static_cast<size_t>(__builtin_popcountll(x));
+    }
+    x -= (x >> 1) & 0x5555555555555555ull;
+    x = (x & 0x3333333333333333ull) + ((x >> 2) & 0x3333333333333333ull);
+    x = (x + (x >> 4)) & 0x0f0f0f0f0f0f0f0full;
+    return static_cast<size_t>((x * 0x0101010101010101ull) >> 56);
+#else
+    return static_cast<size_t>(__builtin_popcountll(x));
+#endif
+}
+
+template <typename Block>
+size_t mismatch_bytes_with(const unsigned char* a, const unsigned char* b,
+                           size_t size) noexcept {
+    size_t i = 0;
+    for (; i + Block::width <= size; i += Block::width) {
+        uint64_t diff = ~Block::equal(a + i, b + i) & block_mask<Block>();
+        if (diff != 0) {
+            return i + static_cast<size_t>(__builtin_ctzll(diff))
+                           / Block::bits_per_byte;
+        }
+    }
+    for (; i < size && a[i] == b[i]; ++i) {
+    }
+    return i;
+}
+
+// Block::width bytes of value, repeated
+template <typename Block, typename T>
+struct splat {
+    alignas(16) unsigned char bytes[Block::width];
+
+    explicit splat(const T& value) noexcept {
+        for (size_t i = 0; i < Block::width; i += sizeof(T)) {
+            std::memcpy(bytes + i, &value, sizeof(T));
+        }
+    }
+};
+
+template <typename Block, typename T>
+size_t find_with(const T* data, size_t size, const T& value) noexcept {
+    constexpr size_t per_block = Block::width / sizeof(T);
+    constexpr unsigned bits = Block::bits_per_byte * sizeof(T);
+    const auto* bytes = reinterpret_cast<const unsigned char*>(data);
+
+    const splat<Block, T> pattern{value};
+    size_t i = 0;
+    for (; i + per_block <= size; i += per_block) {
+        uint64_t found = element_mask<Block, sizeof(T)>(
+            Block::equal(bytes + i * sizeof(T), pattern.bytes));
+        if (found != 0) {
+            return i + static_cast<size_t>(__builtin_ctzll(found)) / bits;
+        }
+    }
+    return static_cast<size_t>(std::find(data + i, data + size, value)
+                               - data);
+}
+
+template <typename Block, typename T>
+size_t count_with(const T* data, size_t size, const T& value) noexcept {
+    constexpr size_t per_block = Block::width / sizeof(T);
+    const auto* bytes = reinterpret_cast<const unsigned char*>(data);
+
+    const splat<Block, T> pattern{value};
+    size_t count = 0;
+    size_t i = 0;
+    for (; i + per_block <= size; i += per_block) {
+        count += popcount<Block>(element_mask<Block, sizeof(T)>(
+            Block::equal(bytes + i * sizeof(T), pattern.bytes)));
+    }
+    return count + static_cast<size_t>(std::count(data + i, data + size,
+                                                  value));
+}
+
+#if defined(NESTL_SIMD_AVX2)
+
+constexpr bool has_avx2() noexcept { return true; }
+
+#elif defined(NESTL_SIMD_AVX2_DISPATCH)
+
+inline bool has_avx2() noexcept {
+    static const bool supported = [] {
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2") != 0;
+    }();
+    return supported;
+}
+
+#endif
+
+#if defined(NESTL_SIMD_AVX2) || defined(NESTL_SIMD_AVX2_DISPATCH)
+
+// flatten inlines the generic loop and avx2_block::equal into a function
+// compiled for AVX2, which is the only place their intrinsics may appear
+[[gnu::target("avx2"), gnu::flatten]] inline size_t mismatch_bytes_avx2(
+    const unsigned char* a, const unsigned char* b, size_t size) noexcept {
+    return mismatch_bytes_with<avx2_block>(a, b, size);
+}
+
+template <typename T>
+[[gnu::target("avx2"), gnu::flatten]] size_t find_avx2(
+    const T* data, size_t size, const T& value) noexcept {
+    return find_with<avx2_block>(data, size, value);
+}
+
+template <typename T>
+[[gnu::target("avx2,popcnt"), gnu::flatten]] size_t count_avx2(
+    const T* data, size_t size, const T& value) noexcept {
+    return count_with<avx2_block>(data, size, value);
+}
+
+// shorter ranges do not fill a single AVX2 block
+inline constexpr size_t avx2_min_bytes = avx2_block::width;
+
+#endif
+
+/*
+ * Index of the first element that differs between [a, a + size) and
+ * [b, b + size), or size if there is none.
+ */
+template <typename T>
+size_t simd_mismatch(const T* a, const T* b, size_t size) noexcept {
+    static_assert(is_bitwise_comparable_v<T>);
+    const auto* x = reinterpret_cast<const unsigned char*>(a);
+    const auto* y = reinterpret_cast<const unsigned char*>(b);
+    size_t bytes = size * sizeof(T);
+#if defined(NESTL_SIMD_AVX2) || defined(NESTL_SIMD_AVX2_DISPATCH)
+    if (bytes >= avx2_min_bytes && has_avx2()) {
+        return mismatch_bytes_avx2(x, y, bytes) / sizeof(T);
+    }
+#endif
+    return mismatch_bytes_with<native_block>(x, y, bytes) / sizeof(T);
+}
+
+/*
+ * Index of the first element of [data, data + size) equal to value, or
+ * size if there is none.
+ */
+template <typename T>
+size_t simd_find(const T* data, size_t size, const T& value) noexcept {
+    static_assert(is_bitwise_comparable_v<T>);
+#if defined(NESTL_SIMD_AVX2) || defined(NESTL_SIMD_AVX2_DISPATCH)
+    if (size * sizeof(T) >= avx2_min_bytes && has_avx2()) {
+        return find_avx2(data, size, value);
+    }
+#endif
+    return find_with<native_block>(data, size, value);
+}
+
+/*
+ * Number of elements of [data, data + size) equal to value.
+ */
+template <typename T>
+size_t simd_count(const T* data, size_t size, const T& value) noexcept {
+    static_assert(is_bitwise_comparable_v<T>);
+#if defined(NESTL_SIMD_AVX2) || defined(NESTL_SIMD_AVX2_DISPATCH)
+    if (size * sizeof(T) >= avx2_min_bytes && has_avx2()) {
+        return count_avx2(data, size, value);
+    }
+#endif
+    return count_with<native_block>(data, size, value);
+}
+
+/*
+ * Shared implementation of ==, compare(), find() and count() for
+ * contiguous containers: bitwise comparable element types go through the
+ * kernels above, others through the std algorithms.
+ */
+template <typename T>
+bool ranges_equal(const T* a, size_t a_size, const T* b,
+                  size_t b_size) noexcept {
+    if (a_size != b_size) {
+        return false;
+    }
+    if constexpr (is_bitwise_comparable_v<T>) {
+        return a_size == 0 || std::memcmp(a, b, a_size * sizeof(T)) == 0;
+    } else {
+        return std::equal(a, a + a_size, b);
+    }
+}
+
+// < 0, 0 or > 0, as the first range is less, equal or greater
+template <typename T>
+int ranges_compare(const T* a, size_t a_size, const T* b,
+                   size_t b_size) noexcept {
+    size_t common = std::min(a_size, b_size);
+    size_t i;
+    if constexpr (is_byte_ordered_v<T>) {
+        int order = common == 0 ? 0 : std::memcmp(a, b, common);
+        if (order != 0) {
+            return order;
+        }
+        i = common;
+    } else if constexpr (is_bitwise_comparable_v<T>) {
+        i = simd_mismatch(a, b, common);
+    } else {
+        i = static_cast<size_t>(std::mismatch(a, a + common, b).first - a);
+    }
+
+    if (i < common) {
+        return a[i] < b[i] ? -1 : 1;
+    }
+    return a_size < b_size ? -1 : (a_size == b_size ? 0 : 1);
+}
+
+template <typename T>
+size_t range_find(const T* data, size_t size, const T& value) noexcept {
+    if constexpr (is_bitwise_comparable_v<T>) {
+        return simd_find(data, size, value);
+    } else {
+        return static_cast<size_t>(std::find(data, data + size, value)
+                                   - data);
+    }
+}
+
+template <typename T>
+size_t range_count(const T* data, size_t size, const T& value) noexcept {
+    if constexpr (is_bitwise_comparable_v<T>) {
+        return simd_count(data, size, value);
+    } else {
+        return static_cast<size_t>(std::count(data, data + size, value));
+    }
+}
+
+}  // namespace detail
+}  // namespace nestl
@@ -0,0 +1,38 @@
+//
+// Copyright 2018 Marcin Radomski. All rights reserved.
+//
+// Licensed under the MIT license. See LICENSE file in the project root for
+// details.
+//
+#pragma once
+
+#include <cstddef>
+
+namespace nestl {
+namespace detail {
+
+/*
+ * Index of the first element of sorted [data, data + size) that is not less
+ * than key. The loop runs a fixed number of iterations for a given size and
+ * its only data-dependent step is a conditional move, so it does not suffer
+ * from branch mispredictions the way std::lower_bound does.
+ */
+template <typename T, typename Key, typename Compare>
+[[nodiscard]] size_t branchless_lower_bound(const T* data, size_t size,
+                                            const Key& key,
+                                            const Compare& cmp) noexcept {
+    if (size == 0) {
+        return 0;
+    }
+
+    const T* base = data;
+    while (size > 1) {
+        size_t half = size / 2;
+        base = cmp(base[half], key) ? base + half : base;
+        size -= half;
+    }
+    return static_cast<size_t>(base - data) + (cmp(*base, key) ? 1 : 0);
+}
+
+}  // namespace detail
+}  // namespace nestl
@@ -18,11 +18,12 @@ public:
 
     storage() noexcept = default;
 
+    // Copy the bytes, which is only correct for trivially copyable
+    // payloads. Owners of anything else have to provide their own.
     storage(storage&&) noexcept = default;
     storage& operator=(storage&&) noexcept = default;
-
-    storage(const storage&) = delete;
-    storage& operator=(const storage&) = delete;
+    storage(const storage&) noexcept = default;
+    storage& operator=(const storage&) noexcept = default;
 
     template <typename T, typename... CtorArgs>
     storage(tag<T>, CtorArgs&&... args) noexcept {
@@ -49,21 +50,11 @@ public:
 
     template <typename T>
     void destroy() noexcept {
-        destroy_impl<T, Args...>();
-    }
-
-private:
-    template <typename Query, typename T, typename... Ts>
-    void destroy_impl() noexcept {
-        if (std::is_same_v<Query, T>) {
+        // result<void, E> has nothing to destroy on success
+        if constexpr (!std::is_void_v<T>) {
             as<T>().~T();
-        } else {
-            destroy_impl<Query, Ts...>();
         }
     }
-
-    template <typename Query>
-    void destroy_impl() noexcept {}
 };
 
 /*
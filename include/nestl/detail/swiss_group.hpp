@@ -0,0 +1,196 @@
+//
+// Copyright 2018 Marcin Radomski. All rights reserved.
+//
+// Licensed under the MIT license. See LICENSE file in the project root for
+// details.
+//
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if !defined(NESTL_DISABLE_SIMD) && defined(__SSE2__)
+#define NESTL_SWISS_GROUP_SSE2 1
+#include <emmintrin.h>
+#elif !defined(NESTL_DISABLE_SIMD) && defined(__ARM_NEON) \
+    && defined(__aarch64__)
+#define NESTL_SWISS_GROUP_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace nestl {
+namespace detail {
+
+/*
+ * Control bytes of an open-addressing table: one per slot, plus a sentinel
+ * and a copy of the first group_width - 1 bytes at the end, so that a whole
+ * group can be loaded starting from any slot.
+ *
+ * Full slots hold the lowest 7 bits of the hash of their key (H2), which
+ * lets a single group compare filter out most non-matching slots.
+ */
+using ctrl_t = int8_t;
+
+constexpr ctrl_t ctrl_empty = -128;    // 0b10000000
+constexpr ctrl_t ctrl_deleted = -2;    // 0b11111110
+constexpr ctrl_t ctrl_sentinel = -1;   // 0b11111111
+
+constexpr bool is_full(ctrl_t c) noexcept { return c >= 0; }
+
+/*
+ * Set of slot indices in a group, one bit (or byte, if Shift == 3) per slot.
+ */
+template <typename T, unsigned Shift>
+class bitmask {
+    T m_mask;
+
+public:
+    explicit bitmask(T mask) noexcept : m_mask(mask) {}
+
+    explicit operator bool() const noexcept { return m_mask != 0; }
+
+    [[nodiscard]] size_t lowest() const noexcept {
+        return static_cast<size_t>(__builtin_ctzll(m_mask)) >> Shift;
+    }
+
+    void clear_lowest() noexcept { m_mask &= static_cast<T>(m_mask - 1); }
+};
+
+#if defined(NESTL_SWISS_GROUP_SSE2)
+
+class group {
+    __m128i m_ctrl;
+
+    static bitmask<uint32_t, 0> to_mask(__m128i bytes) noexcept {
+        return bitmask<uint32_t, 0>{
+            static_cast<uint32_t>(_mm_movemask_epi8(bytes))};
+    }
+
+public:
+    static constexpr size_t width = 16;
+
+    explicit group(const ctrl_t* ctrl) noexcept
+        : m_ctrl(_mm_loadu_si128(reinterpret_cast<const __m128i*>(ctrl))) {}
+
+    [[nodiscard]] bitmask<uint32_t, 0> match(ctrl_t h2) const noexcept {
+        return to_mask(_mm_cmpeq_epi8(_mm_set1_epi8(h2), m_ctrl));
+    }
+
+    [[nodiscard]] bitmask<uint32_t, 0> match_empty() const noexcept {
+        return to_mask(_mm_cmpeq_epi8(_mm_set1_epi8(ctrl_empty), m_ctrl));
+    }
+
+    // empty and deleted are the only values lower than the sentinel
+    [[nodiscard]] bitmask<uint32_t, 0> match_empty_or_deleted() const
+        noexcept {
+        return to_mask(_mm_cmpgt_epi8(_mm_set1_epi8(ctrl_sentinel), m_ctrl));
+    }
+};
+
+#elif defined(NESTL_SWISS_GROUP_NEON)
+
+class group {
+    int8x8_t m_ctrl;
+
+    static bitmask<uint64_t, 3> to_mask(uint8x8_t bytes) noexcept {
+        return bitmask<uint64_t, 3>{
+            vget_lane_u64(vreinterpret_u64_u8(bytes), 0)
+            & 0x8080808080808080ull};
+    }
+
+public:
+    static constexpr size_t width = 8;
+
+    explicit group(const ctrl_t* ctrl) noexcept : m_ctrl(vld1_s8(ctrl)) {}
+
+    [[nodiscard]] bitmask<uint64_t, 3> match(ctrl_t h2) const noexcept {
+        return to_mask(vceq_s8(vdup_n_s8(h2), m_ctrl));
+    }
+
+    [[nodiscard]] bitmask<uint64_t, 3> match_empty() const noexcept {
+        return to_mask(vceq_s8(vdup_n_s8(ctrl_empty), m_ctrl));
+    }
+
+    [[nodiscard]] bitmask<uint64_t, 3> match_empty_or_deleted() const
+        noexcept {
+        return to_mask(vclt_s8(m_ctrl, vdup_n_s8(ctrl_sentinel)));
+    }
+};
+
+#else
+
+/*
+ * SWAR fallback operating on 8 control bytes packed in an uint64_t.
+ */
+class group {
+    static constexpr uint64_t lsbs = 0x0101010101010101ull;
+    static constexpr uint64_t msbs = 0x8080808080808080ull;
+
+    uint64_t m_ctrl;
+
+public:
+    static constexpr size_t width = 8;
+
+    explicit group(const ctrl_t* ctrl) noexcept {
+        std::memcpy(&m_ctrl, ctrl, sizeof(m_ctrl));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        m_ctrl = __builtin_bswap64(m_ctrl);
+#endif
+    }
+
+    // may report false positives, which get filtered out by key comparison
+    [[nodiscard]] bitmask<uint64_t, 3> match(ctrl_t h2) const noexcept {
+        uint64_t x = m_ctrl ^ (lsbs * static_cast<uint8_t>(h2));
+        return bitmask<uint64_t, 3>{(x - lsbs) & ~x & msbs};
+    }
+
+    [[nodiscard]] bitmask<uint64_t, 3> match_empty() const noexcept {
+        return bitmask<uint64_t, 3>{(m_ctrl & (~m_ctrl << 6)) & msbs};
+    }
+
+    [[nodiscard]] bitmask<uint64_t, 3> match_empty_or_deleted() const
+        noexcept {
+        return bitmask<uint64_t, 3>{(m_ctrl & (~m_ctrl << 7)) & msbs};
+    }
+};
+
+#endif
+
+/*
+ * Control bytes of a table with no slots. Lookups stop at the first group,
+ * and iteration stops at the sentinel.
+ */
+alignas(16) inline constexpr ctrl_t empty_group[16] = {
+    ctrl_sentinel, ctrl_empty, ctrl_empty, ctrl_empty,
+    ctrl_empty,    ctrl_empty, ctrl_empty, ctrl_empty,
+    ctrl_empty,    ctrl_empty, ctrl_empty, ctrl_empty,
+    ctrl_empty,    ctrl_empty, ctrl_empty, ctrl_empty};
+
+/*
+ * Triangular probing over groups; visits every group of a table whose
+ * capacity is 2^n - 1.
+ */
+class probe_seq {
+    size_t m_mask;
+    size_t m_offset;
+    size_t m_index = 0;
+
+public:
+    probe_seq(size_t hash, size_t mask) noexcept
+        : m_mask(mask),
+          m_offset(hash & mask) {}
+
+    [[nodiscard]] size_t offset() const noexcept { return m_offset; }
+    [[nodiscard]] size_t offset(size_t i) const noexcept {
+        return (m_offset + i) & m_mask;
+    }
+
+    void next() noexcept {
+        m_index += group::width;
+        m_offset = (m_offset + m_index) & m_mask;
+    }
+};
+
+}  // namespace detail
+}  // namespace nestl
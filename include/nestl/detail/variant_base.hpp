@@ -8,7 +8,10 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <limits>
+#include <new>
 #include <type_traits>
+#include <utility>
 
 #include <nestl/detail/storage.hpp>
 #include <nestl/utility.hpp>
@@ -16,113 +19,264 @@
 namespace nestl {
 namespace detail {
 
+struct variant_access;
+
+/*
+ * Smallest unsigned type able to hold every index and the invalid one.
+ */
+template <typename... Ts>
+using variant_index_t =
+    std::conditional_t<(sizeof...(Ts) < std::numeric_limits<uint8_t>::max()),
+                       uint8_t, uint16_t>;
+
+/*
+ * Storage with the index as a member of a derived class. The payload
+ * bytes are not rounded up to their alignment, so if the largest
+ * alternative leaves room after it, the Itanium C++ ABI places the index
+ * in the tail padding of the storage<Ts...> base: variant<char[6], int32_t>
+ * takes 8 bytes instead of 12. Otherwise the index goes after the payload.
+ *
+ * Copies of the base subobject only ever cover the payload bytes, so the
+ * index is never overwritten by them.
+ */
+template <typename... Ts>
+struct indexed_storage : storage<Ts...> {
+    using storage<Ts...>::storage;
+
+    variant_index_t<Ts...> index;
+};
+
+template <typename... Ts>
+class variant_storage {
+public:
+    using index_t = variant_index_t<Ts...>;
+    static constexpr index_t invalid_index =
+        std::numeric_limits<index_t>::max();
+
+protected:
+    indexed_storage<Ts...> m_storage;
+
+    variant_storage() noexcept { set_current(invalid_index); }
+
+    template <typename T, typename... Args>
+    variant_storage(tag<T> tag, Args&&... args) noexcept
+        : m_storage(tag, std::forward<Args>(args)...) {
+        set_current(static_cast<index_t>(type_index<T, Ts...>));
+    }
+
+    [[nodiscard]] index_t current() const noexcept { return m_storage.index; }
+    void set_current(index_t idx) noexcept { m_storage.index = idx; }
+};
+
+/*
+ * Held value and type index, plus operations on them. Special members are
+ * added by the layers below, depending on what the alternatives need.
+ */
 template <typename... Ts>
-class variant_base {
+class variant_core : public variant_storage<Ts...> {
+    friend struct variant_access;
+
+    using base = variant_storage<Ts...>;
+    using index_t = typename base::index_t;
+
 public:
     template <typename T,
               typename = std::enable_if_t<is_one_of<std::decay_t<T>, Ts...>>>
-    variant_base(T&& t) noexcept
-        : variant_base(tag<std::decay_t<T>>{},
-                       std::forward<std::decay_t<T>>(t)) {}
+    variant_core(T&& t) noexcept
+        : variant_core(tag<std::decay_t<T>>{}, std::forward<T>(t)) {}
 
     template <typename T, typename... Args>
-    variant_base(tag<T> tag, Args&&... args) noexcept
-        : m_current(type_index<T, Ts...>),
-          m_storage(tag, std::forward<Args>(args)...) {
+    variant_core(tag<T> tag, Args&&... args) noexcept
+        : base(tag, std::forward<Args>(args)...) {
         static_assert(is_one_of<T, Ts...>);
     }
 
-    variant_base(variant_base&& src) noexcept {
-        static_assert(all_of<std::is_move_constructible, Ts...>);
-        *this = std::move(src);
+    template <typename T>
+    [[nodiscard]] bool is() const noexcept {
+        static_assert(is_one_of<T, Ts...>);
+        return type_index<T, Ts...> == this->current();
     }
 
-    variant_base& operator=(variant_base&& src) noexcept {
-        static_assert(all_of<std::is_move_constructible, Ts...>);
-        if (this != &src) {
-            src.move_into(*this);
-        }
-        return *this;
+    // index of the held alternative, or invalid_type_index if moved-from
+    [[nodiscard]] size_t index() const noexcept {
+        return valid() ? this->current() : invalid_type_index;
     }
 
-    variant_base(const variant_base& src) noexcept {
-        static_assert(all_of<std::is_copy_constructible, Ts...>);
-        *this = src;
+protected:
+    static_assert(sizeof...(Ts) < std::numeric_limits<uint16_t>::max());
+
+    variant_core() noexcept = default;
+
+    [[nodiscard]] bool valid() const noexcept {
+        return this->current() < sizeof...(Ts);
     }
 
-    variant_base& operator=(const variant_base& src) noexcept {
-        static_assert(all_of<std::is_copy_constructible, Ts...>);
-        if (this != &src) {
-            src.copy_into(*this);
+    /*
+     * Calls f(tag<T>{}) with T being the type of the held value, if any.
+     *
+     * With a few alternatives, a chain of comparisons lets the compiler
+     * inline everything. With more, the call goes through a table of
+     * functions indexed by current(), so the cost no longer grows with the
+     * number of alternatives.
+     */
+    template <typename F>
+    inline void dispatch(F&& f) const noexcept {
+        if constexpr (sizeof...(Ts) <= 3) {
+            dispatch_chain(f, std::index_sequence_for<Ts...>{});
+        } else {
+            using fn = void (*)(F&) noexcept;
+            static constexpr fn table[] = {&call_with_tag<Ts, F>...};
+            index_t current = this->current();
+            if (current < sizeof...(Ts)) {
+                table[current](f);
+            }
         }
-        return *this;
     }
 
-    ~variant_base() noexcept {
-        destruct<0, Ts...>();
-        m_current = static_cast<uint8_t>(invalid_type_index);
+    template <typename F, size_t... Is>
+    inline void dispatch_chain(F& f, std::index_sequence<Is...>) const
+        noexcept {
+        index_t current = this->current();
+        (void)((current == Is ? (f(tag<Ts>{}), true) : false) || ...);
     }
 
-    template <typename T>
-    [[nodiscard]] bool is() const noexcept {
-        static_assert(is_one_of<T, Ts...>);
-        return type_index<T, Ts...> == m_current;
+    template <typename T, typename F>
+    static void call_with_tag(F& f) noexcept {
+        f(tag<T>{});
     }
 
-protected:
-    uint8_t m_current = static_cast<uint8_t>(invalid_type_index);
-    detail::storage<Ts...> m_storage;
-
-    template <uint8_t N, typename T, typename... Rest>
     inline void destruct() noexcept {
-        if (m_current == N) {
-            m_storage.template destroy<T>();
-        } else {
-            destruct<N + 1, Rest...>();
+        if constexpr (!all_of<std::is_trivially_destructible, Ts...>) {
+            dispatch([this](auto t) {
+                this->m_storage.template destroy<typename decltype(t)::type>();
+            });
         }
     }
 
-    template <uint8_t>
-    inline void destruct() {}
+    inline void reset() noexcept {
+        destruct();
+        this->set_current(base::invalid_index);
+    }
 
-    inline void move_into(variant_base& dst) noexcept {
-        move_into_impl<0, Ts...>(dst);
+    template <typename T, typename... Args>
+    inline void construct(Args&&... args) noexcept {
+        new (this->m_storage.data) T(std::forward<Args>(args)...);
+        this->set_current(static_cast<index_t>(type_index<T, Ts...>));
     }
 
-    template <uint8_t N, typename T, typename... Rest>
-    inline void move_into_impl(variant_base& dst) noexcept {
-        if (m_current == N) {
-            dst.~variant_base();
-            new (&dst)
-                variant_base(tag<T>{}, std::move(m_storage.template as<T>()));
-            this->~variant_base();
-            m_current = static_cast<uint8_t>(invalid_type_index);
-        } else {
-            static_assert(N < std::numeric_limits<uint8_t>::max());
-            move_into_impl<N + 1, Rest...>(dst);
+    inline void move_into(variant_core& dst) noexcept {
+        if (!valid()) {
+            return;
         }
+
+        dst.reset();
+        dispatch([this, &dst](auto t) {
+            using T = typename decltype(t)::type;
+            dst.template construct<T>(
+                std::move(this->m_storage.template as<T>()));
+            this->m_storage.template destroy<T>();
+        });
+        this->set_current(base::invalid_index);
     }
 
-    template <uint8_t>
-    inline void move_into_impl(variant_base&) noexcept {}
+    inline void copy_into(variant_core& dst) const noexcept {
+        if (!valid()) {
+            return;
+        }
 
-    inline void copy_into(variant_base& dst) const noexcept {
-        copy_into_impl<0, Ts...>(dst);
+        dst.reset();
+        dispatch([this, &dst](auto t) {
+            using T = typename decltype(t)::type;
+            dst.template construct<T>(this->m_storage.template as<T>());
+        });
     }
+};
 
-    template <uint8_t N, typename T, typename... Rest>
-    inline void copy_into_impl(variant_base& dst) const noexcept {
-        if (m_current == N) {
-            dst.~variant_base();
-            new (&dst) variant_base(tag<T>{}, m_storage.template as<T>());
-            static_assert(N < std::numeric_limits<uint8_t>::max());
-        } else {
-            copy_into_impl<N + 1, Rest...>(dst);
+/*
+ * The destructor is trivial if all alternatives are trivially destructible.
+ */
+template <bool Trivial, typename... Ts>
+class variant_destroy_layer : public variant_core<Ts...> {
+public:
+    using variant_core<Ts...>::variant_core;
+};
+
+template <typename... Ts>
+class variant_destroy_layer<false, Ts...> : public variant_core<Ts...> {
+public:
+    using variant_core<Ts...>::variant_core;
+
+    ~variant_destroy_layer() noexcept { this->reset(); }
+};
+
+/*
+ * Copies and moves are trivial if all alternatives are trivially copyable.
+ * Otherwise they go through move_into/copy_into, which leave a moved-from
+ * variant without a value.
+ */
+template <bool Trivial, typename... Ts>
+class variant_copy_move_layer
+    : public variant_destroy_layer<
+          all_of<std::is_trivially_destructible, Ts...>, Ts...> {
+public:
+    using variant_destroy_layer<all_of<std::is_trivially_destructible, Ts...>,
+                                Ts...>::variant_destroy_layer;
+};
+
+template <typename... Ts>
+class variant_copy_move_layer<false, Ts...>
+    : public variant_destroy_layer<
+          all_of<std::is_trivially_destructible, Ts...>, Ts...> {
+public:
+    using variant_destroy_layer<all_of<std::is_trivially_destructible, Ts...>,
+                                Ts...>::variant_destroy_layer;
+
+    variant_copy_move_layer(variant_copy_move_layer&& src) noexcept {
+        static_assert(all_of<std::is_move_constructible, Ts...>);
+        src.move_into(*this);
+    }
+
+    variant_copy_move_layer& operator=(variant_copy_move_layer&& src) noexcept {
+        static_assert(all_of<std::is_move_constructible, Ts...>);
+        if (this != &src) {
+            src.move_into(*this);
+        }
+        return *this;
+    }
+
+    variant_copy_move_layer(const variant_copy_move_layer& src) noexcept {
+        static_assert(all_of<std::is_copy_constructible, Ts...>);
+        src.copy_into(*this);
+    }
+
+    variant_copy_move_layer& operator=(
+        const variant_copy_move_layer& src) noexcept {
+        static_assert(all_of<std::is_copy_constructible, Ts...>);
+        if (this != &src) {
+            src.copy_into(*this);
         }
+        return *this;
     }
+};
 
-    template <uint8_t>
-    inline void copy_into_impl(variant_base&) const noexcept {}
+template <typename... Ts>
+using variant_base =
+    variant_copy_move_layer<all_of<std::is_trivially_copyable, Ts...>, Ts...>;
+
+/*
+ * Unchecked access to the held value, for use by visit().
+ */
+struct variant_access {
+    template <typename V>
+    static size_t index(const V& v) noexcept {
+        return v.current();
+    }
+
+    // forwards the value category of v to the alternative
+    template <typename T, typename V>
+    static decltype(auto) get(V&& v) noexcept {
+        return std::forward<V>(v).m_storage.template as<T>();
+    }
 };
 
 template <typename... Ts>
@@ -0,0 +1,121 @@
+//
+// Copyright 2018 Marcin Radomski. All rights reserved.
+//
+// Licensed under the MIT license. See LICENSE file in the project root for
+// details.
+//
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+#include <atomic>
+#include <type_traits>
+
+#include <nestl/detail/cache_line.hpp>
+
+namespace nestl {
+namespace detail {
+
+/*
+ * Bounded Chase-Lev work-stealing deque. The owner thread pushes and pops
+ * at the bottom, any other thread may steal from the top.
+ *
+ * The ring is provided by the caller and never grows; push() reports a full
+ * deque instead. The index operations are seq_cst rather than relying on
+ * standalone fences, which is what the original algorithm assumes and what
+ * thread sanitizers understand.
+ */
+template <typename T>
+class work_stealing_deque {
+    static_assert(std::is_trivially_copyable_v<T>);
+
+    static constexpr auto seq_cst = std::memory_order_seq_cst;
+    static constexpr auto relaxed = std::memory_order_relaxed;
+
+    alignas(cache_line_size) std::atomic<int64_t> m_top{0};
+    alignas(cache_line_size) std::atomic<int64_t> m_bottom{0};
+    alignas(cache_line_size) std::atomic<T>* m_ring = nullptr;
+    int64_t m_mask = 0;
+
+    std::atomic<T>& slot(int64_t idx) const noexcept {
+        return m_ring[idx & m_mask];
+    }
+
+public:
+    /*
+     * ring has to hold capacity elements, capacity has to be a power of two.
+     */
+    work_stealing_deque(std::atomic<T>* ring, size_t capacity) noexcept
+        : m_ring(ring),
+          m_mask(static_cast<int64_t>(capacity) - 1) {
+        assert(capacity > 0 && (capacity & (capacity - 1)) == 0);
+    }
+
+    work_stealing_deque(work_stealing_deque&&) = delete;
+    work_stealing_deque& operator=(work_stealing_deque&&) = delete;
+    work_stealing_deque(const work_stealing_deque&) = delete;
+    work_stealing_deque& operator=(const work_stealing_deque&) = delete;
+
+    /*
+     * Owner only. Returns false if the deque is full.
+     */
+    [[nodiscard]] bool push(T e) noexcept {
+        int64_t b = m_bottom.load(relaxed);
+        int64_t t = m_top.load(std::memory_order_acquire);
+        if (b - t > m_mask) {
+            return false;
+        }
+
+        slot(b).store(e, relaxed);
+        m_bottom.store(b + 1, seq_cst);
+        return true;
+    }
+
+    /*
+     * Owner only. Takes the most recently pushed element, or returns false
+     * if the deque is empty.
+     */
+    [[nodiscard]] bool pop(T& out) noexcept {
+        int64_t b = m_bottom.load(relaxed) - 1;
+        m_bottom.store(b, seq_cst);
+        int64_t t = m_top.load(seq_cst);
+        if (t > b) {
+            m_bottom.store(b + 1, relaxed);
+            return false;
+        }
+
+        out = slot(b).load(relaxed);
+        if (t == b) {
+            // last element: race the thieves for it
+            bool won = m_top.compare_exchange_strong(t, t + 1, seq_cst,
+                                                     relaxed);
+            m_bottom.store(b + 1, relaxed);
+            return won;
+        }
+        return true;
+    }
+
+    /*
+     * Any thread. Takes the least recently pushed element, or returns false
+     * if the deque is empty or another thread took it first.
+     */
+    [[nodiscard]] bool steal(T& out) noexcept {
+        int64_t t = m_top.load(seq_cst);
+        int64_t b = m_bottom.load(seq_cst);
+        if (t >= b) {
+            return false;
+        }
+
+        T e = slot(t).load(relaxed);
+        if (!m_top.compare_exchange_strong(t, t + 1, seq_cst, relaxed)) {
+            return false;
+        }
+        out = e;
+        return true;
+    }
+};
+
+}  // namespace detail
+}  // namespace nestl
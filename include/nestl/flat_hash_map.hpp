@@ -0,0 +1,555 @@
+//
+// Copyright 2018 Marcin Radomski. All rights reserved.
+//
+// Licensed under the MIT license. See LICENSE file in the project root for
+// details.
+//
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <functional>
+#include <iterator>
+#include <new>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include <nestl/allocator.hpp>
+#include <nestl/result.hpp>
+
+#include <nestl/detail/relocate.hpp>
+#include <nestl/detail/swiss_group.hpp>
+
+namespace nestl {
+
+class key_not_found {};
+
+/*
+ * Open-addressing hash map with SwissTable-style control bytes: lookups
+ * compare a whole group of 7-bit hash fragments at once (SSE2/NEON, or a
+ * SWAR fallback) and only touch slots whose fragment matches.
+ *
+ * Elements are stored inline in a single allocation obtained from Allocator,
+ * so pointers and iterators are invalidated by any insertion that rehashes.
+ * All operations that may allocate report failure through result.
+ */
+template <typename K, typename V, typename Hash = std::hash<K>,
+          typename Eq = std::equal_to<K>,
+          typename Allocator = system_allocator>
+class flat_hash_map {
+public:
+    using key_type = K;
+    using mapped_type = V;
+    using value_type = std::pair<K, V>;
+    using size_type = size_t;
+    using hasher = Hash;
+    using key_equal = Eq;
+    using allocator_type = Allocator;
+
+    static_assert(alignof(value_type) <= alignof(std::max_align_t));
+
+private:
+    using ctrl_t = detail::ctrl_t;
+    using group = detail::group;
+
+    template <typename Value>
+    class iterator_impl {
+        friend class flat_hash_map;
+
+        const ctrl_t* m_ctrl = nullptr;
+        Value* m_slot = nullptr;
+
+        iterator_impl(const ctrl_t* ctrl, Value* slot) noexcept
+            : m_ctrl(ctrl),
+              m_slot(slot) {
+            skip_empty();
+        }
+
+        void skip_empty() noexcept {
+            while (!detail::is_full(*m_ctrl)
+                   && *m_ctrl != detail::ctrl_sentinel) {
+                ++m_ctrl;
+                ++m_slot;
+            }
+        }
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = Value;
+        using difference_type = ptrdiff_t;
+        using pointer = Value*;
+        using reference = Value&;
+
+        iterator_impl() noexcept = default;
+
+        // iterator -> const_iterator
+        template <typename Other,
+                  typename = std::enable_if_t<
+                      std::is_same_v<const Other, Value>>>
+        iterator_impl(const iterator_impl<Other>& other) noexcept
+            : m_ctrl(other.m_ctrl),
+              m_slot(other.m_slot) {}
+
+        reference operator*() const noexcept { return *m_slot; }
+        pointer operator->() const noexcept { return m_slot; }
+
+        iterator_impl& operator++() noexcept {
+            ++m_ctrl;
+            ++m_slot;
+            skip_empty();
+            return *this;
+        }
+
+        iterator_impl operator++(int) noexcept {
+            auto copy = *this;
+            ++*this;
+            return copy;
+        }
+
+        bool operator==(const iterator_impl& other) const noexcept {
+            return m_ctrl == other.m_ctrl;
+        }
+
+        bool operator!=(const iterator_impl& other) const noexcept {
+            return m_ctrl != other.m_ctrl;
+        }
+    };
+
+public:
+    using iterator = iterator_impl<value_type>;
+    using const_iterator = iterator_impl<const value_type>;
+
+private:
+    Hash m_hash;
+    Eq m_eq;
+    Allocator m_allocator;
+    ctrl_t* m_ctrl = const_cast<ctrl_t*>(detail::empty_group);
+    value_type* m_slots = nullptr;
+    size_t m_size = 0;
+    size_t m_capacity = 0;
+    size_t m_growth_left = 0;
+
+    static constexpr size_t cloned_bytes = group::width - 1;
+
+    // 64-bit finalizer from MurmurHash3; std::hash is often the identity
+    [[nodiscard]] size_t hash(const K& key) const noexcept {
+        auto h = static_cast<uint64_t>(m_hash(key));
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdull;
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53ull;
+        h ^= h >> 33;
+        return static_cast<size_t>(h);
+    }
+
+    static size_t h1(size_t hash) noexcept { return hash >> 7; }
+    static ctrl_t h2(size_t hash) noexcept {
+        return static_cast<ctrl_t>(hash & 0x7f);
+    }
+
+    // Lookups stop at the first group with an empty slot, so there has to be
+    // one in every group-sized window of the table.
+    static size_t max_load(size_t capacity) noexcept {
+        if (group::width == 8 && capacity == 7) {
+            return 6;
+        }
+        return capacity - capacity / 8;
+    }
+
+    static size_t ctrl_bytes(size_t capacity) noexcept {
+        size_t size = capacity + 1 + cloned_bytes;
+        return (size + alignof(value_type) - 1) / alignof(value_type)
+               * alignof(value_type);
+    }
+
+    void set_ctrl(size_t idx, ctrl_t value) noexcept {
+        m_ctrl[idx] = value;
+        m_ctrl[((idx - cloned_bytes) & m_capacity)
+               + (cloned_bytes & m_capacity)] = value;
+    }
+
+    [[nodiscard]] size_t find_index(const K& key, size_t hash) const noexcept {
+        detail::probe_seq seq{h1(hash), m_capacity};
+        while (true) {
+            group g{m_ctrl + seq.offset()};
+            for (auto match = g.match(h2(hash)); match; match.clear_lowest()) {
+                size_t idx = seq.offset(match.lowest());
+                if (m_eq(m_slots[idx].first, key)) {
+                    return idx;
+                }
+            }
+            if (g.match_empty()) {
+                return m_capacity;
+            }
+            seq.next();
+        }
+    }
+
+    [[nodiscard]] size_t find_first_non_full(size_t hash) const noexcept {
+        detail::probe_seq seq{h1(hash), m_capacity};
+        while (true) {
+            group g{m_ctrl + seq.offset()};
+            if (auto mask = g.match_empty_or_deleted()) {
+                return seq.offset(mask.lowest());
+            }
+            seq.next();
+        }
+    }
+
+    void release() noexcept {
+        if (m_capacity > 0) {
+            m_allocator.free(m_ctrl);
+        }
+        m_ctrl = const_cast<ctrl_t*>(detail::empty_group);
+        m_slots = nullptr;
+        m_capacity = 0;
+        m_growth_left = 0;
+    }
+
+    [[nodiscard]] result<void, out_of_memory> resize(size_t new_capacity) {
+        assert(((new_capacity + 1) & new_capacity) == 0);
+        assert(max_load(new_capacity) >= m_size);
+
+        size_t bytes =
+            ctrl_bytes(new_capacity) + new_capacity * sizeof(value_type);
+        auto res = m_allocator.allocate(bytes);
+        if (!res) {
+            return {std::move(res).err()};
+        }
+
+        ctrl_t* old_ctrl = m_ctrl;
+        value_type* old_slots = m_slots;
+        size_t old_capacity = m_capacity;
+
+        m_ctrl = static_cast<ctrl_t*>(res.ok());
+        m_slots = reinterpret_cast<value_type*>(
+            static_cast<unsigned char*>(res.ok()) + ctrl_bytes(new_capacity));
+        m_capacity = new_capacity;
+        m_growth_left = max_load(new_capacity) - m_size;
+        std::memset(m_ctrl, static_cast<unsigned char>(detail::ctrl_empty),
+                    new_capacity + 1 + cloned_bytes);
+        m_ctrl[new_capacity] = detail::ctrl_sentinel;
+
+        for (size_t i = 0; i < old_capacity; ++i) {
+            if (detail::is_full(old_ctrl[i])) {
+                size_t h = hash(old_slots[i].first);
+                size_t idx = find_first_non_full(h);
+                set_ctrl(idx, h2(h));
+                detail::relocate(old_slots + i, old_slots + i + 1,
+                                 m_slots + idx);
+            }
+        }
+
+        if (old_capacity > 0) {
+            m_allocator.free(old_ctrl);
+        }
+        return {ok_t{}};
+    }
+
+    /*
+     * Drops tombstones without allocating: every full slot is marked deleted
+     * and every tombstone empty, then each element still marked deleted is
+     * moved to the first free slot of its probe sequence. An element that
+     * lands on another not-yet-placed one swaps with it, and the displaced
+     * element is placed next.
+     */
+    void rehash_in_place() noexcept {
+        for (size_t i = 0; i < m_capacity; ++i) {
+            set_ctrl(i, detail::is_full(m_ctrl[i]) ? detail::ctrl_deleted
+                                                   : detail::ctrl_empty);
+        }
+
+        alignas(value_type) unsigned char tmp[sizeof(value_type)];
+        auto* tmp_slot = reinterpret_cast<value_type*>(tmp);
+
+        for (size_t i = 0; i < m_capacity; ++i) {
+            if (m_ctrl[i] != detail::ctrl_deleted) {
+                continue;
+            }
+
+            size_t h = hash(m_slots[i].first);
+            size_t dst = find_first_non_full(h);
+
+            // already in the group a lookup would find first
+            size_t start = h1(h) & m_capacity;
+            auto probe_group = [&](size_t idx) {
+                return ((idx - start) & m_capacity) / group::width;
+            };
+            if (probe_group(dst) == probe_group(i)) {
+                set_ctrl(i, h2(h));
+                continue;
+            }
+
+            if (m_ctrl[dst] == detail::ctrl_empty) {
+                set_ctrl(dst, h2(h));
+                detail::relocate(m_slots + i, m_slots + i + 1, m_slots + dst);
+                set_ctrl(i, detail::ctrl_empty);
+            } else {
+                set_ctrl(dst, h2(h));
+                detail::relocate(m_slots + i, m_slots + i + 1, tmp_slot);
+                detail::relocate(m_slots + dst, m_slots + dst + 1,
+                                 m_slots + i);
+                detail::relocate(tmp_slot, tmp_slot + 1, m_slots + dst);
+                // place the element swapped into i
+                --i;
+            }
+        }
+
+        m_growth_left = max_load(m_capacity) - m_size;
+    }
+
+    // Makes room for one more element, either by growing the table or, if
+    // it is mostly tombstones, by dropping them in place.
+    [[nodiscard]] result<void, out_of_memory> make_room() {
+        if (m_capacity > 0 && m_size < max_load(m_capacity) / 2) {
+            rehash_in_place();
+            return {ok_t{}};
+        } else {
+            return resize(m_capacity * 2 + 1);
+        }
+    }
+
+    template <typename KeyArg, typename... Args>
+    [[nodiscard]] result<std::pair<iterator, bool>, out_of_memory>
+    emplace_impl(KeyArg&& key, Args&&... args) {
+        size_t h = hash(key);
+        size_t idx = find_index(key, h);
+        if (idx != m_capacity) {
+            return {std::make_pair(iterator_at(idx), false)};
+        }
+
+        idx = find_first_non_full(h);
+        if (m_growth_left == 0 && m_ctrl[idx] != detail::ctrl_deleted) {
+            if (auto res = make_room(); !res) {
+                return {res.err()};
+            }
+            idx = find_first_non_full(h);
+        }
+
+        if (m_ctrl[idx] == detail::ctrl_empty) {
+            --m_growth_left;
+        }
+        set_ctrl(idx, h2(h));
+        new (m_slots + idx) value_type(
+            std::piecewise_construct,
+            std::forward_as_tuple(std::forward<KeyArg>(key)),
+            std::forward_as_tuple(std::forward<Args>(args)...));
+        ++m_size;
+        return {std::make_pair(iterator_at(idx), true)};
+    }
+
+    void erase_at(size_t idx) noexcept {
+        assert(detail::is_full(m_ctrl[idx]));
+
+        m_slots[idx].~value_type();
+        set_ctrl(idx, detail::ctrl_deleted);
+        --m_size;
+    }
+
+    [[nodiscard]] iterator iterator_at(size_t idx) noexcept {
+        return {m_ctrl + idx, m_slots + idx};
+    }
+
+    [[nodiscard]] const_iterator iterator_at(size_t idx) const noexcept {
+        return {m_ctrl + idx, m_slots + idx};
+    }
+
+public:
+    flat_hash_map() noexcept : m_allocator() {}
+    explicit flat_hash_map(const Allocator& alloc) noexcept
+        : m_allocator(alloc) {}
+
+    flat_hash_map(flat_hash_map&& src) noexcept
+        : m_allocator(src.m_allocator) {
+        swap(src);
+    }
+
+    flat_hash_map& operator=(flat_hash_map&& src) noexcept {
+        if (this != &src) {
+            swap(src);
+            src.clear();
+        }
+        return *this;
+    }
+
+    // use copy() instead
+    flat_hash_map(const flat_hash_map&) = delete;
+    flat_hash_map& operator=(const flat_hash_map&) = delete;
+
+    [[nodiscard]] result<flat_hash_map, out_of_memory> copy() const noexcept {
+        flat_hash_map copy{m_allocator};
+        if (auto res = copy.reserve(m_size); !res) {
+            return {res.err()};
+        }
+
+        for (const value_type& e : *this) {
+            // cannot fail after reserve()
+            (void)copy.emplace_impl(e.first, e.second);
+        }
+        return {std::move(copy)};
+    }
+
+    ~flat_hash_map() noexcept {
+        clear();
+        release();
+    }
+
+    allocator_type get_allocator() const noexcept { return m_allocator; }
+
+    [[nodiscard]] iterator begin() noexcept { return iterator_at(0); }
+    [[nodiscard]] const_iterator begin() const noexcept {
+        return iterator_at(0);
+    }
+    [[nodiscard]] const_iterator cbegin() const noexcept { return begin(); }
+
+    [[nodiscard]] iterator end() noexcept { return {m_ctrl + m_capacity, {}}; }
+    [[nodiscard]] const_iterator end() const noexcept {
+        return {m_ctrl + m_capacity, {}};
+    }
+    [[nodiscard]] const_iterator cend() const noexcept { return end(); }
+
+    [[nodiscard]] bool empty() const noexcept { return m_size == 0; }
+    [[nodiscard]] size_t size() const noexcept { return m_size; }
+    [[nodiscard]] size_t capacity() const noexcept { return m_capacity; }
+
+    void clear() noexcept {
+        for (size_t i = 0; i < m_capacity; ++i) {
+            if (detail::is_full(m_ctrl[i])) {
+                m_slots[i].~value_type();
+            }
+        }
+
+        if (m_capacity > 0) {
+            std::memset(m_ctrl, static_cast<unsigned char>(detail::ctrl_empty),
+                        m_capacity + 1 + cloned_bytes);
+            m_ctrl[m_capacity] = detail::ctrl_sentinel;
+        }
+        m_size = 0;
+        m_growth_left = max_load(m_capacity);
+    }
+
+    // Makes sure `count` elements fit without further allocation.
+    result<void, out_of_memory> reserve(size_t count) noexcept {
+        if (count <= m_size + m_growth_left) {
+            return {ok_t{}};
+        }
+
+        size_t capacity = 1;
+        while (max_load(capacity) < count) {
+            capacity = capacity * 2 + 1;
+        }
+        return resize(capacity);
+    }
+
+    // Rebuilds the table with room for at least `count` elements, dropping
+    // tombstones left by erase().
+    result<void, out_of_memory> rehash(size_t count) noexcept {
+        if (count < m_size) {
+            count = m_size;
+        }
+        if (count == 0) {
+            if (m_size == 0) {
+                release();
+            }
+            return {ok_t{}};
+        }
+
+        size_t capacity = 1;
+        while (max_load(capacity) < count) {
+            capacity = capacity * 2 + 1;
+        }
+        return resize(capacity);
+    }
+
+    result<std::pair<iterator, bool>, out_of_memory> insert(
+        value_type&& value) noexcept {
+        return emplace_impl(std::move(value.first), std::move(value.second));
+    }
+
+    result<std::pair<iterator, bool>, out_of_memory> insert(
+        const value_type& value) noexcept {
+        return emplace_impl(value.first, value.second);
+    }
+
+    // Constructs the value from args only if key is not present yet.
+    template <typename... Args>
+    result<std::pair<iterator, bool>, out_of_memory> emplace(
+        const K& key, Args&&... args) noexcept {
+        return emplace_impl(key, std::forward<Args>(args)...);
+    }
+
+    template <typename... Args>
+    result<std::pair<iterator, bool>, out_of_memory> emplace(
+        K&& key, Args&&... args) noexcept {
+        return emplace_impl(std::move(key), std::forward<Args>(args)...);
+    }
+
+    [[nodiscard]] iterator find(const K& key) noexcept {
+        size_t idx = find_index(key, hash(key));
+        return idx == m_capacity ? end() : iterator_at(idx);
+    }
+
+    [[nodiscard]] const_iterator find(const K& key) const noexcept {
+        size_t idx = find_index(key, hash(key));
+        return idx == m_capacity ? end() : iterator_at(idx);
+    }
+
+    [[nodiscard]] bool contains(const K& key) const noexcept {
+        return find(key) != end();
+    }
+
+    [[nodiscard]] size_t count(const K& key) const noexcept {
+        return contains(key) ? 1 : 0;
+    }
+
+    [[nodiscard]] result<std::reference_wrapper<V>, key_not_found> at(
+        const K& key) noexcept {
+        auto it = find(key);
+        if (it != end()) {
+            return {std::reference_wrapper<V>{it->second}};
+        } else {
+            return {key_not_found{}};
+        }
+    }
+
+    [[nodiscard]] result<std::reference_wrapper<const V>, key_not_found> at(
+        const K& key) const noexcept {
+        auto it = find(key);
+        if (it != end()) {
+            return {std::reference_wrapper<const V>{it->second}};
+        } else {
+            return {key_not_found{}};
+        }
+    }
+
+    size_t erase(const K& key) noexcept {
+        size_t idx = find_index(key, hash(key));
+        if (idx == m_capacity) {
+            return 0;
+        }
+
+        erase_at(idx);
+        return 1;
+    }
+
+    void erase(const_iterator pos) noexcept {
+        erase_at(static_cast<size_t>(pos.m_ctrl - m_ctrl));
+    }
+
+    void swap(flat_hash_map& other) noexcept {
+        std::swap(m_hash, other.m_hash);
+        std::swap(m_eq, other.m_eq);
+        std::swap(m_allocator, other.m_allocator);
+        std::swap(m_ctrl, other.m_ctrl);
+        std::swap(m_slots, other.m_slots);
+        std::swap(m_size, other.m_size);
+        std::swap(m_capacity, other.m_capacity);
+        std::swap(m_growth_left, other.m_growth_left);
+    }
+};
+
+}  // namespace nestl
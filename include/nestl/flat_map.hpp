@@ -0,0 +1,413 @@
+//
+// Copyright 2018 Marcin Radomski. All rights reserved.
+//
+// Licensed under the MIT license. See LICENSE file in the project root for
+// details.
+//
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+
+#include <nestl/allocator.hpp>
+#include <nestl/result.hpp>
+#include <nestl/vector.hpp>
+
+#include <nestl/detail/sorted_search.hpp>
+
+namespace nestl {
+
+/*
+ * Map with unique keys, kept sorted in one nestl::vector and with values in
+ * another, so that lookups only ever touch contiguous keys.
+ *
+ * Lookups are branchless binary searches, which makes it a good fit for
+ * read-mostly tables. Single-element insertion and erasure are O(n); use
+ * insert_sorted_range() to add many elements at once.
+ *
+ * Since keys and values are stored separately, iterators dereference to
+ * std::pair<const K&, V&> proxies rather than to real std::pair objects.
+ */
+template <typename K, typename V, typename Compare = std::less<K>,
+          typename Allocator = system_allocator>
+class flat_map {
+public:
+    using key_type = K;
+    using mapped_type = V;
+    using value_type = std::pair<K, V>;
+    using size_type = size_t;
+    using key_compare = Compare;
+    using allocator_type = Allocator;
+
+private:
+    template <bool Const>
+    class iterator_impl {
+        friend class flat_map;
+
+        using mapped_ptr = std::conditional_t<Const, const V*, V*>;
+
+        const K* m_key = nullptr;
+        mapped_ptr m_value = nullptr;
+
+        iterator_impl(const K* key, mapped_ptr value) noexcept
+            : m_key(key),
+              m_value(value) {}
+
+    public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = std::pair<K, V>;
+        using difference_type = ptrdiff_t;
+        using reference =
+            std::pair<const K&, std::conditional_t<Const, const V&, V&>>;
+
+        struct pointer {
+            reference ref;
+            const reference* operator->() const noexcept { return &ref; }
+        };
+
+        iterator_impl() noexcept = default;
+
+        // iterator -> const_iterator
+        template <bool OtherConst,
+                  typename = std::enable_if_t<Const && !OtherConst>>
+        iterator_impl(const iterator_impl<OtherConst>& other) noexcept
+            : m_key(other.m_key),
+              m_value(other.m_value) {}
+
+        reference operator*() const noexcept { return {*m_key, *m_value}; }
+        pointer operator->() const noexcept { return {**this}; }
+        reference operator[](difference_type n) const noexcept {
+            return *(*this + n);
+        }
+
+        iterator_impl& operator+=(difference_type n) noexcept {
+            m_key += n;
+            m_value += n;
+            return *this;
+        }
+
+        iterator_impl& operator-=(difference_type n) noexcept {
+            return *this += -n;
+        }
+
+        iterator_impl& operator++() noexcept { return *this += 1; }
+        iterator_impl& operator--() noexcept { return *this -= 1; }
+
+        iterator_impl operator++(int) noexcept {
+            auto copy = *this;
+            ++*this;
+            return copy;
+        }
+
+        iterator_impl operator--(int) noexcept {
+            auto copy = *this;
+            --*this;
+            return copy;
+        }
+
+        iterator_impl operator+(difference_type n) const noexcept {
+            auto copy = *this;
+            return copy += n;
+        }
+
+        iterator_impl operator-(difference_type n) const noexcept {
+            auto copy = *this;
+            return copy -= n;
+        }
+
+        difference_type operator-(const iterator_impl& other) const noexcept {
+            return m_key - other.m_key;
+        }
+
+        bool operator==(const iterator_impl& other) const noexcept {
+            return m_key == other.m_key;
+        }
+
+        bool operator!=(const iterator_impl& other) const noexcept {
+            return m_key != other.m_key;
+        }
+
+        bool operator<(const iterator_impl& other) const noexcept {
+            return m_key < other.m_key;
+        }
+    };
+
+public:
+    using iterator = iterator_impl<false>;
+    using const_iterator = iterator_impl<true>;
+
+private:
+    Compare m_cmp;
+    vector<K, Allocator> m_keys;
+    vector<V, Allocator> m_values;
+
+    [[nodiscard]] size_t lower_bound_index(const K& key) const noexcept {
+        return detail::branchless_lower_bound(m_keys.data(), m_keys.size(),
+                                              key, m_cmp);
+    }
+
+    [[nodiscard]] bool found_at(size_t idx, const K& key) const noexcept {
+        return idx < m_keys.size() && !m_cmp(key, m_keys[idx]);
+    }
+
+    [[nodiscard]] iterator iterator_at(size_t idx) noexcept {
+        return {m_keys.data() + idx, m_values.data() + idx};
+    }
+
+    [[nodiscard]] const_iterator iterator_at(size_t idx) const noexcept {
+        return {m_keys.data() + idx, m_values.data() + idx};
+    }
+
+    // Reserving both vectors up front means the element insertions that
+    // follow cannot fail, so keys and values never get out of sync.
+    // reserve() allocates exactly what it is asked for, so grow geometrically.
+    [[nodiscard]] result<void, out_of_memory> reserve_for_insert() {
+        size_t capacity = m_keys.capacity();
+        if (m_keys.size() < capacity && m_values.size() < m_values.capacity()) {
+            return {ok_t{}};
+        }
+        return reserve(capacity < 8 ? 8 : capacity + capacity / 2);
+    }
+
+    template <typename KeyArg, typename... Args>
+    [[nodiscard]] result<std::pair<iterator, bool>, out_of_memory>
+    emplace_impl(KeyArg&& key, Args&&... args) {
+        size_t idx = lower_bound_index(key);
+        if (found_at(idx, key)) {
+            return {std::make_pair(iterator_at(idx), false)};
+        }
+
+        if (auto res = reserve_for_insert(); !res) {
+            return {res.err()};
+        }
+
+        // cannot fail after reserve
+        (void)m_keys.emplace(m_keys.begin() + idx, std::forward<KeyArg>(key));
+        (void)m_values.emplace(m_values.begin() + idx,
+                               std::forward<Args>(args)...);
+        return {std::make_pair(iterator_at(idx), true)};
+    }
+
+public:
+    flat_map() noexcept : m_cmp(), m_keys(), m_values() {}
+    explicit flat_map(const Allocator& alloc) noexcept
+        : m_cmp(),
+          m_keys(alloc),
+          m_values(alloc) {}
+    explicit flat_map(const Compare& cmp,
+                      const Allocator& alloc = Allocator()) noexcept
+        : m_cmp(cmp),
+          m_keys(alloc),
+          m_values(alloc) {}
+
+    flat_map(flat_map&&) noexcept = default;
+    flat_map& operator=(flat_map&&) noexcept = default;
+
+    // use copy() instead
+    flat_map(const flat_map&) = delete;
+    flat_map& operator=(const flat_map&) = delete;
+
+    [[nodiscard]] result<flat_map, out_of_memory> copy() const noexcept {
+        flat_map copy{m_cmp, m_keys.get_allocator()};
+        if (auto res = m_keys.copy_into(copy.m_keys); !res) {
+            return {res.err()};
+        }
+        if (auto res = m_values.copy_into(copy.m_values); !res) {
+            return {res.err()};
+        }
+        return {std::move(copy)};
+    }
+
+    allocator_type get_allocator() const noexcept {
+        return m_keys.get_allocator();
+    }
+
+    key_compare key_comp() const noexcept { return m_cmp; }
+
+    [[nodiscard]] iterator begin() noexcept { return iterator_at(0); }
+    [[nodiscard]] const_iterator begin() const noexcept {
+        return iterator_at(0);
+    }
+    [[nodiscard]] const_iterator cbegin() const noexcept { return begin(); }
+
+    [[nodiscard]] iterator end() noexcept { return iterator_at(size()); }
+    [[nodiscard]] const_iterator end() const noexcept {
+        return iterator_at(size());
+    }
+    [[nodiscard]] const_iterator cend() const noexcept { return end(); }
+
+    // sorted keys and their values, at matching indices
+    [[nodiscard]] const vector<K, Allocator>& keys() const noexcept {
+        return m_keys;
+    }
+    [[nodiscard]] const vector<V, Allocator>& values() const noexcept {
+        return m_values;
+    }
+
+    [[nodiscard]] bool empty() const noexcept { return m_keys.empty(); }
+    [[nodiscard]] size_t size() const noexcept { return m_keys.size(); }
+    [[nodiscard]] size_t capacity() const noexcept {
+        return std::min(m_keys.capacity(), m_values.capacity());
+    }
+
+    result<void, out_of_memory> reserve(size_t count) noexcept {
+        if (auto res = m_keys.reserve(count); !res) {
+            return res;
+        }
+        return m_values.reserve(count);
+    }
+
+    void shrink_to_fit() noexcept {
+        m_keys.shrink_to_fit();
+        m_values.shrink_to_fit();
+    }
+
+    void clear() noexcept {
+        m_keys.clear();
+        m_values.clear();
+    }
+
+    result<std::pair<iterator, bool>, out_of_memory> insert(
+        value_type&& value) noexcept {
+        return emplace_impl(std::move(value.first), std::move(value.second));
+    }
+
+    result<std::pair<iterator, bool>, out_of_memory> insert(
+        const value_type& value) noexcept {
+        return emplace_impl(value.first, value.second);
+    }
+
+    // Constructs the value from args only if key is not present yet.
+    template <typename... Args>
+    result<std::pair<iterator, bool>, out_of_memory> emplace(
+        const K& key, Args&&... args) noexcept {
+        return emplace_impl(key, std::forward<Args>(args)...);
+    }
+
+    template <typename... Args>
+    result<std::pair<iterator, bool>, out_of_memory> emplace(
+        K&& key, Args&&... args) noexcept {
+        return emplace_impl(std::move(key), std::forward<Args>(args)...);
+    }
+
+    /*
+     * Inserts std::pair<K, V> elements from [first, last), which must be
+     * sorted by key according to Compare, merging them with the existing
+     * ones in O(size() + count). Existing keys are not overwritten. On
+     * failure the map is left unchanged.
+     */
+    template <typename It>
+    result<void, out_of_memory> insert_sorted_range(It first,
+                                                    It last) noexcept {
+        assert(std::is_sorted(first, last, [this](const auto& a,
+                                                  const auto& b) {
+            return m_cmp(a.first, b.first);
+        }));
+
+        auto count = static_cast<size_t>(std::distance(first, last));
+        if (count == 0) {
+            return {ok_t{}};
+        }
+
+        vector<K, Allocator> keys{m_keys.get_allocator()};
+        vector<V, Allocator> values{m_values.get_allocator()};
+        if (auto res = keys.reserve(size() + count); !res) {
+            return {res.err()};
+        }
+        if (auto res = values.reserve(size() + count); !res) {
+            return {res.err()};
+        }
+
+        // none of the push_backs below can fail after reserve()
+        size_t old = 0;
+        for (; first != last; ++first) {
+            const K& key = (*first).first;
+            while (old < size() && m_cmp(m_keys[old], key)) {
+                (void)keys.push_back(std::move(m_keys[old]));
+                (void)values.push_back(std::move(m_values[old]));
+                ++old;
+            }
+
+            bool present = old < size() && !m_cmp(key, m_keys[old]);
+            bool repeated = !keys.empty() && !m_cmp(keys.back(), key);
+            if (!present && !repeated) {
+                // moves out of the pair if It is a move_iterator
+                (void)keys.emplace_back((*first).first);
+                (void)values.emplace_back((*first).second);
+            }
+        }
+        for (; old < size(); ++old) {
+            (void)keys.push_back(std::move(m_keys[old]));
+            (void)values.push_back(std::move(m_values[old]));
+        }
+
+        m_keys.swap(keys);
+        m_values.swap(values);
+        return {ok_t{}};
+    }
+
+    size_t erase(const K& key) noexcept {
+        size_t idx = lower_bound_index(key);
+        if (!found_at(idx, key)) {
+            return 0;
+        }
+
+        erase(iterator_at(idx));
+        return 1;
+    }
+
+    iterator erase(const_iterator pos) noexcept {
+        auto idx = static_cast<size_t>(pos.m_key - m_keys.data());
+        m_keys.erase(m_keys.begin() + idx);
+        m_values.erase(m_values.begin() + idx);
+        return iterator_at(idx);
+    }
+
+    [[nodiscard]] iterator lower_bound(const K& key) noexcept {
+        return iterator_at(lower_bound_index(key));
+    }
+
+    [[nodiscard]] const_iterator lower_bound(const K& key) const noexcept {
+        return iterator_at(lower_bound_index(key));
+    }
+
+    [[nodiscard]] iterator find(const K& key) noexcept {
+        size_t idx = lower_bound_index(key);
+        return found_at(idx, key) ? iterator_at(idx) : end();
+    }
+
+    [[nodiscard]] const_iterator find(const K& key) const noexcept {
+        size_t idx = lower_bound_index(key);
+        return found_at(idx, key) ? iterator_at(idx) : end();
+    }
+
+    [[nodiscard]] bool contains(const K& key) const noexcept {
+        return found_at(lower_bound_index(key), key);
+    }
+
+    [[nodiscard]] size_t count(const K& key) const noexcept {
+        return contains(key) ? 1 : 0;
+    }
+
+    void swap(flat_map& other) noexcept {
+        std::swap(m_cmp, other.m_cmp);
+        m_keys.swap(other.m_keys);
+        m_values.swap(other.m_values);
+    }
+
+    [[nodiscard]] bool operator==(const flat_map& other) const {
+        return m_keys == other.m_keys && m_values == other.m_values;
+    }
+
+    [[nodiscard]] bool operator!=(const flat_map& other) const {
+        return !(*this == other);
+    }
+};
+
+}  // namespace nestl
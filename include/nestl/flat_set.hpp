@@ -0,0 +1,225 @@
+//
+// Copyright 2018 Marcin Radomski. All rights reserved.
+//
+// Licensed under the MIT license. See LICENSE file in the project root for
+// details.
+//
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <utility>
+
+#include <nestl/allocator.hpp>
+#include <nestl/result.hpp>
+#include <nestl/vector.hpp>
+
+#include <nestl/detail/sorted_search.hpp>
+
+namespace nestl {
+
+/*
+ * Set of unique keys kept sorted in a single nestl::vector.
+ *
+ * Lookups are branchless binary searches over contiguous memory, which makes
+ * it a good fit for read-mostly sets. Single-element insertion and erasure
+ * are O(n); use insert_sorted_range() to add many keys at once.
+ */
+template <typename K, typename Compare = std::less<K>,
+          typename Allocator = system_allocator>
+class flat_set {
+public:
+    using key_type = K;
+    using value_type = K;
+    using size_type = size_t;
+    using key_compare = Compare;
+    using allocator_type = Allocator;
+    using iterator = const K*;
+    using const_iterator = const K*;
+
+private:
+    Compare m_cmp;
+    vector<K, Allocator> m_keys;
+
+    [[nodiscard]] size_t lower_bound_index(const K& key) const noexcept {
+        return detail::branchless_lower_bound(m_keys.data(), m_keys.size(),
+                                              key, m_cmp);
+    }
+
+    [[nodiscard]] bool found_at(size_t idx, const K& key) const noexcept {
+        return idx < m_keys.size() && !m_cmp(key, m_keys[idx]);
+    }
+
+    template <typename KeyArg>
+    [[nodiscard]] result<std::pair<iterator, bool>, out_of_memory> insert_impl(
+        KeyArg&& key) {
+        size_t idx = lower_bound_index(key);
+        if (found_at(idx, key)) {
+            return {std::make_pair(begin() + idx, false)};
+        }
+
+        if (auto res = m_keys.emplace(m_keys.begin() + idx,
+                                      std::forward<KeyArg>(key));
+            !res) {
+            return {res.err()};
+        }
+        return {std::make_pair(begin() + idx, true)};
+    }
+
+public:
+    flat_set() noexcept : m_cmp(), m_keys() {}
+    explicit flat_set(const Allocator& alloc) noexcept
+        : m_cmp(),
+          m_keys(alloc) {}
+    explicit flat_set(const Compare& cmp,
+                      const Allocator& alloc = Allocator()) noexcept
+        : m_cmp(cmp),
+          m_keys(alloc) {}
+
+    flat_set(flat_set&&) noexcept = default;
+    flat_set& operator=(flat_set&&) noexcept = default;
+
+    // use copy() instead
+    flat_set(const flat_set&) = delete;
+    flat_set& operator=(const flat_set&) = delete;
+
+    [[nodiscard]] result<flat_set, out_of_memory> copy() const noexcept {
+        flat_set copy{m_cmp, m_keys.get_allocator()};
+        if (auto res = m_keys.copy_into(copy.m_keys); !res) {
+            return {res.err()};
+        }
+        return {std::move(copy)};
+    }
+
+    allocator_type get_allocator() const noexcept {
+        return m_keys.get_allocator();
+    }
+
+    key_compare key_comp() const noexcept { return m_cmp; }
+
+    [[nodiscard]] const_iterator begin() const noexcept {
+        return m_keys.begin();
+    }
+    [[nodiscard]] const_iterator cbegin() const noexcept { return begin(); }
+
+    [[nodiscard]] const_iterator end() const noexcept { return m_keys.end(); }
+    [[nodiscard]] const_iterator cend() const noexcept { return end(); }
+
+    [[nodiscard]] const K* data() const noexcept { return m_keys.data(); }
+
+    [[nodiscard]] bool empty() const noexcept { return m_keys.empty(); }
+    [[nodiscard]] size_t size() const noexcept { return m_keys.size(); }
+    [[nodiscard]] size_t capacity() const noexcept {
+        return m_keys.capacity();
+    }
+
+    result<void, out_of_memory> reserve(size_t count) noexcept {
+        return m_keys.reserve(count);
+    }
+
+    void shrink_to_fit() noexcept { m_keys.shrink_to_fit(); }
+
+    void clear() noexcept { m_keys.clear(); }
+
+    result<std::pair<iterator, bool>, out_of_memory> insert(
+        const K& key) noexcept {
+        return insert_impl(key);
+    }
+
+    result<std::pair<iterator, bool>, out_of_memory> insert(K&& key) noexcept {
+        return insert_impl(std::move(key));
+    }
+
+    /*
+     * Inserts keys from [first, last), which must be sorted according to
+     * Compare, merging them with the existing ones in O(size() + count).
+     * Keys already present are not overwritten. On failure the set is left
+     * unchanged.
+     */
+    template <typename It>
+    result<void, out_of_memory> insert_sorted_range(It first,
+                                                    It last) noexcept {
+        assert(std::is_sorted(first, last, m_cmp));
+
+        auto count = static_cast<size_t>(std::distance(first, last));
+        if (count == 0) {
+            return {ok_t{}};
+        }
+
+        vector<K, Allocator> merged{m_keys.get_allocator()};
+        if (auto res = merged.reserve(size() + count); !res) {
+            return {res.err()};
+        }
+
+        // none of the push_backs below can fail after reserve()
+        auto old = m_keys.begin();
+        for (; first != last; ++first) {
+            while (old != m_keys.end() && m_cmp(*old, *first)) {
+                (void)merged.push_back(std::move(*old));
+                ++old;
+            }
+
+            bool present = old != m_keys.end() && !m_cmp(*first, *old);
+            bool repeated = !merged.empty() && !m_cmp(merged.back(), *first);
+            if (!present && !repeated) {
+                (void)merged.emplace_back(*first);
+            }
+        }
+        for (; old != m_keys.end(); ++old) {
+            (void)merged.push_back(std::move(*old));
+        }
+
+        m_keys.swap(merged);
+        return {ok_t{}};
+    }
+
+    size_t erase(const K& key) noexcept {
+        size_t idx = lower_bound_index(key);
+        if (!found_at(idx, key)) {
+            return 0;
+        }
+
+        m_keys.erase(m_keys.begin() + idx);
+        return 1;
+    }
+
+    iterator erase(const_iterator pos) noexcept {
+        return m_keys.erase(pos);
+    }
+
+    [[nodiscard]] const_iterator lower_bound(const K& key) const noexcept {
+        return begin() + lower_bound_index(key);
+    }
+
+    [[nodiscard]] const_iterator find(const K& key) const noexcept {
+        size_t idx = lower_bound_index(key);
+        return found_at(idx, key) ? begin() + idx : end();
+    }
+
+    [[nodiscard]] bool contains(const K& key) const noexcept {
+        return found_at(lower_bound_index(key), key);
+    }
+
+    [[nodiscard]] size_t count(const K& key) const noexcept {
+        return contains(key) ? 1 : 0;
+    }
+
+    void swap(flat_set& other) noexcept {
+        std::swap(m_cmp, other.m_cmp);
+        m_keys.swap(other.m_keys);
+    }
+
+    [[nodiscard]] bool operator==(const flat_set& other) const {
+        return m_keys == other.m_keys;
+    }
+
+    [[nodiscard]] bool operator!=(const flat_set& other) const {
+        return !(*this == other);
+    }
+};
+
+}  // namespace nestl
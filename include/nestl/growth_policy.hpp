@@ -0,0 +1,94 @@
+//
+// Copyright 2018 Marcin Radomski. All rights reserved.
+//
+// Licensed under the MIT license. See LICENSE file in the project root for
+// details.
+//
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <algorithm>
+
+namespace nestl {
+
+/*
+ * Growth policies decide how much capacity a container allocates when it
+ * runs out of room while inserting. Explicit reserve() calls always
+ * allocate exactly what was asked for.
+ *
+ * A policy provides:
+ *   static size_t next_capacity(size_t capacity, size_t required,
+ *                               size_t elem_size) noexcept
+ * returning a capacity of at least `required` elements.
+ */
+
+/*
+ * Multiplies capacity by Num / Den, rounding up so that small capacities
+ * grow too, starting at Initial elements. Saturates at the largest
+ * capacity whose size in bytes fits in size_t.
+ */
+template <size_t Num = 3, size_t Den = 2, size_t Initial = 10>
+struct geometric_growth {
+    static_assert(Num > Den && Den > 0);
+
+    static size_t next_capacity(size_t capacity, size_t required,
+                                size_t elem_size) noexcept {
+        size_t limit = SIZE_MAX / elem_size;
+        size_t grown;
+        if (capacity == 0) {
+            grown = Initial;
+        } else if (capacity / Den >= limit / Num) {
+            grown = limit;
+        } else {
+            // capacity * Num / Den without overflowing the multiplication
+            grown = capacity / Den * Num
+                    + (capacity % Den * Num + Den - 1) / Den;
+        }
+        return std::max(std::min(grown, limit), required);
+    }
+};
+
+/*
+ * Geometric growth, but buffers of at least PageSize bytes are rounded up
+ * to a whole number of pages. Big allocations are usually served directly
+ * by the OS in whole pages, and the rounding lets the container use all
+ * of them.
+ */
+template <size_t PageSize = 4096, typename Geometric = geometric_growth<>>
+struct page_growth {
+    static_assert(PageSize > 0 && (PageSize & (PageSize - 1)) == 0,
+                  "PageSize must be a power of two");
+
+    static size_t next_capacity(size_t capacity, size_t required,
+                                size_t elem_size) noexcept {
+        size_t grown = Geometric::next_capacity(capacity, required, elem_size);
+        if (grown > (SIZE_MAX - (PageSize - 1)) / elem_size) {
+            // too big to round; the allocation is going to fail anyway
+            return grown;
+        }
+
+        size_t bytes = grown * elem_size;
+        if (bytes < PageSize) {
+            return grown;
+        }
+
+        size_t rounded = (bytes + PageSize - 1) & ~(PageSize - 1);
+        return rounded / elem_size;
+    }
+};
+
+/*
+ * Allocates only what is required. Makes repeated single-element inserts
+ * quadratic; meant for containers filled with bulk operations or whose
+ * final size is known.
+ */
+struct exact_growth {
+    static size_t next_capacity(size_t /* capacity */, size_t required,
+                                size_t /* elem_size */) noexcept {
+        return required;
+    }
+};
+
+}  // namespace nestl
@@ -0,0 +1,248 @@
+//
+// Copyright 2018 Marcin Radomski. All rights reserved.
+//
+// Licensed under the MIT license. See LICENSE file in the project root for
+// details.
+//
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+
+#include <algorithm>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <nestl/allocator.hpp>
+#include <nestl/result.hpp>
+
+namespace nestl {
+
+enum class huge_pages {
+    // regular pages only
+    none,
+    // ask for transparent huge pages with madvise(MADV_HUGEPAGE)
+    transparent,
+    // map from the preallocated hugetlbfs pool (MAP_HUGETLB), falling back
+    // to transparent huge pages if the pool is empty
+    explicit_pool,
+};
+
+/*
+ * Allocator for very large buffers. Requests of at least `threshold` bytes
+ * get their own anonymous mapping, which reallocate() grows with mremap()
+ * on Linux, so the pages are remapped rather than copied. Smaller requests
+ * go to the Small allocator.
+ *
+ * Every block is preceded by a header recording where it came from, and
+ * usable_size() reports the whole mapping, so a nestl::vector fills the
+ * last page before growing again.
+ */
+template <typename Small = system_allocator>
+class mmap_allocator {
+public:
+    static constexpr size_t default_threshold = 1024 * 1024;
+    static constexpr size_t huge_page_size = 2 * 1024 * 1024;
+
+private:
+    struct alignas(std::max_align_t) header {
+        // size of the mapping, or 0 if allocated from Small
+        size_t mapped;
+        // requested size of a block from Small
+        size_t size;
+    };
+
+    Small m_small;
+    size_t m_threshold;
+    huge_pages m_huge_pages;
+
+    static header* header_of(void* p) noexcept {
+        return static_cast<header*>(p) - 1;
+    }
+
+    static void* block_of(header* h) noexcept { return h + 1; }
+
+    // Small may have handed out more than requested
+    size_t small_size(header* h) const noexcept {
+        if constexpr (has_usable_size<Small>) {
+            return m_small.usable_size(h) - sizeof(header);
+        } else {
+            return h->size;
+        }
+    }
+
+    static size_t page_size() noexcept {
+        static const size_t size = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+        return size;
+    }
+
+    size_t mapping_size(size_t size) const noexcept {
+        size_t granularity =
+            m_huge_pages == huge_pages::none ? page_size() : huge_page_size;
+        size_t total = sizeof(header) + size;
+        return (total + granularity - 1) / granularity * granularity;
+    }
+
+    void advise(void* addr, size_t size) const noexcept {
+#if defined(MADV_HUGEPAGE)
+        if (m_huge_pages != huge_pages::none) {
+            // only a hint, failure is harmless
+            (void)::madvise(addr, size, MADV_HUGEPAGE);
+        }
+#else
+        (void)addr;
+        (void)size;
+#endif
+    }
+
+    [[nodiscard]] void* map(size_t size) const noexcept {
+        void* addr = MAP_FAILED;
+#if defined(MAP_HUGETLB)
+        if (m_huge_pages == huge_pages::explicit_pool) {
+            addr = ::mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        }
+#endif
+        if (addr == MAP_FAILED) {
+            addr = ::mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (addr == MAP_FAILED) {
+                return nullptr;
+            }
+            advise(addr, size);
+        }
+        return addr;
+    }
+
+    [[nodiscard]] result<void*, out_of_memory> allocate_mapped(
+        size_t size) const noexcept {
+        size_t mapped = mapping_size(size);
+        void* addr = map(mapped);
+        if (!addr) {
+            return {out_of_memory{}};
+        }
+
+        auto* h = static_cast<header*>(addr);
+        h->mapped = mapped;
+        h->size = 0;
+        return {block_of(h)};
+    }
+
+    [[nodiscard]] result<void*, out_of_memory> allocate_small(
+        size_t size) noexcept {
+        auto res = m_small.allocate(sizeof(header) + size);
+        if (!res) {
+            return res;
+        }
+
+        auto* h = static_cast<header*>(res.ok());
+        h->mapped = 0;
+        h->size = size;
+        return {block_of(h)};
+    }
+
+    [[nodiscard]] result<void*, out_of_memory> remap(header* h,
+                                                     size_t size) noexcept {
+        size_t old_mapped = h->mapped;
+        size_t mapped = mapping_size(size);
+        if (mapped == old_mapped) {
+            return {block_of(h)};
+        }
+
+#if defined(__linux__)
+        void* addr = ::mremap(h, old_mapped, mapped, MREMAP_MAYMOVE);
+        if (addr != MAP_FAILED) {
+            if (mapped > old_mapped) {
+                advise(addr, mapped);
+            }
+
+            h = static_cast<header*>(addr);
+            h->mapped = mapped;
+            return {block_of(h)};
+        }
+        // mremap may refuse (e.g. a locked or special mapping); copy instead
+#endif
+        auto res = allocate_mapped(size);
+        if (res) {
+            std::memcpy(res.ok(), block_of(h),
+                        std::min(old_mapped, mapped) - sizeof(header));
+            ::munmap(h, old_mapped);
+        }
+        return res;
+    }
+
+public:
+    explicit mmap_allocator(size_t threshold = default_threshold,
+                            huge_pages huge = huge_pages::none,
+                            const Small& small = Small()) noexcept
+        : m_small(small),
+          m_threshold(threshold),
+          m_huge_pages(huge) {}
+
+    result<void*, out_of_memory> allocate(size_t size) noexcept {
+        assert(size > 0);
+
+        if (size >= m_threshold) {
+            return allocate_mapped(size);
+        } else {
+            return allocate_small(size);
+        }
+    }
+
+    result<void*, out_of_memory> reallocate(void* p, size_t new_size) noexcept {
+        assert(new_size > 0);
+
+        if (!p) {
+            return allocate(new_size);
+        }
+
+        header* h = header_of(p);
+        if (h->mapped) {
+            // once mapped, a block stays mapped
+            return remap(h, new_size);
+        }
+
+        if (new_size < m_threshold) {
+            auto res = m_small.reallocate(h, sizeof(header) + new_size);
+            if (res) {
+                h = static_cast<header*>(res.ok());
+                h->size = new_size;
+                return {block_of(h)};
+            }
+            return res;
+        }
+
+        auto res = allocate_mapped(new_size);
+        if (res) {
+            std::memcpy(res.ok(), p, small_size(h));
+            m_small.free(h);
+        }
+        return res;
+    }
+
+    void free(void* p) noexcept {
+        if (!p) {
+            return;
+        }
+
+        header* h = header_of(p);
+        if (h->mapped) {
+            ::munmap(h, h->mapped);
+        } else {
+            m_small.free(h);
+        }
+    }
+
+    size_t usable_size(void* p) const noexcept {
+        header* h = header_of(p);
+        return h->mapped ? h->mapped - sizeof(header) : small_size(h);
+    }
+
+    [[nodiscard]] bool is_mapped(void* p) const noexcept {
+        return p && header_of(p)->mapped != 0;
+    }
+};
+
+}  // namespace nestl
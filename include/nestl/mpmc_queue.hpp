@@ -0,0 +1,263 @@
+//
+// Copyright 2018 Marcin Radomski. All rights reserved.
+//
+// Licensed under the MIT license. See LICENSE file in the project root for
+// details.
+//
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+#include <atomic>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include <nestl/allocator.hpp>
+#include <nestl/detail/cache_line.hpp>
+#include <nestl/detail/futex.hpp>
+#include <nestl/queue_errors.hpp>
+#include <nestl/result.hpp>
+
+namespace nestl {
+
+/*
+ * Bounded lock-free queue for any number of producer and consumer threads,
+ * after Dmitry Vyukov's bounded MPMC queue.
+ *
+ * Every slot of the power-of-two ring carries a sequence number telling
+ * whether it is ready to be written or read at the current lap, so
+ * producers and consumers only contend on their own position counter, with
+ * a single CAS per operation.
+ *
+ * try_push()/try_pop() never block. push()/pop() wait on a futex while the
+ * queue is full/empty; the other side only issues a wake-up syscall if some
+ * thread is actually waiting.
+ */
+template <typename T, typename Allocator = system_allocator>
+class mpmc_queue {
+    static_assert(std::is_nothrow_move_constructible_v<T>,
+                  "popping an element must not throw");
+
+    struct cell {
+        std::atomic<size_t> seq;
+        alignas(T) unsigned char data[sizeof(T)];
+
+        T* get() noexcept { return reinterpret_cast<T*>(data); }
+    };
+
+    // threads waiting for one side of the queue
+    struct alignas(detail::cache_line_size) waiters {
+        // bumped, and all waiters woken, whenever they may proceed
+        std::atomic<uint32_t> epoch{0};
+        // threads registered since the last wake-up
+        std::atomic<uint32_t> count{0};
+    };
+
+    // read-only once init() returns
+    Allocator m_allocator;
+    cell* m_cells = nullptr;
+    size_t m_mask = 0;
+
+    alignas(detail::cache_line_size) std::atomic<size_t> m_push_pos{0};
+    alignas(detail::cache_line_size) std::atomic<size_t> m_pop_pos{0};
+
+    waiters m_push_waiters;
+    waiters m_pop_waiters;
+
+    static constexpr int spins_before_wait = 64;
+
+    /*
+     * Slot sequence numbers and waiter counts are accessed with seq_cst
+     * operations, so that a waiter registering itself and then checking a
+     * slot, and a thread updating the slot and then checking for waiters,
+     * cannot both miss each other.
+     */
+    static constexpr auto seq_cst = std::memory_order_seq_cst;
+
+    /*
+     * Wakes everyone waiting on w. The registrations are consumed, so
+     * further notifications skip the syscall until a thread waits again.
+     */
+    static void notify(waiters& w) noexcept {
+        if (w.count.load(seq_cst) > 0 && w.count.exchange(0, seq_cst) > 0) {
+            w.epoch.fetch_add(1, std::memory_order_release);
+            detail::futex_wake_all(w.epoch);
+        }
+    }
+
+    template <typename TryOp>
+    static auto wait(waiters& w, TryOp try_op) noexcept {
+        for (int i = 0; i < spins_before_wait; ++i) {
+            if (auto res = try_op()) {
+                return res;
+            }
+        }
+
+        for (;;) {
+            uint32_t epoch = w.epoch.load(std::memory_order_acquire);
+            w.count.fetch_add(1, seq_cst);
+            if (auto res = try_op()) {
+                return res;
+            }
+            detail::futex_wait(w.epoch, epoch);
+        }
+    }
+
+public:
+    mpmc_queue(const Allocator& alloc = Allocator()) noexcept
+        : m_allocator(alloc) {}
+
+    ~mpmc_queue() {
+        if (m_cells) {
+            while (try_pop()) {
+            }
+        }
+        m_allocator.free(m_cells);
+    }
+
+    // the threads refer to the queue by address
+    mpmc_queue(mpmc_queue&&) = delete;
+    mpmc_queue& operator=(mpmc_queue&&) = delete;
+    mpmc_queue(const mpmc_queue&) = delete;
+    mpmc_queue& operator=(const mpmc_queue&) = delete;
+
+    /*
+     * Allocates room for at least min_capacity elements, rounded up to a
+     * power of two of at least 2. Has to be called once, before the queue is
+     * shared with other threads.
+     */
+    [[nodiscard]] result<void, out_of_memory> init(
+        size_t min_capacity) noexcept {
+        assert(m_cells == nullptr);
+        assert(min_capacity > 0);
+
+        size_t cap = 2;
+        while (cap < min_capacity) {
+            cap *= 2;
+        }
+
+        auto res = m_allocator.allocate(cap * sizeof(cell));
+        if (!res) {
+            return {res.err()};
+        }
+
+        m_cells = static_cast<cell*>(res.ok());
+        for (size_t i = 0; i < cap; ++i) {
+            new (&m_cells[i].seq) std::atomic<size_t>(i);
+        }
+        m_mask = cap - 1;
+        return {ok_t{}};
+    }
+
+    [[nodiscard]] size_t capacity() const noexcept {
+        return m_cells ? m_mask + 1 : 0;
+    }
+
+    /*
+     * Number of elements in the queue at some point during the call.
+     */
+    [[nodiscard]] size_t size_approx() const noexcept {
+        size_t pop = m_pop_pos.load(std::memory_order_acquire);
+        size_t push = m_push_pos.load(std::memory_order_acquire);
+        return push > pop ? push - pop : 0;
+    }
+
+    template <typename... Args>
+    result<void, queue_full> try_emplace(Args&&... args) noexcept {
+        if (m_cells == nullptr) {
+            // not initialized: no room for anything
+            return {queue_full{}};
+        }
+
+        size_t pos = m_push_pos.load(std::memory_order_relaxed);
+        cell* c;
+        for (;;) {
+            c = &m_cells[pos & m_mask];
+            size_t seq = c->seq.load(seq_cst);
+            auto diff =
+                static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (m_push_pos.compare_exchange_weak(
+                        pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                // the slot still holds the element from the previous lap
+                return {queue_full{}};
+            } else {
+                pos = m_push_pos.load(std::memory_order_relaxed);
+            }
+        }
+
+        new (c->get()) T(std::forward<Args>(args)...);
+        c->seq.store(pos + 1, seq_cst);
+        notify(m_pop_waiters);
+        return {ok_t{}};
+    }
+
+    result<void, queue_full> try_push(const T& e) noexcept {
+        return try_emplace(e);
+    }
+
+    result<void, queue_full> try_push(T&& e) noexcept {
+        return try_emplace(std::move(e));
+    }
+
+    result<T, queue_empty> try_pop() noexcept {
+        if (m_cells == nullptr) {
+            return {queue_empty{}};
+        }
+
+        size_t pos = m_pop_pos.load(std::memory_order_relaxed);
+        cell* c;
+        for (;;) {
+            c = &m_cells[pos & m_mask];
+            size_t seq = c->seq.load(seq_cst);
+            auto diff =
+                static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+            if (diff == 0) {
+                if (m_pop_pos.compare_exchange_weak(
+                        pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                // the slot has not been written at this lap yet
+                return {queue_empty{}};
+            } else {
+                pos = m_pop_pos.load(std::memory_order_relaxed);
+            }
+        }
+
+        result<T, queue_empty> res{std::move(*c->get())};
+        c->get()->~T();
+        c->seq.store(pos + m_mask + 1, seq_cst);
+        notify(m_push_waiters);
+        return res;
+    }
+
+    /*
+     * Pushes e, waiting for room if the queue is full. The queue has to be
+     * initialized, or this would wait forever.
+     */
+    void push(T e) noexcept {
+        assert(m_cells != nullptr);
+        (void)wait(m_push_waiters, [this, &e] {
+            return try_emplace(std::move(e));
+        });
+    }
+
+    /*
+     * Pops an element, waiting for one if the queue is empty. The queue has
+     * to be initialized, or this would wait forever.
+     */
+    T pop() noexcept {
+        assert(m_cells != nullptr);
+        auto res = wait(m_pop_waiters, [this] { return try_pop(); });
+        return std::move(res.ok());
+    }
+};
+
+}  // namespace nestl
@@ -0,0 +1,388 @@
+//
+// Copyright 2018 Marcin Radomski. All rights reserved.
+//
+// Licensed under the MIT license. See LICENSE file in the project root for
+// details.
+//
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include <nestl/allocator.hpp>
+#include <nestl/result.hpp>
+#include <nestl/static_vector.hpp>
+#include <nestl/thread_pool.hpp>
+#include <nestl/vector.hpp>
+
+namespace nestl {
+namespace par {
+
+/*
+ * Parallel algorithms over contiguous ranges, running on a thread_pool.
+ *
+ * Ranges are split into chunks of about chunk_bytes, which the calling
+ * thread and up to one helper task per pool worker take from a shared
+ * counter, so uneven chunks balance out. The calling thread always takes
+ * part, so the algorithms also complete if the pool could not allocate
+ * the helper tasks, just on fewer threads; only sort() needs memory it
+ * cannot do without.
+ */
+inline constexpr size_t chunk_bytes = 32 * 1024;
+
+namespace detail {
+
+inline constexpr size_t max_helpers = 64;
+
+template <typename T>
+constexpr size_t chunk_elements() noexcept {
+    return std::max<size_t>(1, chunk_bytes / sizeof(T));
+}
+
+// Result of a helper that did not get any chunk.
+class no_chunk {};
+
+/*
+ * Runs work() on the calling thread and on up to `helpers` pool tasks,
+ * passing every result to combine().
+ */
+template <typename Pool, typename Work, typename Combine>
+void run_shared(Pool& pool, size_t helpers, Work& work,
+                Combine&& combine) noexcept {
+    using R = std::invoke_result_t<Work&>;
+    static_vector<future<R>, max_helpers> futures;
+
+    helpers = std::min({helpers, pool.thread_count(), max_helpers});
+    for (size_t i = 0; i < helpers; ++i) {
+        auto res = pool.submit([&work] { return work(); });
+        if (!res) {
+            break;
+        }
+        // cannot fail, there is room for max_helpers
+        (void)futures.emplace_back(std::move(res.ok()));
+    }
+
+    if constexpr (std::is_void_v<R>) {
+        work();
+        for (auto& f : futures) {
+            f.get();
+        }
+    } else {
+        combine(work());
+        for (auto& f : futures) {
+            combine(f.get());
+        }
+    }
+}
+
+/*
+ * Calls body(begin, end) for consecutive chunks of [0, count), in parallel.
+ */
+template <typename Pool, typename Body>
+void for_each_chunk(Pool& pool, size_t count, size_t chunk,
+                    Body&& body) noexcept {
+    if (count == 0) {
+        return;
+    }
+
+    std::atomic<size_t> next{0};
+    auto work = [&] {
+        for (;;) {
+            size_t begin = next.fetch_add(chunk, std::memory_order_relaxed);
+            if (begin >= count) {
+                return;
+            }
+            body(begin, std::min(count, begin + chunk));
+        }
+    };
+    size_t chunks = (count + chunk - 1) / chunk;
+    run_shared(pool, chunks - 1, work, [] {});
+}
+
+/*
+ * Number of elements of a that come first among the first d elements of
+ * the merge of a and b.
+ */
+template <typename T, typename Compare>
+size_t merge_split(const T* a, size_t a_len, const T* b, size_t b_len,
+                   size_t d, Compare& comp) noexcept {
+    size_t lo = d > b_len ? d - b_len : 0;
+    size_t hi = std::min(d, a_len);
+    while (lo < hi) {
+        size_t i = lo + (hi - lo) / 2;
+        if (comp(b[d - i - 1], a[i])) {
+            hi = i;
+        } else {
+            lo = i + 1;
+        }
+    }
+    return lo;
+}
+
+/*
+ * Merges [a, a_end) and [b, b_end) into out by moving. If Construct, out is
+ * raw memory, otherwise it holds live objects that are assigned to.
+ */
+template <bool Construct, typename T, typename Compare>
+void merge_move(T* a, T* a_end, T* b, T* b_end, T* out,
+                Compare& comp) noexcept {
+    auto put = [&out](T& e) {
+        if constexpr (Construct) {
+            new (out) T(std::move(e));
+        } else {
+            *out = std::move(e);
+        }
+        ++out;
+    };
+
+    while (a != a_end && b != b_end) {
+        if (comp(*b, *a)) {
+            put(*b++);
+        } else {
+            put(*a++);
+        }
+    }
+    for (; a != a_end; ++a) {
+        put(*a);
+    }
+    for (; b != b_end; ++b) {
+        put(*b);
+    }
+}
+
+/*
+ * Merges pairs of sorted runs of `width` elements from src into dst, in
+ * parallel chunks of the output.
+ *
+ * The split of every chunk boundary is found before anything is moved, as
+ * the moved-from elements of src are not comparable anymore. splits has to
+ * hold one entry per chunk.
+ */
+template <bool Construct, typename Pool, typename T, typename Compare>
+void merge_round(Pool& pool, T* src, T* dst, size_t count, size_t width,
+                 size_t chunk, size_t* splits, Compare& comp) noexcept {
+    struct pair_bounds {
+        size_t begin;
+        size_t mid;
+        size_t end;
+    };
+    auto pair_of = [&](size_t i) {
+        size_t begin = i / (2 * width) * (2 * width);
+        return pair_bounds{begin, std::min(count, begin + width),
+                           std::min(count, begin + 2 * width)};
+    };
+
+    for (size_t i = 0; i * chunk < count; ++i) {
+        auto p = pair_of(i * chunk);
+        splits[i] = merge_split(src + p.begin, p.mid - p.begin, src + p.mid,
+                                p.end - p.mid, i * chunk - p.begin, comp);
+    }
+
+    for_each_chunk(pool, count, chunk, [&](size_t begin, size_t end) {
+        size_t a_lo = splits[begin / chunk];
+        while (begin < end) {
+            auto p = pair_of(begin);
+            size_t hi = std::min(end, p.end);
+            size_t a_hi = hi == p.end ? p.mid - p.begin : splits[hi / chunk];
+
+            T* a = src + p.begin;
+            T* b = src + p.mid;
+            size_t b_lo = begin - p.begin - a_lo;
+            size_t b_hi = hi - p.begin - a_hi;
+            merge_move<Construct>(a + a_lo, a + a_hi, b + b_lo, b + b_hi,
+                                  dst + begin, comp);
+            begin = hi;
+            a_lo = 0;
+        }
+    });
+}
+
+}  // namespace detail
+
+/*
+ * Calls f(e) for every element of [first, last).
+ */
+template <typename Pool, typename T, typename F>
+void for_each(Pool& pool, T* first, T* last, F f) noexcept {
+    detail::for_each_chunk(pool, static_cast<size_t>(last - first),
+                           detail::chunk_elements<T>(),
+                           [&](size_t begin, size_t end) {
+                               std::for_each(first + begin, first + end, f);
+                           });
+}
+
+template <typename Pool, typename T, typename Allocator,
+          typename GrowthPolicy, typename F>
+void for_each(Pool& pool, vector<T, Allocator, GrowthPolicy>& v,
+              F f) noexcept {
+    for_each(pool, v.begin(), v.end(), std::move(f));
+}
+
+/*
+ * Assigns f(*(first + i)) to *(out + i) for every element of
+ * [first, last). out has to hold last - first live elements.
+ */
+template <typename Pool, typename T, typename U, typename F>
+void transform(Pool& pool, const T* first, const T* last, U* out,
+               F f) noexcept {
+    detail::for_each_chunk(pool, static_cast<size_t>(last - first),
+                           detail::chunk_elements<T>(),
+                           [&](size_t begin, size_t end) {
+                               std::transform(first + begin, first + end,
+                                              out + begin, f);
+                           });
+}
+
+template <typename Pool, typename T, typename AllocT, typename GrowthT,
+          typename U, typename AllocU, typename GrowthU, typename F>
+void transform(Pool& pool, const vector<T, AllocT, GrowthT>& in,
+               vector<U, AllocU, GrowthU>& out, F f) noexcept {
+    assert(out.size() >= in.size());
+    transform(pool, in.begin(), in.end(), out.begin(), std::move(f));
+}
+
+/*
+ * Combines init and all elements of [first, last) with op, which has to be
+ * associative and commutative: elements are combined in unspecified order.
+ */
+template <typename Pool, typename T, typename BinaryOp = std::plus<>>
+T reduce(Pool& pool, const T* first, const T* last, T init,
+         BinaryOp op = BinaryOp()) noexcept {
+    size_t count = static_cast<size_t>(last - first);
+    size_t chunk = detail::chunk_elements<T>();
+    if (count == 0) {
+        return init;
+    }
+
+    std::atomic<size_t> next{0};
+    auto work = [&]() -> result<T, detail::no_chunk> {
+        size_t begin = next.fetch_add(chunk, std::memory_order_relaxed);
+        if (begin >= count) {
+            return {detail::no_chunk{}};
+        }
+
+        T acc = first[begin];
+        for (;;) {
+            size_t end = std::min(count, begin + chunk);
+            for (size_t i = begin + 1; i < end; ++i) {
+                acc = op(std::move(acc), first[i]);
+            }
+
+            begin = next.fetch_add(chunk, std::memory_order_relaxed);
+            if (begin >= count) {
+                return {std::move(acc)};
+            }
+            acc = op(std::move(acc), first[begin]);
+        }
+    };
+
+    T total = std::move(init);
+    detail::run_shared(pool, (count + chunk - 1) / chunk - 1, work,
+                       [&](result<T, detail::no_chunk>&& partial) {
+                           if (partial) {
+                               total = op(std::move(total),
+                                          std::move(partial.ok()));
+                           }
+                       });
+    return total;
+}
+
+template <typename Pool, typename T, typename Allocator,
+          typename GrowthPolicy, typename BinaryOp = std::plus<>>
+T reduce(Pool& pool, const vector<T, Allocator, GrowthPolicy>& v, T init,
+         BinaryOp op = BinaryOp()) noexcept {
+    return reduce(pool, v.begin(), v.end(), std::move(init), std::move(op));
+}
+
+/*
+ * Sorts [first, last) with comp. Not stable.
+ *
+ * Blocks of the range, one per worker, are sorted with std::sort in
+ * parallel, then merged pairwise through a scratch buffer of last - first
+ * elements, every merge split between all threads. The scratch buffer
+ * comes from the pool's allocator; if it cannot be allocated, the range is
+ * left unchanged.
+ */
+template <typename Pool, typename T, typename Compare = std::less<>>
+result<void, out_of_memory> sort(Pool& pool, T* first, T* last,
+                                 Compare comp = Compare()) noexcept {
+    static_assert(std::is_nothrow_move_constructible_v<T>
+                  && std::is_nothrow_move_assignable_v<T>);
+    static_assert(alignof(T) <= alignof(std::max_align_t));
+
+    // smallest block worth sorting on its own thread
+    constexpr size_t min_block = 16 * 1024;
+
+    auto count = static_cast<size_t>(last - first);
+    size_t blocks = 1;
+    while (blocks < pool.thread_count() && count / (blocks * 2) >= min_block) {
+        blocks *= 2;
+    }
+    if (blocks == 1) {
+        std::sort(first, last, comp);
+        return {ok_t{}};
+    }
+
+    // scratch elements, followed by the merge split points
+    size_t chunk = std::max(detail::chunk_elements<T>(),
+                            count / (pool.thread_count() * 4));
+    size_t chunks = (count + chunk - 1) / chunk;
+    size_t splits_offset = (count * sizeof(T) + alignof(size_t) - 1)
+                           / alignof(size_t) * alignof(size_t);
+
+    auto alloc = pool.get_allocator();
+    auto mem = alloc.allocate(splits_offset + chunks * sizeof(size_t));
+    if (!mem) {
+        return {mem.err()};
+    }
+    T* scratch = static_cast<T*>(mem.ok());
+    auto* splits = reinterpret_cast<size_t*>(static_cast<char*>(mem.ok())
+                                             + splits_offset);
+
+    size_t width = (count + blocks - 1) / blocks;
+    detail::for_each_chunk(pool, count, width, [&](size_t begin, size_t end) {
+        std::sort(first + begin, first + end, comp);
+    });
+
+    // the first round constructs the scratch objects, later rounds assign
+    detail::merge_round<true>(pool, first, scratch, count, width, chunk,
+                              splits, comp);
+    T* src = scratch;
+    T* dst = first;
+    for (width *= 2; width < count; width *= 2) {
+        detail::merge_round<false>(pool, src, dst, count, width, chunk,
+                                   splits, comp);
+        std::swap(src, dst);
+    }
+
+    detail::for_each_chunk(
+        pool, count, detail::chunk_elements<T>(),
+        [&](size_t begin, size_t end) {
+            if (src == scratch) {
+                std::move(scratch + begin, scratch + end, first + begin);
+            }
+            for (size_t i = begin; i < end; ++i) {
+                scratch[i].~T();
+            }
+        });
+    alloc.free(scratch);
+    return {ok_t{}};
+}
+
+template <typename Pool, typename T, typename Allocator,
+          typename GrowthPolicy, typename Compare = std::less<>>
+result<void, out_of_memory> sort(Pool& pool,
+                                 vector<T, Allocator, GrowthPolicy>& v,
+                                 Compare comp = Compare()) noexcept {
+    return sort(pool, v.begin(), v.end(), std::move(comp));
+}
+
+}  // namespace par
+}  // namespace nestl
@@ -0,0 +1,229 @@
+//
+// Copyright 2018 Marcin Radomski. All rights reserved.
+//
+// Licensed under the MIT license. See LICENSE file in the project root for
+// details.
+//
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <nestl/allocator.hpp>
+#include <nestl/result.hpp>
+
+namespace nestl {
+
+/*
+ * Size-class slab allocator.
+ *
+ * A single region of `capacity` bytes is requested from Backing on first use
+ * and split into slabs of `slab_size` bytes. Each slab serves blocks of a
+ * single power-of-two size class (min_block_size .. slab_size), and freed
+ * blocks go to a per-class free list. Slabs are never returned to the
+ * region, and nothing is allocated from Backing after the region - once it is
+ * exhausted, allocate() reports out_of_memory.
+ *
+ * Blocks carry no header: the size class is looked up from the slab a block
+ * belongs to.
+ */
+template <typename Backing = system_allocator>
+class slab_pool {
+public:
+    static constexpr size_t min_block_size = 16;
+    static constexpr size_t default_slab_size = 64 * 1024;
+
+private:
+    static constexpr size_t min_block_shift = 4;
+    static constexpr size_t max_classes = 32;
+    static_assert(size_t{1} << min_block_shift == min_block_size);
+
+    struct free_block {
+        free_block* next;
+    };
+
+    Backing m_backing;
+    size_t m_slab_size;
+    size_t m_slab_count;
+    size_t m_num_classes;
+
+    void* m_region = nullptr;
+    unsigned char* m_slabs = nullptr;
+    uint8_t* m_slab_class = nullptr;
+    size_t m_next_slab = 0;
+
+    free_block* m_free[max_classes] = {};
+    unsigned char* m_bump[max_classes] = {};
+    unsigned char* m_bump_end[max_classes] = {};
+
+    static size_t size_class(size_t size) noexcept {
+        size_t c = 0;
+        while ((min_block_size << c) < size) {
+            ++c;
+        }
+        return c;
+    }
+
+    static size_t class_size(size_t c) noexcept { return min_block_size << c; }
+
+    size_t slab_index(const void* p) const noexcept {
+        auto* block = static_cast<const unsigned char*>(p);
+        assert(m_slabs <= block);
+        assert(block < m_slabs + m_slab_size * m_slab_count);
+        return static_cast<size_t>(block - m_slabs) / m_slab_size;
+    }
+
+    [[nodiscard]] result<void, out_of_memory> init() {
+        if (m_slab_count == 0) {
+            return {out_of_memory{}};
+        }
+
+        // slab class table goes after the slabs to keep them aligned
+        size_t size = m_slab_size * m_slab_count + m_slab_count;
+        if (auto res = m_backing.allocate(size)) {
+            m_region = res.ok();
+            m_slabs = static_cast<unsigned char*>(m_region);
+            m_slab_class = m_slabs + m_slab_size * m_slab_count;
+            return {ok_t{}};
+        } else {
+            return {std::move(res).err()};
+        }
+    }
+
+public:
+    explicit slab_pool(size_t capacity, size_t slab_size = default_slab_size,
+                       const Backing& backing = Backing()) noexcept
+        : m_backing(backing),
+          m_slab_size(slab_size),
+          m_slab_count(capacity / slab_size),
+          m_num_classes(size_class(slab_size) + 1) {
+        assert(slab_size >= min_block_size);
+        assert((slab_size & (slab_size - 1)) == 0);
+        assert(m_num_classes <= max_classes);
+    }
+
+    ~slab_pool() noexcept {
+        if (m_region) {
+            m_backing.free(m_region);
+        }
+    }
+
+    // allocators refer to the pool by pointer
+    slab_pool(slab_pool&&) = delete;
+    slab_pool& operator=(slab_pool&&) = delete;
+    slab_pool(const slab_pool&) = delete;
+    slab_pool& operator=(const slab_pool&) = delete;
+
+    [[nodiscard]] size_t max_block_size() const noexcept { return m_slab_size; }
+
+    result<void*, out_of_memory> allocate(size_t size) noexcept {
+        assert(size > 0);
+
+        if (size > m_slab_size) {
+            return {out_of_memory{}};
+        }
+        if (!m_region) {
+            if (auto res = init(); !res) {
+                return {res.err()};
+            }
+        }
+
+        size_t c = size_class(size);
+        if (free_block* block = m_free[c]) {
+            m_free[c] = block->next;
+            return {static_cast<void*>(block)};
+        }
+
+        if (m_bump[c] == m_bump_end[c]) {
+            if (m_next_slab == m_slab_count) {
+                return {out_of_memory{}};
+            }
+
+            m_slab_class[m_next_slab] = static_cast<uint8_t>(c);
+            m_bump[c] = m_slabs + m_next_slab * m_slab_size;
+            m_bump_end[c] = m_bump[c] + m_slab_size;
+            ++m_next_slab;
+        }
+
+        void* p = m_bump[c];
+        m_bump[c] += class_size(c);
+        return {p};
+    }
+
+    result<void*, out_of_memory> reallocate(void* p, size_t new_size) noexcept {
+        assert(new_size > 0);
+
+        if (!p) {
+            return allocate(new_size);
+        }
+
+        size_t old_size = class_size(m_slab_class[slab_index(p)]);
+        if (new_size <= old_size) {
+            return {p};
+        }
+
+        if (auto res = allocate(new_size)) {
+            std::memcpy(res.ok(), p, old_size);
+            free(p);
+            return {res.ok()};
+        } else {
+            return {std::move(res).err()};
+        }
+    }
+
+    void free(void* p) noexcept {
+        if (!p) {
+            return;
+        }
+
+        size_t c = m_slab_class[slab_index(p)];
+        auto* block = static_cast<free_block*>(p);
+        block->next = m_free[c];
+        m_free[c] = block;
+    }
+};
+
+/*
+ * Lightweight handle to a slab_pool, suitable as the Allocator parameter of
+ * nestl containers. The pool must outlive every container using it.
+ */
+template <typename Backing = system_allocator>
+class pool_allocator {
+    slab_pool<Backing>* m_pool = nullptr;
+
+public:
+    pool_allocator() noexcept = default;
+    pool_allocator(slab_pool<Backing>& pool) noexcept : m_pool(&pool) {}
+
+    result<void*, out_of_memory> allocate(size_t size) noexcept {
+        if (!m_pool) {
+            return {out_of_memory{}};
+        }
+        return m_pool->allocate(size);
+    }
+
+    result<void*, out_of_memory> reallocate(void* p, size_t new_size) noexcept {
+        if (!m_pool) {
+            return {out_of_memory{}};
+        }
+        return m_pool->reallocate(p, new_size);
+    }
+
+    void free(void* p) noexcept {
+        if (m_pool) {
+            m_pool->free(p);
+        }
+    }
+
+    [[nodiscard]] bool operator==(const pool_allocator& other) const noexcept {
+        return m_pool == other.m_pool;
+    }
+
+    [[nodiscard]] bool operator!=(const pool_allocator& other) const noexcept {
+        return !(*this == other);
+    }
+};
+
+}  // namespace nestl
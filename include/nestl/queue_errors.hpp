@@ -0,0 +1,14 @@
+//
+// Copyright 2018 Marcin Radomski. All rights reserved.
+//
+// Licensed under the MIT license. See LICENSE file in the project root for
+// details.
+//
+#pragma once
+
+namespace nestl {
+
+class queue_full {};
+class queue_empty {};
+
+}  // namespace nestl
@@ -7,6 +7,10 @@
 #pragma once
 
 #include <cassert>
+#include <cstdint>
+#include <cstring>
+
+#include <functional>
 #include <type_traits>
 #include <utility>
 
@@ -21,6 +25,74 @@ struct err_t {};
 template <typename T, typename E>
 class result;
 
+/*
+ * Describes a bit pattern that no valid T ever has. result<T, E> with an
+ * empty E stores it in place of T to mark the Err state, instead of keeping
+ * a separate flag.
+ *
+ * Specializations set `available` and provide:
+ *   static void set(void* p) noexcept - writes the pattern to p
+ *   static bool is_set(const void* p) noexcept
+ * where p points to sizeof(T) bytes of storage.
+ */
+template <typename T>
+struct niche_traits {
+    static constexpr bool available = false;
+};
+
+/*
+ * An all-ones address could only be the end of an object that occupies the
+ * very top of the address space, which no allocator hands out. A T* in
+ * general may still hold it (MAP_FAILED, sentinel or tagged pointers), so
+ * result<T*, E> only uses this niche if E opts in through
+ * pointer_niche_allowed.
+ */
+template <typename T>
+struct niche_traits<T*> {
+    static_assert(sizeof(T*) == sizeof(uintptr_t));
+
+    static constexpr bool available = true;
+    static constexpr uintptr_t pattern = ~uintptr_t{0};
+
+    static void set(void* p) noexcept {
+        std::memcpy(p, &pattern, sizeof(pattern));
+    }
+
+    static bool is_set(const void* p) noexcept {
+        uintptr_t value;
+        std::memcpy(&value, p, sizeof(value));
+        return value == pattern;
+    }
+};
+
+// reference_wrapper is never null
+template <typename T>
+struct niche_traits<std::reference_wrapper<T>> {
+    static_assert(sizeof(std::reference_wrapper<T>) == sizeof(T*));
+
+    static constexpr bool available = true;
+
+    static void set(void* p) noexcept {
+        T* null = nullptr;
+        std::memcpy(p, &null, sizeof(null));
+    }
+
+    static bool is_set(const void* p) noexcept {
+        T* ptr;
+        std::memcpy(&ptr, p, sizeof(ptr));
+        return ptr == nullptr;
+    }
+};
+
+/*
+ * Error types whose results only ever carry pointers returned by an
+ * allocator, such as out_of_memory. For them, result<T*, E> is as small as
+ * T*, and an Ok value equal to the all-ones niche is a precondition
+ * violation.
+ */
+template <typename E>
+struct pointer_niche_allowed : std::false_type {};
+
 namespace detail {
 
 template <typename T, typename E>
@@ -30,63 +102,178 @@ using result_storage = std::conditional_t<
     std::conditional_t<std::is_void_v<E>, storage<T>, storage<T, E>>>;
 
 template <typename T, typename E>
-class result_base : protected result_storage<T, E> {
+constexpr bool uses_niche = [] {
+    if constexpr (std::is_void_v<T> || std::is_void_v<E>) {
+        return false;
+    } else {
+        return niche_traits<T>::available
+               && (!std::is_pointer_v<T> || pointer_niche_allowed<E>::value)
+               && std::is_empty_v<E> && std::is_trivially_copyable_v<E>;
+    }
+}();
+
+/*
+ * Storage plus the Ok/Err discriminant: a bool after the value, or, if T
+ * has a niche and E carries no data, the niche value in place of T.
+ * set_ok() has to be called after constructing the value.
+ */
+template <typename T, typename E, bool Niche = uses_niche<T, E>>
+class result_tag : protected result_storage<T, E> {
+    bool m_is_ok;
+
+protected:
+    result_tag() noexcept = default;
+
+    template <typename U, typename... Args>
+    result_tag(tag<U> t, Args&&... args) noexcept
+        : result_storage<T, E>(t, std::forward<Args>(args)...) {}
+
+    void set_ok(bool ok) noexcept { m_is_ok = ok; }
+
+public:
+    [[nodiscard]] bool is_ok() const noexcept { return m_is_ok; }
+};
+
+template <typename T, typename E>
+class result_tag<T, E, true> : protected result_storage<T, E> {
+protected:
+    result_tag() noexcept = default;
+
+    template <typename U, typename... Args>
+    result_tag(tag<U> t, Args&&... args) noexcept
+        : result_storage<T, E>(t, std::forward<Args>(args)...) {}
+
+    void set_ok(bool ok) noexcept {
+        if (!ok) {
+            niche_traits<T>::set(this->data);
+        } else {
+            // the value would read back as Err
+            assert(!niche_traits<T>::is_set(this->data));
+        }
+    }
+
+public:
+    [[nodiscard]] bool is_ok() const noexcept {
+        return !niche_traits<T>::is_set(this->data);
+    }
+};
+
+template <typename T, typename E>
+class result_core : public result_tag<T, E> {
 protected:
     class void_t {};
 
-    bool m_is_ok;
+    result_core() noexcept = default;
 
-    result_base(ok_t, void_t) : m_is_ok(true) {}
-    result_base(err_t, void_t) : m_is_ok(false) {}
+    result_core(ok_t, void_t) noexcept { this->set_ok(true); }
+    result_core(err_t, void_t) noexcept { this->set_ok(false); }
 
-    result_base(result<T, E>&& r) noexcept
-        : result_storage<T, E>(),
-          m_is_ok(r.is_ok()) {
-        using storage = result_storage<T, E>;
+    template <typename... Args>
+    result_core(ok_t, Args&&... args) noexcept
+        : result_tag<T, E>(tag<T>{}, std::forward<Args>(args)...) {
+        this->set_ok(true);
+    }
 
-        if (m_is_ok) {
+    template <typename... Args>
+    result_core(err_t, Args&&... args) noexcept
+        : result_tag<T, E>(tag<E>{}, std::forward<Args>(args)...) {
+        this->set_ok(false);
+    }
+
+    void destruct() noexcept {
+        if (this->is_ok()) {
+            this->template destroy<T>();
+        } else {
+            this->template destroy<E>();
+        }
+    }
+
+    // expects *this to hold no value
+    void move_from(result_core&& r) noexcept {
+        bool ok = r.is_ok();
+        if (ok) {
             if constexpr (!std::is_void_v<T>) {
-                new (static_cast<storage*>(this)) storage{tag<T>{}, std::move(r).ok()};
+                new (this->data) T(std::move(r).template as<T>());
             }
         } else {
             if constexpr (!std::is_void_v<E>) {
-                new (static_cast<storage*>(this)) storage{tag<E>{}, std::move(r).err()};
+                new (this->data) E(std::move(r).template as<E>());
             }
         }
+        this->set_ok(ok);
     }
 
-    template <typename... Args>
-    result_base(ok_t, Args&&... args) noexcept
-        : result_storage<T, E>(tag<T>{}, std::forward<Args>(args)...),
-          m_is_ok(true) {}
+public:
+    [[nodiscard]] bool is_err() const noexcept { return !this->is_ok(); }
 
-    template <typename... Args>
-    result_base(err_t, Args&&... args) noexcept
-        : result_storage<T, E>(tag<E>{}, std::forward<Args>(args)...),
-          m_is_ok(false) {}
+    [[nodiscard]] operator bool() const noexcept { return this->is_ok(); }
+};
+
+template <typename T>
+constexpr bool is_trivially_destructible_or_void =
+    std::is_void_v<T> || std::is_trivially_destructible_v<T>;
+
+template <typename T>
+constexpr bool is_trivially_copyable_or_void =
+    std::is_void_v<T> || std::is_trivially_copyable_v<T>;
+
+/*
+ * The destructor is trivial if both T and E are trivially destructible.
+ */
+template <typename T, typename E,
+          bool Trivial = is_trivially_destructible_or_void<T>
+                         && is_trivially_destructible_or_void<E>>
+class result_destroy_layer : public result_core<T, E> {
+protected:
+    using result_core<T, E>::result_core;
+};
+
+template <typename T, typename E>
+class result_destroy_layer<T, E, false> : public result_core<T, E> {
+protected:
+    using result_core<T, E>::result_core;
 
 public:
-    result_base(result_base&& r) noexcept = default;
-    result_base& operator=(result_base&& r) noexcept = default;
+    ~result_destroy_layer() noexcept { this->destruct(); }
+};
 
-    result_base(const result_base& r) = delete;
-    result_base& operator=(const result_base& r) = delete;
+/*
+ * Moves are trivial if both T and E are trivially copyable, so that such
+ * results can be passed and returned in registers.
+ */
+template <typename T, typename E,
+          bool Trivial = is_trivially_copyable_or_void<T>
+                         && is_trivially_copyable_or_void<E>>
+class result_move_layer : public result_destroy_layer<T, E> {
+protected:
+    using result_destroy_layer<T, E>::result_destroy_layer;
+};
 
-    ~result_base() noexcept {
-        if (is_ok()) {
-            this->template destroy<T>();
-        } else {
-            this->template destroy<E>();
-        }
-    }
+template <typename T, typename E>
+class result_move_layer<T, E, false> : public result_destroy_layer<T, E> {
+protected:
+    using result_destroy_layer<T, E>::result_destroy_layer;
 
-    [[nodiscard]] bool is_ok() const noexcept { return m_is_ok; }
+public:
+    result_move_layer(result_move_layer&& r) noexcept {
+        this->move_from(std::move(r));
+    }
 
-    [[nodiscard]] bool is_err() const noexcept { return !is_ok(); }
+    result_move_layer& operator=(result_move_layer&& r) noexcept {
+        if (this != &r) {
+            this->destruct();
+            this->move_from(std::move(r));
+        }
+        return *this;
+    }
 
-    [[nodiscard]] operator bool() const noexcept { return is_ok(); }
+    result_move_layer(const result_move_layer&) = delete;
+    result_move_layer& operator=(const result_move_layer&) = delete;
 };
 
+template <typename T, typename E>
+using result_base = result_move_layer<T, E>;
+
 template <typename Self, typename T, typename E, typename Base>
 class with_void_ok;
 template <typename Self, typename T, typename E, typename Base>
@@ -333,27 +520,8 @@ public:
     result(Args&&... args) noexcept
         : detail::choose_ok<T, E>(std::forward<Args>(args)...) {}
 
-    result(result&& r) noexcept : detail::choose_ok<T, E>(std::move(r)) {}
-    result& operator=(result&& r) noexcept {
-        if (this != &r) {
-            this->~result();
-
-            if (r.is_ok()) {
-                if constexpr (std::is_void_v<T>) {
-                    new(this) result{ok_t{}};
-                } else {
-                    new(this) result{ok_t{}, std::move(r).ok()};
-                }
-            } else {
-                if constexpr (std::is_void_v<E>) {
-                    new(this) result{err_t{}};
-                } else {
-                    new(this) result{err_t{}, std::move(r).err()};
-                }
-            }
-        }
-        return *this;
-    }
+    result(result&&) noexcept = default;
+    result& operator=(result&&) noexcept = default;
 
     result(const result&) = delete;
     result& operator=(const result&) = delete;
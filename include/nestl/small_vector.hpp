@@ -0,0 +1,482 @@
+//
+// Copyright 2018 Marcin Radomski. All rights reserved.
+//
+// Licensed under the MIT license. See LICENSE file in the project root for
+// details.
+//
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+
+#include <algorithm>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <limits>
+#include <new>
+#include <utility>
+
+#include <nestl/allocator.hpp>
+#include <nestl/growth_policy.hpp>
+#include <nestl/result.hpp>
+#include <nestl/utility.hpp>
+#include <nestl/vector.hpp>
+
+#include <nestl/detail/relocate.hpp>
+#include <nestl/detail/reverse_iterator.hpp>
+#include <nestl/detail/simd_search.hpp>
+#include <nestl/detail/storage.hpp>
+
+namespace nestl {
+
+/*
+ * Vector that keeps up to N elements in an inline buffer and only uses the
+ * allocator once it outgrows it. Interface mirrors nestl::vector, including
+ * the GrowthPolicy applied once the elements spill to the heap.
+ */
+template <typename T, size_t N, typename Allocator = system_allocator,
+          typename GrowthPolicy = geometric_growth<>>
+class small_vector {
+    static_assert(N > 0, "use nestl::vector instead");
+
+public:
+    using value_type = T;
+    using allocator_type = Allocator;
+    using growth_policy = GrowthPolicy;
+    using size_type = size_t;
+    using difference_type = ptrdiff_t;
+    using reference = value_type&;
+    using const_reference = const value_type&;
+    using pointer = value_type*;
+    using const_pointer = const value_type*;
+    using iterator = pointer;
+    using const_iterator = const_pointer;
+    using reverse_iterator = nestl::detail::reverse_iterator<iterator>;
+    using const_reverse_iterator =
+        nestl::detail::reverse_iterator<const_iterator>;
+
+    static constexpr size_t inline_capacity = N;
+
+private:
+    Allocator m_allocator;
+    T* m_data = inline_data();
+    size_t m_size = 0;
+    size_t m_capacity = N;
+    detail::storage<T[N]> m_inline;
+
+    [[nodiscard]] T* inline_data() noexcept {
+        return reinterpret_cast<T*>(m_inline.data);
+    }
+
+    [[nodiscard]] result<void, out_of_memory> grow(size_t new_capacity) {
+        assert(new_capacity >= m_size);
+
+        if (new_capacity <= N) {
+            if (!is_inline()) {
+                T* heap = m_data;
+                detail::relocate(begin(), end(), inline_data());
+                m_allocator.free(heap);
+                m_data = inline_data();
+                m_capacity = N;
+            }
+            return {ok_t{}};
+        }
+
+        if constexpr (is_trivially_relocatable_v<T>) {
+            if (!is_inline()) {
+                if (auto res = m_allocator.reallocate(
+                        m_data, new_capacity * sizeof(T))) {
+                    m_data = static_cast<T*>(res.ok());
+                    m_capacity = new_capacity;
+                    return {ok_t{}};
+                } else {
+                    return {std::move(res).err()};
+                }
+            }
+        }
+
+        if (auto res = m_allocator.allocate(new_capacity * sizeof(T))) {
+            T* new_data = static_cast<T*>(res.ok());
+            detail::relocate(begin(), end(), new_data);
+            if (!is_inline()) {
+                m_allocator.free(m_data);
+            }
+            m_data = new_data;
+            m_capacity = new_capacity;
+            return {ok_t{}};
+        } else {
+            return {std::move(res).err()};
+        }
+    }
+
+    // like reserve(), but leaves room for further insertions
+    [[nodiscard]] result<void, out_of_memory> reserve_for(size_t new_size) {
+        if (new_size <= m_capacity) {
+            return {ok_t{}};
+        }
+        return grow(
+            GrowthPolicy::next_capacity(m_capacity, new_size, sizeof(T)));
+    }
+
+    void release() noexcept {
+        clear();
+        if (!is_inline()) {
+            m_allocator.free(m_data);
+            m_data = inline_data();
+            m_capacity = N;
+        }
+    }
+
+    void take(small_vector& src) noexcept {
+        assert(m_size == 0 && is_inline());
+
+        m_allocator = src.m_allocator;
+        if (src.is_inline()) {
+            detail::relocate(src.begin(), src.end(), inline_data());
+        } else {
+            m_data = src.m_data;
+            m_capacity = src.m_capacity;
+            src.m_data = src.inline_data();
+            src.m_capacity = N;
+        }
+        m_size = src.m_size;
+        src.m_size = 0;
+    }
+
+    template <typename... Args>
+    void emplace_back_unchecked(Args&&... args) {
+        assert(size() < capacity());
+        new (m_data + size()) T(std::forward<Args>(args)...);
+        ++m_size;
+    }
+
+    enum class compare_result { less, equal, greater };
+
+    [[nodiscard]] compare_result compare(const small_vector& other) const {
+        int order = detail::ranges_compare(data(), size(), other.data(),
+                                           other.size());
+        if (order < 0) {
+            return compare_result::less;
+        } else if (order == 0) {
+            return compare_result::equal;
+        } else {
+            return compare_result::greater;
+        }
+    }
+
+public:
+    small_vector() noexcept : m_allocator() {}
+    explicit small_vector(const Allocator& alloc) noexcept
+        : m_allocator(alloc) {}
+
+    small_vector(small_vector&& src) noexcept { take(src); }
+    small_vector& operator=(small_vector&& src) noexcept {
+        if (this != &src) {
+            release();
+            take(src);
+        }
+        return *this;
+    }
+
+    // use copy() instead
+    small_vector(const small_vector&) = delete;
+    small_vector& operator=(const small_vector&) = delete;
+
+    [[nodiscard]] result<small_vector, out_of_memory> copy() const noexcept {
+        small_vector copy{m_allocator};
+        if (auto res = copy.reserve(m_size); !res) {
+            return {res.err()};
+        }
+
+        for (const T& e : *this) {
+            copy.emplace_back_unchecked(e);
+        }
+        return {std::move(copy)};
+    }
+
+    ~small_vector() noexcept { release(); }
+
+    result<void, out_of_memory> assign(size_t count, const T& value) noexcept {
+        if (auto res = reserve(count); !res) {
+            return {res.err()};
+        }
+
+        clear();
+        return insert(end(), count, value).map([](iterator&&) {});
+    }
+
+    template <typename It>
+    result<void, out_of_memory> assign(It first, It last) noexcept {
+        assert(first <= last);
+
+        if (auto res = reserve(static_cast<size_t>(last - first)); !res) {
+            return {res.err()};
+        }
+
+        clear();
+        return insert(end(), first, last).map([](iterator&&) {});
+    }
+
+    result<void, out_of_memory> assign(
+        std::initializer_list<T> ilist) noexcept {
+        return assign(ilist.begin(), ilist.end());
+    }
+
+    allocator_type get_allocator() const noexcept { return m_allocator; }
+
+    [[nodiscard]] result<std::reference_wrapper<T>, out_of_bounds> at(
+        size_t idx) noexcept {
+        if (idx < m_size) {
+            return {std::reference_wrapper<T>{(*this)[idx]}};
+        } else {
+            return {out_of_bounds{}};
+        }
+    }
+
+    [[nodiscard]] result<std::reference_wrapper<const T>, out_of_bounds> at(
+        size_t idx) const noexcept {
+        if (idx < m_size) {
+            return {std::reference_wrapper<const T>{(*this)[idx]}};
+        } else {
+            return {out_of_bounds{}};
+        }
+    }
+
+    [[nodiscard]] T& operator[](size_t idx) noexcept { return m_data[idx]; }
+
+    [[nodiscard]] const T& operator[](size_t idx) const noexcept {
+        return m_data[idx];
+    }
+
+    [[nodiscard]] T& front() noexcept { return m_data[0]; }
+    [[nodiscard]] const T& front() const noexcept { return m_data[0]; }
+
+    [[nodiscard]] T& back() noexcept { return m_data[m_size - 1]; }
+    [[nodiscard]] const T& back() const noexcept { return m_data[m_size - 1]; }
+
+    [[nodiscard]] T* data() noexcept { return m_data; }
+    [[nodiscard]] const T* data() const noexcept { return m_data; }
+
+    [[nodiscard]] iterator begin() noexcept { return m_data; }
+    [[nodiscard]] const_iterator begin() const noexcept { return m_data; }
+    [[nodiscard]] const_iterator cbegin() const noexcept { return begin(); }
+
+    [[nodiscard]] iterator end() noexcept { return m_data + m_size; }
+    [[nodiscard]] const_iterator end() const noexcept {
+        return m_data + m_size;
+    }
+    [[nodiscard]] const_iterator cend() const noexcept { return end(); }
+
+    [[nodiscard]] reverse_iterator rbegin() noexcept {
+        return reverse_iterator{end() - 1};
+    }
+    [[nodiscard]] const_reverse_iterator rbegin() const noexcept {
+        return const_reverse_iterator{end() - 1};
+    }
+    [[nodiscard]] const_reverse_iterator crbegin() const noexcept {
+        return rbegin();
+    }
+
+    [[nodiscard]] reverse_iterator rend() noexcept {
+        return reverse_iterator{begin() - 1};
+    }
+    [[nodiscard]] const_reverse_iterator rend() const noexcept {
+        return const_reverse_iterator{begin() - 1};
+    }
+    [[nodiscard]] const_reverse_iterator crend() const noexcept {
+        return rend();
+    }
+
+    [[nodiscard]] bool empty() const noexcept { return m_size == 0; }
+    [[nodiscard]] size_t max_size() const noexcept {
+        return std::numeric_limits<size_t>::max();
+    }
+    [[nodiscard]] size_t size() const noexcept { return m_size; }
+
+    // true until the elements spill to memory from the allocator
+    [[nodiscard]] bool is_inline() const noexcept {
+        return m_data == reinterpret_cast<const T*>(m_inline.data);
+    }
+
+    result<void, out_of_memory> reserve(size_t new_size) noexcept {
+        if (new_size > m_capacity) {
+            return grow(new_size);
+        } else {
+            return {ok_t{}};
+        }
+    }
+
+    [[nodiscard]] size_t capacity() const noexcept { return m_capacity; }
+
+    void shrink_to_fit() noexcept {
+        if (!is_inline() && m_size < m_capacity) {
+            // on failure the old, bigger buffer is still valid
+            (void)grow(m_size);
+        }
+    }
+
+    void clear() noexcept { erase(begin(), end()); }
+
+    result<iterator, out_of_memory> insert(const_iterator pos,
+                                           const T& e) noexcept {
+        return emplace(pos, e);
+    }
+
+    result<iterator, out_of_memory> insert(const_iterator pos, T&& e) noexcept {
+        return emplace(pos, std::move(e));
+    }
+
+    result<iterator, out_of_memory> insert(const_iterator pos, size_t count,
+                                           const T& e) noexcept {
+        assert(begin() <= pos && pos <= end());
+
+        size_t idx = static_cast<size_t>(pos - begin());
+        if (auto res = reserve_for(size() + count); !res) {
+            return {res.err()};
+        }
+
+        iterator at = begin() + idx;
+        detail::relocate(at, end(), at + count);
+        for (size_t i = 0; i < count; ++i) {
+            new (at + i) T(e);
+        }
+
+        m_size += count;
+        return {at};
+    }
+
+    template <typename It>
+    result<iterator, out_of_memory> insert(const_iterator pos, It first,
+                                           It last) noexcept {
+        assert(begin() <= pos && pos <= end());
+        assert(first <= last);
+
+        size_t idx = static_cast<size_t>(pos - begin());
+        size_t count = static_cast<size_t>(last - first);
+        if (auto res = reserve_for(size() + count); !res) {
+            return {res.err()};
+        }
+
+        iterator at = begin() + idx;
+        detail::relocate(at, end(), at + count);
+        for (iterator dst = at; first != last; ++first, ++dst) {
+            new (dst) T(*first);
+        }
+
+        m_size += count;
+        return {at};
+    }
+
+    result<iterator, out_of_memory> insert(
+        const_iterator pos, std::initializer_list<T> ilist) noexcept {
+        return insert(pos, ilist.begin(), ilist.end());
+    }
+
+    template <typename... Args>
+    result<iterator, out_of_memory> emplace(const_iterator pos,
+                                            Args&&... args) noexcept {
+        assert(begin() <= pos && pos <= end());
+
+        size_t idx = static_cast<size_t>(pos - begin());
+        if (auto res = reserve_for(size() + 1); !res) {
+            return {out_of_memory{}};
+        }
+
+        iterator at = begin() + idx;
+        detail::relocate(at, end(), at + 1);
+        new (at) T(std::forward<Args>(args)...);
+        ++m_size;
+        return {at};
+    }
+
+    iterator erase(const_iterator pos) noexcept { return erase(pos, pos + 1); }
+
+    iterator erase(const_iterator first, const_iterator last) noexcept {
+        assert(begin() <= first && first <= end());
+        assert(begin() <= last && last <= end());
+        assert(first <= last);
+
+        size_t count = static_cast<size_t>(last - first);
+        detail::destroy(const_cast<iterator>(first),
+                        const_cast<iterator>(last));
+        detail::relocate(const_cast<iterator>(last), end(),
+                         const_cast<iterator>(first));
+        m_size -= count;
+        return const_cast<iterator>(first);
+    }
+
+    result<std::reference_wrapper<T>, out_of_memory> push_back(T&& e) noexcept {
+        return emplace_back(std::forward<T>(e));
+    }
+
+    result<std::reference_wrapper<T>, out_of_memory> push_back(
+        const T& e) noexcept {
+        return emplace_back(e);
+    }
+
+    template <typename... Args>
+    result<std::reference_wrapper<T>, out_of_memory> emplace_back(
+        Args&&... args) noexcept {
+        if (auto res = reserve_for(size() + 1); !res) {
+            return {out_of_memory{}};
+        }
+
+        emplace_back_unchecked(std::forward<Args>(args)...);
+        return {std::reference_wrapper<T>{back()}};
+    }
+
+    void pop_back() noexcept {
+        back().~T();
+        --m_size;
+    }
+
+    result<void, out_of_memory> resize(size_t new_size) noexcept {
+        if (new_size <= size()) {
+            erase(begin() + new_size, end());
+            return {ok_t{}};
+        }
+
+        if (auto res = reserve_for(new_size); !res) {
+            return res;
+        }
+
+        while (size() < new_size) {
+            emplace_back_unchecked();
+        }
+        return {ok_t{}};
+    }
+
+    void swap(small_vector& other) noexcept {
+        small_vector tmp{std::move(other)};
+        other = std::move(*this);
+        *this = std::move(tmp);
+    }
+
+    [[nodiscard]] bool operator==(const small_vector& other) const {
+        return detail::ranges_equal(data(), size(), other.data(),
+                                    other.size());
+    }
+
+    [[nodiscard]] bool operator!=(const small_vector& other) const {
+        return !(*this == other);
+    }
+
+    [[nodiscard]] bool operator<(const small_vector& other) const {
+        return compare(other) == compare_result::less;
+    }
+
+    [[nodiscard]] bool operator<=(const small_vector& other) const {
+        return compare(other) != compare_result::greater;
+    }
+
+    [[nodiscard]] bool operator>(const small_vector& other) const {
+        return compare(other) == compare_result::greater;
+    }
+
+    [[nodiscard]] bool operator>=(const small_vector& other) const {
+        return compare(other) != compare_result::less;
+    }
+};
+
+}  // namespace nestl
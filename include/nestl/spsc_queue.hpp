@@ -0,0 +1,279 @@
+//
+// Copyright 2018 Marcin Radomski. All rights reserved.
+//
+// Licensed under the MIT license. See LICENSE file in the project root for
+// details.
+//
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+
+#include <algorithm>
+#include <atomic>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include <nestl/allocator.hpp>
+#include <nestl/detail/cache_line.hpp>
+#include <nestl/queue_errors.hpp>
+#include <nestl/result.hpp>
+
+namespace nestl {
+
+/*
+ * Bounded lock-free queue for exactly one producer and one consumer thread.
+ *
+ * Elements live in a power-of-two ring allocated once, by init(), through
+ * Allocator. The producer only writes the tail index and the consumer only
+ * the head index; each side keeps a cached copy of the other's index in its
+ * own cache line, so the shared lines are only touched when the cached
+ * value says the queue is full or empty.
+ *
+ * push_n() and pop_n() move whole batches and publish each of them with a
+ * single release store.
+ */
+template <typename T, typename Allocator = system_allocator>
+class spsc_queue {
+    static_assert(std::is_nothrow_move_constructible_v<T>,
+                  "popping an element must not throw");
+
+    // written by the producer
+    struct alignas(detail::cache_line_size) producer_side {
+        std::atomic<size_t> tail{0};
+        size_t cached_head = 0;
+    };
+
+    // written by the consumer
+    struct alignas(detail::cache_line_size) consumer_side {
+        std::atomic<size_t> head{0};
+        size_t cached_tail = 0;
+    };
+
+    producer_side m_producer;
+    consumer_side m_consumer;
+
+    // read-only once init() returns
+    alignas(detail::cache_line_size) Allocator m_allocator;
+    T* m_data = nullptr;
+    size_t m_mask = 0;
+
+    [[nodiscard]] T* slot(size_t idx) const noexcept {
+        return m_data + (idx & m_mask);
+    }
+
+    // Below this many elements, memcpy calls cost more than copying
+    // elements one by one.
+    static constexpr size_t bulk_copy_min = 16;
+
+    template <typename It>
+    static constexpr bool bulk_copyable =
+        std::is_trivially_copyable_v<T>
+        && std::is_pointer_v<It>
+        && std::is_same_v<std::remove_cv_t<std::remove_pointer_t<It>>, T>;
+
+    // Constructs n elements of the ring, starting at idx, from *first...
+    template <typename It>
+    void construct_n(size_t idx, It first, size_t n) noexcept {
+        if constexpr (bulk_copyable<It>) {
+            if (n >= bulk_copy_min) {
+                // the ring part may wrap around
+                size_t head_n = std::min(n, capacity() - (idx & m_mask));
+                std::memcpy(static_cast<void*>(slot(idx)), first,
+                            head_n * sizeof(T));
+                std::memcpy(static_cast<void*>(m_data), first + head_n,
+                            (n - head_n) * sizeof(T));
+                return;
+            }
+        }
+
+        for (size_t i = 0; i < n; ++i, ++first) {
+            new (slot(idx + i)) T(*first);
+        }
+    }
+
+    // Moves n elements of the ring, starting at idx, to *out... and
+    // destroys them.
+    template <typename OutIt>
+    void move_out_n(size_t idx, OutIt out, size_t n) noexcept {
+        if constexpr (bulk_copyable<OutIt>) {
+            if (n >= bulk_copy_min) {
+                size_t head_n = std::min(n, capacity() - (idx & m_mask));
+                std::memcpy(static_cast<void*>(out), slot(idx),
+                            head_n * sizeof(T));
+                std::memcpy(static_cast<void*>(out + head_n), m_data,
+                            (n - head_n) * sizeof(T));
+                return;
+            }
+        }
+
+        for (size_t i = 0; i < n; ++i, ++out) {
+            T* e = slot(idx + i);
+            *out = std::move(*e);
+            e->~T();
+        }
+    }
+
+    // Number of elements the producer may push, starting at tail.
+    [[nodiscard]] size_t free_space(size_t tail, size_t wanted) noexcept {
+        size_t cap = capacity();
+        size_t free = cap - (tail - m_producer.cached_head);
+        if (free < wanted) {
+            m_producer.cached_head =
+                m_consumer.head.load(std::memory_order_acquire);
+            free = cap - (tail - m_producer.cached_head);
+        }
+        return free;
+    }
+
+    // Number of elements the consumer may pop, starting at head.
+    [[nodiscard]] size_t available(size_t head, size_t wanted) noexcept {
+        size_t avail = m_consumer.cached_tail - head;
+        if (avail < wanted) {
+            m_consumer.cached_tail =
+                m_producer.tail.load(std::memory_order_acquire);
+            avail = m_consumer.cached_tail - head;
+        }
+        return avail;
+    }
+
+public:
+    spsc_queue(const Allocator& alloc = Allocator()) noexcept
+        : m_allocator(alloc) {}
+
+    ~spsc_queue() {
+        size_t head = m_consumer.head.load(std::memory_order_relaxed);
+        size_t tail = m_producer.tail.load(std::memory_order_relaxed);
+        for (; head != tail; ++head) {
+            slot(head)->~T();
+        }
+        m_allocator.free(m_data);
+    }
+
+    // the threads refer to the queue by address
+    spsc_queue(spsc_queue&&) = delete;
+    spsc_queue& operator=(spsc_queue&&) = delete;
+    spsc_queue(const spsc_queue&) = delete;
+    spsc_queue& operator=(const spsc_queue&) = delete;
+
+    /*
+     * Allocates room for at least min_capacity elements, rounded up to a
+     * power of two. Has to be called once, before the queue is shared with
+     * the producer and consumer threads.
+     */
+    [[nodiscard]] result<void, out_of_memory> init(
+        size_t min_capacity) noexcept {
+        assert(m_data == nullptr);
+        assert(min_capacity > 0);
+
+        size_t cap = 1;
+        while (cap < min_capacity) {
+            cap *= 2;
+        }
+
+        auto res = m_allocator.allocate(cap * sizeof(T));
+        if (!res) {
+            return {res.err()};
+        }
+
+        m_data = static_cast<T*>(res.ok());
+        m_mask = cap - 1;
+        return {ok_t{}};
+    }
+
+    [[nodiscard]] size_t capacity() const noexcept {
+        return m_data ? m_mask + 1 : 0;
+    }
+
+    /*
+     * Number of elements in the queue. Exact only when called by the
+     * producer or consumer, and even then the other side may change it
+     * right after.
+     */
+    [[nodiscard]] size_t size_approx() const noexcept {
+        size_t tail = m_producer.tail.load(std::memory_order_acquire);
+        size_t head = m_consumer.head.load(std::memory_order_acquire);
+        return tail - head;
+    }
+
+    [[nodiscard]] bool empty_approx() const noexcept {
+        return size_approx() == 0;
+    }
+
+    /*
+     * Producer side.
+     */
+
+    template <typename... Args>
+    result<void, queue_full> try_emplace(Args&&... args) noexcept {
+        size_t tail = m_producer.tail.load(std::memory_order_relaxed);
+        if (free_space(tail, 1) == 0) {
+            return {queue_full{}};
+        }
+
+        new (slot(tail)) T(std::forward<Args>(args)...);
+        m_producer.tail.store(tail + 1, std::memory_order_release);
+        return {ok_t{}};
+    }
+
+    result<void, queue_full> try_push(const T& e) noexcept {
+        return try_emplace(e);
+    }
+
+    result<void, queue_full> try_push(T&& e) noexcept {
+        return try_emplace(std::move(e));
+    }
+
+    /*
+     * Pushes up to count elements constructed from *first, *(first + 1)...
+     * as fits. Returns the number of elements pushed.
+     */
+    template <typename It>
+    size_t push_n(It first, size_t count) noexcept {
+        size_t tail = m_producer.tail.load(std::memory_order_relaxed);
+        size_t n = std::min(count, free_space(tail, count));
+        construct_n(tail, first, n);
+
+        if (n > 0) {
+            m_producer.tail.store(tail + n, std::memory_order_release);
+        }
+        return n;
+    }
+
+    /*
+     * Consumer side.
+     */
+
+    result<T, queue_empty> try_pop() noexcept {
+        size_t head = m_consumer.head.load(std::memory_order_relaxed);
+        if (available(head, 1) == 0) {
+            return {queue_empty{}};
+        }
+
+        T* e = slot(head);
+        result<T, queue_empty> res{std::move(*e)};
+        e->~T();
+        m_consumer.head.store(head + 1, std::memory_order_release);
+        return res;
+    }
+
+    /*
+     * Moves up to max_count elements to *out, *(out + 1)... Returns the
+     * number of elements popped.
+     */
+    template <typename OutIt>
+    size_t pop_n(OutIt out, size_t max_count) noexcept {
+        size_t head = m_consumer.head.load(std::memory_order_relaxed);
+        size_t n = std::min(max_count, available(head, max_count));
+        move_out_n(head, out, n);
+
+        if (n > 0) {
+            m_consumer.head.store(head + n, std::memory_order_release);
+        }
+        return n;
+    }
+};
+
+}  // namespace nestl
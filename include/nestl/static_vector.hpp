@@ -0,0 +1,472 @@
+//
+// Copyright 2018 Marcin Radomski. All rights reserved.
+//
+// Licensed under the MIT license. See LICENSE file in the project root for
+// details.
+//
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+
+#include <algorithm>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include <nestl/allocator.hpp>
+#include <nestl/result.hpp>
+#include <nestl/vector.hpp>
+
+#include <nestl/detail/relocate.hpp>
+#include <nestl/detail/reverse_iterator.hpp>
+#include <nestl/detail/simd_search.hpp>
+#include <nestl/detail/storage.hpp>
+
+namespace nestl {
+
+/*
+ * Selects the static_vector constructor that value-initializes all N
+ * elements, which a constant expression requires.
+ */
+struct zero_fill_t {};
+
+namespace detail {
+
+/*
+ * Trivial types are kept in a plain array, which keeps static_vector
+ * trivially copyable. The array is left uninitialized unless constructed
+ * with zero_fill_t, so that a default-constructed static_vector costs
+ * nothing regardless of N.
+ */
+template <typename T, size_t N,
+          bool = std::is_trivial_v<T> && std::is_copy_assignable_v<T>>
+class static_vector_storage {
+protected:
+    static constexpr bool trivial = true;
+
+    T m_data[N];
+    size_t m_size = 0;
+
+    constexpr T* ptr() noexcept { return m_data; }
+    constexpr const T* ptr() const noexcept { return m_data; }
+
+public:
+    // user-provided, so that value-initialization does not zero m_data
+    static_vector_storage() noexcept {}
+
+    constexpr explicit static_vector_storage(zero_fill_t) noexcept
+        : m_data{} {}
+};
+
+template <typename T, size_t N>
+class static_vector_storage<T, N, false> {
+protected:
+    static constexpr bool trivial = false;
+
+    storage<T[N]> m_storage;
+    size_t m_size = 0;
+
+    T* ptr() noexcept { return reinterpret_cast<T*>(m_storage.data); }
+    const T* ptr() const noexcept {
+        return reinterpret_cast<const T*>(m_storage.data);
+    }
+
+public:
+    static_vector_storage() noexcept = default;
+
+    static_vector_storage(static_vector_storage&& src) noexcept {
+        relocate(src.ptr(), src.ptr() + src.m_size, ptr());
+        m_size = src.m_size;
+        src.m_size = 0;
+    }
+
+    static_vector_storage& operator=(static_vector_storage&& src) noexcept {
+        if (this != &src) {
+            destroy(ptr(), ptr() + m_size);
+            relocate(src.ptr(), src.ptr() + src.m_size, ptr());
+            m_size = src.m_size;
+            src.m_size = 0;
+        }
+        return *this;
+    }
+
+    // use copy() instead
+    static_vector_storage(const static_vector_storage&) = delete;
+    static_vector_storage& operator=(const static_vector_storage&) = delete;
+
+    ~static_vector_storage() noexcept { destroy(ptr(), ptr() + m_size); }
+};
+
+}  // namespace detail
+
+/*
+ * Fixed-capacity vector that never allocates. Operations that would need more
+ * than N elements fail with out_of_memory. Interface mirrors nestl::vector.
+ *
+ * For trivial T, a static_vector constructed with zero_fill_t{} can be
+ * constexpr and its accessors used in constant expressions. Modifiers are
+ * not constexpr: they report errors through result and move elements with
+ * memmove, neither of which is usable in C++17 constant expressions.
+ */
+template <typename T, size_t N>
+class static_vector : private detail::static_vector_storage<T, N> {
+    static_assert(N > 0);
+
+    using base = detail::static_vector_storage<T, N>;
+
+public:
+    using value_type = T;
+    using size_type = size_t;
+    using difference_type = ptrdiff_t;
+    using reference = value_type&;
+    using const_reference = const value_type&;
+    using pointer = value_type*;
+    using const_pointer = const value_type*;
+    using iterator = pointer;
+    using const_iterator = const_pointer;
+    using reverse_iterator = nestl::detail::reverse_iterator<iterator>;
+    using const_reverse_iterator =
+        nestl::detail::reverse_iterator<const_iterator>;
+
+private:
+    template <typename... Args>
+    constexpr void construct_at(T* p, Args&&... args) {
+        if constexpr (base::trivial) {
+            if constexpr (std::is_constructible_v<T, Args...>) {
+                *p = T(std::forward<Args>(args)...);
+            } else {
+                *p = T{std::forward<Args>(args)...};
+            }
+        } else {
+            new (p) T(std::forward<Args>(args)...);
+        }
+    }
+
+    // moves [pos, end()) by `count` slots to the right
+    [[nodiscard]] iterator make_room(const_iterator pos, size_t count) {
+        iterator at = const_cast<iterator>(pos);
+        detail::relocate(at, end(), at + count);
+        return at;
+    }
+
+    template <typename... Args>
+    void emplace_back_unchecked(Args&&... args) {
+        assert(size() < capacity());
+        construct_at(end(), std::forward<Args>(args)...);
+        ++this->m_size;
+    }
+
+    enum class compare_result { less, equal, greater };
+
+    [[nodiscard]] compare_result compare(const static_vector& other) const {
+        int order = detail::ranges_compare(data(), size(), other.data(),
+                                           other.size());
+        if (order < 0) {
+            return compare_result::less;
+        } else if (order == 0) {
+            return compare_result::equal;
+        } else {
+            return compare_result::greater;
+        }
+    }
+
+public:
+    // user-provided, so that static_vector<T, N>{} does not zero the array
+    // of a trivial T either
+    static_vector() noexcept {}
+
+    template <bool Trivial = base::trivial,
+              typename = std::enable_if_t<Trivial>>
+    constexpr explicit static_vector(zero_fill_t) noexcept
+        : base(zero_fill_t{}) {}
+
+    [[nodiscard]] result<static_vector, out_of_memory> copy() const noexcept {
+        static_vector copy;
+        for (const T& e : *this) {
+            copy.emplace_back_unchecked(e);
+        }
+        return {std::move(copy)};
+    }
+
+    result<void, out_of_memory> assign(size_t count, const T& value) noexcept {
+        if (auto res = reserve(count); !res) {
+            return {res.err()};
+        }
+
+        clear();
+        return insert(end(), count, value).map([](iterator&&) {});
+    }
+
+    template <typename It>
+    result<void, out_of_memory> assign(It first, It last) noexcept {
+        assert(first <= last);
+
+        if (auto res = reserve(static_cast<size_t>(last - first)); !res) {
+            return {res.err()};
+        }
+
+        clear();
+        return insert(end(), first, last).map([](iterator&&) {});
+    }
+
+    result<void, out_of_memory> assign(
+        std::initializer_list<T> ilist) noexcept {
+        return assign(ilist.begin(), ilist.end());
+    }
+
+    [[nodiscard]] result<std::reference_wrapper<T>, out_of_bounds> at(
+        size_t idx) noexcept {
+        if (idx < size()) {
+            return {std::reference_wrapper<T>{(*this)[idx]}};
+        } else {
+            return {out_of_bounds{}};
+        }
+    }
+
+    [[nodiscard]] result<std::reference_wrapper<const T>, out_of_bounds> at(
+        size_t idx) const noexcept {
+        if (idx < size()) {
+            return {std::reference_wrapper<const T>{(*this)[idx]}};
+        } else {
+            return {out_of_bounds{}};
+        }
+    }
+
+    [[nodiscard]] constexpr T& operator[](size_t idx) noexcept {
+        return data()[idx];
+    }
+    [[nodiscard]] constexpr const T& operator[](size_t idx) const noexcept {
+        return data()[idx];
+    }
+
+    [[nodiscard]] constexpr T& front() noexcept { return data()[0]; }
+    [[nodiscard]] constexpr const T& front() const noexcept {
+        return data()[0];
+    }
+
+    [[nodiscard]] constexpr T& back() noexcept { return data()[size() - 1]; }
+    [[nodiscard]] constexpr const T& back() const noexcept {
+        return data()[size() - 1];
+    }
+
+    [[nodiscard]] constexpr T* data() noexcept { return this->ptr(); }
+    [[nodiscard]] constexpr const T* data() const noexcept {
+        return this->ptr();
+    }
+
+    [[nodiscard]] constexpr iterator begin() noexcept { return data(); }
+    [[nodiscard]] constexpr const_iterator begin() const noexcept {
+        return data();
+    }
+    [[nodiscard]] constexpr const_iterator cbegin() const noexcept {
+        return begin();
+    }
+
+    [[nodiscard]] constexpr iterator end() noexcept { return data() + size(); }
+    [[nodiscard]] constexpr const_iterator end() const noexcept {
+        return data() + size();
+    }
+    [[nodiscard]] constexpr const_iterator cend() const noexcept {
+        return end();
+    }
+
+    [[nodiscard]] reverse_iterator rbegin() noexcept {
+        return reverse_iterator{end() - 1};
+    }
+    [[nodiscard]] const_reverse_iterator rbegin() const noexcept {
+        return const_reverse_iterator{end() - 1};
+    }
+    [[nodiscard]] const_reverse_iterator crbegin() const noexcept {
+        return rbegin();
+    }
+
+    [[nodiscard]] reverse_iterator rend() noexcept {
+        return reverse_iterator{begin() - 1};
+    }
+    [[nodiscard]] const_reverse_iterator rend() const noexcept {
+        return const_reverse_iterator{begin() - 1};
+    }
+    [[nodiscard]] const_reverse_iterator crend() const noexcept {
+        return rend();
+    }
+
+    [[nodiscard]] constexpr bool empty() const noexcept { return size() == 0; }
+    [[nodiscard]] constexpr size_t max_size() const noexcept { return N; }
+    [[nodiscard]] constexpr size_t size() const noexcept {
+        return this->m_size;
+    }
+
+    result<void, out_of_memory> reserve(size_t new_size) noexcept {
+        if (new_size > N) {
+            return {out_of_memory{}};
+        } else {
+            return {ok_t{}};
+        }
+    }
+
+    [[nodiscard]] constexpr size_t capacity() const noexcept { return N; }
+
+    constexpr void shrink_to_fit() noexcept {}
+
+    void clear() noexcept { erase(begin(), end()); }
+
+    result<iterator, out_of_memory> insert(const_iterator pos,
+                                           const T& e) noexcept {
+        return emplace(pos, e);
+    }
+
+    result<iterator, out_of_memory> insert(const_iterator pos, T&& e) noexcept {
+        return emplace(pos, std::move(e));
+    }
+
+    result<iterator, out_of_memory> insert(const_iterator pos, size_t count,
+                                           const T& e) noexcept {
+        assert(begin() <= pos && pos <= end());
+
+        if (auto res = reserve(size() + count); !res) {
+            return {res.err()};
+        }
+
+        iterator at = make_room(pos, count);
+        for (size_t i = 0; i < count; ++i) {
+            construct_at(at + i, e);
+        }
+
+        this->m_size += count;
+        return {at};
+    }
+
+    template <typename It>
+    result<iterator, out_of_memory> insert(const_iterator pos, It first,
+                                           It last) noexcept {
+        assert(begin() <= pos && pos <= end());
+        assert(first <= last);
+
+        size_t count = static_cast<size_t>(last - first);
+        if (auto res = reserve(size() + count); !res) {
+            return {res.err()};
+        }
+
+        iterator at = make_room(pos, count);
+        for (iterator dst = at; first != last; ++first, ++dst) {
+            construct_at(dst, *first);
+        }
+
+        this->m_size += count;
+        return {at};
+    }
+
+    result<iterator, out_of_memory> insert(
+        const_iterator pos, std::initializer_list<T> ilist) noexcept {
+        return insert(pos, ilist.begin(), ilist.end());
+    }
+
+    template <typename... Args>
+    result<iterator, out_of_memory> emplace(const_iterator pos,
+                                            Args&&... args) noexcept {
+        assert(begin() <= pos && pos <= end());
+
+        if (size() == N) {
+            return {out_of_memory{}};
+        }
+
+        iterator at = make_room(pos, 1);
+        construct_at(at, std::forward<Args>(args)...);
+        ++this->m_size;
+        return {at};
+    }
+
+    iterator erase(const_iterator pos) noexcept { return erase(pos, pos + 1); }
+
+    iterator erase(const_iterator first, const_iterator last) noexcept {
+        assert(begin() <= first && first <= end());
+        assert(begin() <= last && last <= end());
+        assert(first <= last);
+
+        size_t count = static_cast<size_t>(last - first);
+        detail::destroy(const_cast<iterator>(first),
+                        const_cast<iterator>(last));
+        detail::relocate(const_cast<iterator>(last), end(),
+                         const_cast<iterator>(first));
+        this->m_size -= count;
+        return const_cast<iterator>(first);
+    }
+
+    result<std::reference_wrapper<T>, out_of_memory> push_back(T&& e) noexcept {
+        return emplace_back(std::forward<T>(e));
+    }
+
+    result<std::reference_wrapper<T>, out_of_memory> push_back(
+        const T& e) noexcept {
+        return emplace_back(e);
+    }
+
+    template <typename... Args>
+    result<std::reference_wrapper<T>, out_of_memory> emplace_back(
+        Args&&... args) noexcept {
+        if (size() == N) {
+            return {out_of_memory{}};
+        }
+
+        emplace_back_unchecked(std::forward<Args>(args)...);
+        return {std::reference_wrapper<T>{back()}};
+    }
+
+    void pop_back() noexcept {
+        back().~T();
+        --this->m_size;
+    }
+
+    result<void, out_of_memory> resize(size_t new_size) noexcept {
+        if (new_size <= size()) {
+            erase(begin() + new_size, end());
+            return {ok_t{}};
+        }
+
+        if (auto res = reserve(new_size); !res) {
+            return res;
+        }
+
+        while (size() < new_size) {
+            emplace_back_unchecked();
+        }
+        return {ok_t{}};
+    }
+
+    void swap(static_vector& other) noexcept {
+        static_vector tmp{std::move(other)};
+        other = std::move(*this);
+        *this = std::move(tmp);
+    }
+
+    [[nodiscard]] bool operator==(const static_vector& other) const {
+        return detail::ranges_equal(data(), size(), other.data(),
+                                    other.size());
+    }
+
+    [[nodiscard]] bool operator!=(const static_vector& other) const {
+        return !(*this == other);
+    }
+
+    [[nodiscard]] bool operator<(const static_vector& other) const {
+        return compare(other) == compare_result::less;
+    }
+
+    [[nodiscard]] bool operator<=(const static_vector& other) const {
+        return compare(other) != compare_result::greater;
+    }
+
+    [[nodiscard]] bool operator>(const static_vector& other) const {
+        return compare(other) == compare_result::greater;
+    }
+
+    [[nodiscard]] bool operator>=(const static_vector& other) const {
+        return compare(other) != compare_result::less;
+    }
+};
+
+}  // namespace nestl
@@ -0,0 +1,491 @@
+//
+// Copyright 2018 Marcin Radomski. All rights reserved.
+//
+// Licensed under the MIT license. See LICENSE file in the project root for
+// details.
+//
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+#include <nestl/allocator.hpp>
+#include <nestl/detail/cache_line.hpp>
+#include <nestl/detail/futex.hpp>
+#include <nestl/detail/work_stealing_deque.hpp>
+#include <nestl/mpmc_queue.hpp>
+#include <nestl/result.hpp>
+
+namespace nestl {
+namespace detail {
+
+/*
+ * Type-erased task, shared by the pool running it and the future waiting
+ * for it. Freed when both are done with it.
+ */
+struct task_base {
+    enum : uint32_t { pending, pending_waited, done };
+
+    void (*m_run)(task_base*) noexcept;
+    void (*m_release)(task_base*) noexcept;
+    std::atomic<uint32_t> m_refs{2};
+    // futex word
+    std::atomic<uint32_t> m_state{pending};
+
+    task_base(void (*run)(task_base*) noexcept,
+              void (*release)(task_base*) noexcept) noexcept
+        : m_run(run),
+          m_release(release) {}
+
+    void run() noexcept { m_run(this); }
+
+    void complete() noexcept {
+        if (m_state.exchange(done, std::memory_order_acq_rel)
+            == pending_waited) {
+            futex_wake_all(m_state);
+        }
+    }
+
+    [[nodiscard]] bool ready() const noexcept {
+        return m_state.load(std::memory_order_acquire) == done;
+    }
+
+    void wait_blocking() noexcept {
+        uint32_t state = m_state.load(std::memory_order_acquire);
+        while (state != done) {
+            if (state == pending
+                && !m_state.compare_exchange_weak(
+                       state, pending_waited, std::memory_order_acquire)) {
+                continue;
+            }
+            futex_wait(m_state, pending_waited);
+            state = m_state.load(std::memory_order_acquire);
+        }
+    }
+
+    void unref() noexcept {
+        if (m_refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            m_release(this);
+        }
+    }
+};
+
+template <typename R>
+struct task_result : task_base {
+    alignas(R) unsigned char m_value[sizeof(R)];
+
+    using task_base::task_base;
+
+    R* value() noexcept { return reinterpret_cast<R*>(m_value); }
+};
+
+template <>
+struct task_result<void> : task_base {
+    using task_base::task_base;
+};
+
+template <typename R, typename F, typename Allocator>
+class task_impl : public task_result<R> {
+    Allocator m_allocator;
+    // destroyed as soon as it returns, to free whatever it captured
+    alignas(F) unsigned char m_fn[sizeof(F)];
+
+    F* fn() noexcept { return reinterpret_cast<F*>(m_fn); }
+
+    static void run(task_base* base) noexcept {
+        auto* self = static_cast<task_impl*>(base);
+        if constexpr (std::is_void_v<R>) {
+            std::invoke(*self->fn());
+        } else {
+            new (self->value()) R(std::invoke(*self->fn()));
+        }
+        self->fn()->~F();
+        self->complete();
+        self->unref();
+    }
+
+    static void release(task_base* base) noexcept {
+        auto* self = static_cast<task_impl*>(base);
+        assert(self->ready());
+        if constexpr (!std::is_void_v<R>) {
+            self->value()->~R();
+        }
+        Allocator alloc = self->m_allocator;
+        self->~task_impl();
+        alloc.free(self);
+    }
+
+public:
+    template <typename Fn>
+    task_impl(const Allocator& alloc, Fn&& f) noexcept
+        : task_result<R>(&run, &release),
+          m_allocator(alloc) {
+        new (m_fn) F(std::forward<Fn>(f));
+    }
+};
+
+/*
+ * Identifies the pool worker running on the current thread, so that threads
+ * waiting for a future inside a task can run other tasks meanwhile.
+ */
+struct worker_context {
+    void* pool;
+    size_t index;
+    bool (*run_one)(void* pool, size_t index) noexcept;
+};
+
+inline thread_local const worker_context* current_worker = nullptr;
+
+}  // namespace detail
+
+/*
+ * Result of a task submitted to a thread_pool.
+ */
+template <typename R>
+class future {
+    template <typename>
+    friend class thread_pool;
+
+    detail::task_result<R>* m_task = nullptr;
+
+    explicit future(detail::task_result<R>* task) noexcept : m_task(task) {}
+
+public:
+    future() noexcept = default;
+    ~future() {
+        if (m_task) {
+            m_task->unref();
+        }
+    }
+
+    future(future&& src) noexcept : m_task(src.m_task) {
+        src.m_task = nullptr;
+    }
+    future& operator=(future&& src) noexcept {
+        std::swap(m_task, src.m_task);
+        return *this;
+    }
+
+    future(const future&) = delete;
+    future& operator=(const future&) = delete;
+
+    [[nodiscard]] bool valid() const noexcept { return m_task != nullptr; }
+
+    [[nodiscard]] bool is_ready() const noexcept {
+        assert(valid());
+        return m_task->ready();
+    }
+
+    /*
+     * Waits for the task to finish. On a pool worker thread, runs other
+     * tasks while waiting, so that tasks waiting for their subtasks cannot
+     * starve the pool.
+     */
+    void wait() const noexcept {
+        assert(valid());
+        if (const detail::worker_context* ctx = detail::current_worker) {
+            while (!m_task->ready()) {
+                if (!ctx->run_one(ctx->pool, ctx->index)) {
+                    std::this_thread::yield();
+                }
+            }
+        } else {
+            m_task->wait_blocking();
+        }
+    }
+
+    /*
+     * Waits for the task and returns its result. Leaves the future invalid.
+     */
+    R get() noexcept {
+        wait();
+        future done{std::move(*this)};
+        if constexpr (!std::is_void_v<R>) {
+            return std::move(*done.m_task->value());
+        }
+    }
+};
+
+/*
+ * Work-stealing thread pool.
+ *
+ * Each worker owns a bounded Chase-Lev deque. Tasks submitted by a worker
+ * go to the bottom of its own deque, tasks submitted by other threads to a
+ * shared mpmc_queue. An idle worker takes tasks from its own deque first
+ * (most recent first), then from the shared queue, then steals the oldest
+ * task of another worker, starting from a random one. Workers with nothing
+ * to do sleep on a futex, and submitting a task only wakes one if some
+ * worker is asleep.
+ *
+ * Tasks, together with their results, are allocated through Allocator,
+ * which therefore has to be usable from many threads at once -
+ * caching_allocator is a good fit. Tasks must not throw.
+ */
+template <typename Allocator = system_allocator>
+class thread_pool {
+    using task_ptr = detail::task_base*;
+
+    static constexpr int spins_before_sleep = 64;
+
+    struct worker {
+        detail::work_stealing_deque<task_ptr> deque;
+        detail::worker_context context;
+        std::thread thread;
+        uint64_t rng;
+
+        worker(std::atomic<task_ptr>* ring, size_t capacity,
+               detail::worker_context ctx, uint64_t seed) noexcept
+            : deque(ring, capacity),
+              context(ctx),
+              rng(seed) {}
+    };
+
+    Allocator m_allocator;
+    size_t m_queue_capacity;
+    mpmc_queue<task_ptr, Allocator> m_injected;
+
+    // single block holding the workers and their deques' rings
+    void* m_block = nullptr;
+    worker* m_workers = nullptr;
+    size_t m_worker_count = 0;
+
+    alignas(detail::cache_line_size) std::atomic<uint32_t> m_epoch{0};
+    std::atomic<uint32_t> m_sleepers{0};
+    std::atomic<bool> m_stopping{false};
+
+    static bool run_one_thunk(void* pool, size_t index) noexcept {
+        return static_cast<thread_pool*>(pool)->run_one(index);
+    }
+
+    [[nodiscard]] const detail::worker_context* own_worker() const noexcept {
+        const detail::worker_context* ctx = detail::current_worker;
+        return ctx && ctx->pool == this ? ctx : nullptr;
+    }
+
+    bool steal(size_t thief, task_ptr& out) noexcept {
+        uint64_t& x = m_workers[thief].rng;
+        // xorshift64
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+
+        size_t start = static_cast<size_t>(x % m_worker_count);
+        for (size_t i = 0; i < m_worker_count; ++i) {
+            size_t victim = (start + i) % m_worker_count;
+            if (victim != thief && m_workers[victim].deque.steal(out)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool run_one(size_t index) noexcept {
+        task_ptr t = nullptr;
+        if (!m_workers[index].deque.pop(t)) {
+            if (auto res = m_injected.try_pop()) {
+                t = res.ok();
+            } else if (!steal(index, t)) {
+                return false;
+            }
+        }
+        t->run();
+        return true;
+    }
+
+    void notify() noexcept {
+        if (m_sleepers.load(std::memory_order_seq_cst) > 0) {
+            m_epoch.fetch_add(1, std::memory_order_release);
+            detail::futex_wake_one(m_epoch);
+        }
+    }
+
+    void worker_main(size_t index) noexcept {
+        detail::current_worker = &m_workers[index].context;
+
+        for (;;) {
+            bool ran = false;
+            for (int i = 0; i < spins_before_sleep && !ran; ++i) {
+                ran = run_one(index);
+            }
+            if (ran) {
+                continue;
+            }
+
+            // register as a sleeper before the last look for work, so that
+            // a task submitted after it sees us and wakes us up
+            uint32_t epoch = m_epoch.load(std::memory_order_acquire);
+            m_sleepers.fetch_add(1, std::memory_order_seq_cst);
+            if (run_one(index)) {
+                m_sleepers.fetch_sub(1, std::memory_order_relaxed);
+                continue;
+            }
+            if (m_stopping.load(std::memory_order_seq_cst)) {
+                m_sleepers.fetch_sub(1, std::memory_order_relaxed);
+                break;
+            }
+            detail::futex_wait(m_epoch, epoch);
+            m_sleepers.fetch_sub(1, std::memory_order_relaxed);
+        }
+
+        detail::current_worker = nullptr;
+    }
+
+    void enqueue(task_ptr t) noexcept {
+        if (const detail::worker_context* ctx = own_worker()) {
+            if (m_workers[ctx->index].deque.push(t)
+                || m_injected.try_push(t)) {
+                notify();
+            } else {
+                // everything is full: waiting for room could deadlock
+                t->run();
+            }
+        } else {
+            m_injected.push(t);
+            notify();
+        }
+    }
+
+    void destroy_workers(size_t count) noexcept {
+        for (size_t i = 0; i < count; ++i) {
+            m_workers[i].~worker();
+        }
+        m_allocator.free(m_block);
+        m_block = nullptr;
+        m_workers = nullptr;
+        m_worker_count = 0;
+    }
+
+public:
+    /*
+     * queue_capacity is the number of tasks each worker's deque, and the
+     * queue of tasks submitted from outside the pool, can hold. It is
+     * rounded up to a power of two.
+     */
+    thread_pool(const Allocator& alloc = Allocator(),
+                size_t queue_capacity = 1024) noexcept
+        : m_allocator(alloc),
+          m_queue_capacity(1),
+          m_injected(alloc) {
+        while (m_queue_capacity < queue_capacity) {
+            m_queue_capacity *= 2;
+        }
+    }
+
+    ~thread_pool() { stop(); }
+
+    // workers refer to the pool by address
+    thread_pool(thread_pool&&) = delete;
+    thread_pool& operator=(thread_pool&&) = delete;
+    thread_pool(const thread_pool&) = delete;
+    thread_pool& operator=(const thread_pool&) = delete;
+
+    /*
+     * Allocates the queues and starts `threads` workers, or one per
+     * hardware thread if 0. May only be called once.
+     */
+    [[nodiscard]] result<void, out_of_memory> start(
+        size_t threads = 0) noexcept {
+        assert(m_workers == nullptr);
+
+        if (threads == 0) {
+            threads = std::max<size_t>(1, std::thread::hardware_concurrency());
+        }
+
+        if (auto res = m_injected.init(m_queue_capacity); !res) {
+            return res;
+        }
+
+        // workers are cache-line aligned, more than allocate() guarantees
+        using ring_t = std::atomic<task_ptr>;
+        static_assert(sizeof(worker) % alignof(ring_t) == 0);
+        size_t ring_size = m_queue_capacity * sizeof(ring_t);
+        auto block = m_allocator.allocate(alignof(worker) - 1
+                                          + threads * sizeof(worker)
+                                          + threads * ring_size);
+        if (!block) {
+            return {block.err()};
+        }
+
+        m_block = block.ok();
+        auto addr = reinterpret_cast<uintptr_t>(m_block);
+        addr = (addr + alignof(worker) - 1) / alignof(worker) * alignof(worker);
+        m_workers = reinterpret_cast<worker*>(addr);
+        auto* rings = reinterpret_cast<ring_t*>(m_workers + threads);
+        for (size_t i = 0; i < threads; ++i) {
+            ring_t* ring = rings + i * m_queue_capacity;
+            for (size_t j = 0; j < m_queue_capacity; ++j) {
+                new (ring + j) ring_t(nullptr);
+            }
+            detail::worker_context ctx{this, i, &run_one_thunk};
+            // distinct, non-zero xorshift seeds
+            uint64_t seed = 0x9e3779b97f4a7c15ULL * (i + 1);
+            new (&m_workers[i]) worker(ring, m_queue_capacity, ctx, seed);
+        }
+        m_worker_count = threads;
+
+        for (size_t i = 0; i < threads; ++i) {
+            m_workers[i].thread = std::thread([this, i] { worker_main(i); });
+        }
+        return {ok_t{}};
+    }
+
+    /*
+     * Runs all submitted tasks, then stops the workers. Tasks must not be
+     * submitted from other threads meanwhile.
+     */
+    void stop() noexcept {
+        if (!m_workers) {
+            return;
+        }
+
+        m_stopping.store(true, std::memory_order_seq_cst);
+        m_epoch.fetch_add(1, std::memory_order_release);
+        detail::futex_wake_all(m_epoch);
+        for (size_t i = 0; i < m_worker_count; ++i) {
+            m_workers[i].thread.join();
+        }
+        destroy_workers(m_worker_count);
+    }
+
+    [[nodiscard]] size_t thread_count() const noexcept {
+        return m_worker_count;
+    }
+
+    [[nodiscard]] Allocator get_allocator() const noexcept {
+        return m_allocator;
+    }
+
+    /*
+     * Schedules f() to run on one of the workers. The pool has to be
+     * started.
+     */
+    template <typename F, typename R = std::invoke_result_t<std::decay_t<F>&>>
+    result<future<R>, out_of_memory> submit(F&& f) noexcept {
+        static_assert(std::is_void_v<R>
+                          || std::is_nothrow_move_constructible_v<R>,
+                      "the result is moved out of the task");
+        using task_t = detail::task_impl<R, std::decay_t<F>, Allocator>;
+        static_assert(alignof(task_t) <= alignof(std::max_align_t));
+        assert(m_workers != nullptr);
+
+        auto mem = m_allocator.allocate(sizeof(task_t));
+        if (!mem) {
+            return {mem.err()};
+        }
+
+        auto* t = new (mem.ok()) task_t(m_allocator, std::forward<F>(f));
+        enqueue(t);
+        return {future<R>{t}};
+    }
+};
+
+}  // namespace nestl
@@ -0,0 +1,252 @@
+//
+// Copyright 2018 Marcin Radomski. All rights reserved.
+//
+// Licensed under the MIT license. See LICENSE file in the project root for
+// details.
+//
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+#include <atomic>
+#include <type_traits>
+
+#include <nestl/allocator.hpp>
+#include <nestl/result.hpp>
+
+namespace nestl {
+
+/*
+ * Plain copy of allocation_stats counters.
+ */
+struct allocation_stats_snapshot {
+    static constexpr size_t histogram_size = 64;
+
+    uint64_t allocations = 0;
+    uint64_t reallocations = 0;
+    // reallocations that returned a different address, i.e. copied
+    uint64_t moved_reallocations = 0;
+    uint64_t frees = 0;
+    uint64_t failures = 0;
+    uint64_t live_bytes = 0;
+    uint64_t peak_live_bytes = 0;
+    // histogram[i] counts requests of [2^i, 2^(i+1)) bytes, including the
+    // new sizes of reallocations
+    uint64_t histogram[histogram_size] = {};
+};
+
+/*
+ * Counters updated by tracking_allocator. All updates are relaxed atomics,
+ * so a snapshot taken while other threads allocate is not necessarily
+ * consistent across counters, but each counter is exact.
+ */
+class allocation_stats {
+public:
+    using move_hook = void (*)(size_t old_size, size_t new_size);
+
+private:
+    template <typename>
+    friend class tracking_allocator;
+
+    static constexpr auto relaxed = std::memory_order_relaxed;
+
+    std::atomic<uint64_t> m_allocations{0};
+    std::atomic<uint64_t> m_reallocations{0};
+    std::atomic<uint64_t> m_moved_reallocations{0};
+    std::atomic<uint64_t> m_frees{0};
+    std::atomic<uint64_t> m_failures{0};
+    std::atomic<uint64_t> m_live_bytes{0};
+    std::atomic<uint64_t> m_peak_live_bytes{0};
+    std::atomic<uint64_t>
+        m_histogram[allocation_stats_snapshot::histogram_size] = {};
+    std::atomic<move_hook> m_move_hook{nullptr};
+
+    static size_t bucket(size_t size) noexcept {
+        assert(size > 0);
+        return static_cast<size_t>(63 - __builtin_clzll(size));
+    }
+
+    void add_live(size_t size) noexcept {
+        uint64_t live = m_live_bytes.fetch_add(size, relaxed) + size;
+        uint64_t peak = m_peak_live_bytes.load(relaxed);
+        while (peak < live
+               && !m_peak_live_bytes.compare_exchange_weak(peak, live,
+                                                           relaxed)) {
+        }
+    }
+
+    void on_allocate(size_t size) noexcept {
+        m_allocations.fetch_add(1, relaxed);
+        m_histogram[bucket(size)].fetch_add(1, relaxed);
+        add_live(size);
+    }
+
+    void on_reallocate(size_t old_size, size_t new_size, bool moved) noexcept {
+        m_reallocations.fetch_add(1, relaxed);
+        m_histogram[bucket(new_size)].fetch_add(1, relaxed);
+        if (new_size >= old_size) {
+            add_live(new_size - old_size);
+        } else {
+            m_live_bytes.fetch_sub(old_size - new_size, relaxed);
+        }
+
+        if (moved) {
+            m_moved_reallocations.fetch_add(1, relaxed);
+            if (move_hook hook = m_move_hook.load(relaxed)) {
+                hook(old_size, new_size);
+            }
+        }
+    }
+
+    void on_free(size_t size) noexcept {
+        m_frees.fetch_add(1, relaxed);
+        m_live_bytes.fetch_sub(size, relaxed);
+    }
+
+    void on_failure() noexcept { m_failures.fetch_add(1, relaxed); }
+
+public:
+    allocation_stats() noexcept = default;
+
+    // allocators refer to the stats by pointer
+    allocation_stats(allocation_stats&&) = delete;
+    allocation_stats& operator=(allocation_stats&&) = delete;
+    allocation_stats(const allocation_stats&) = delete;
+    allocation_stats& operator=(const allocation_stats&) = delete;
+
+    /*
+     * Sets a function called on every reallocation that moved the block,
+     * e.g. to log or sample the sizes involved. Called from the allocating
+     * thread, so it has to be cheap and thread-safe.
+     */
+    void set_move_hook(move_hook hook) noexcept {
+        m_move_hook.store(hook, relaxed);
+    }
+
+    [[nodiscard]] allocation_stats_snapshot snapshot() const noexcept {
+        allocation_stats_snapshot s;
+        s.allocations = m_allocations.load(relaxed);
+        s.reallocations = m_reallocations.load(relaxed);
+        s.moved_reallocations = m_moved_reallocations.load(relaxed);
+        s.frees = m_frees.load(relaxed);
+        s.failures = m_failures.load(relaxed);
+        s.live_bytes = m_live_bytes.load(relaxed);
+        s.peak_live_bytes = m_peak_live_bytes.load(relaxed);
+        for (size_t i = 0; i < allocation_stats_snapshot::histogram_size;
+             ++i) {
+            s.histogram[i] = m_histogram[i].load(relaxed);
+        }
+        return s;
+    }
+};
+
+/*
+ * Allocator recording every call into an allocation_stats, then forwarding
+ * it to Backing. Each block is preceded by a header holding its size, so
+ * frees can be accounted for.
+ *
+ * A default-constructed tracking_allocator records nothing.
+ */
+template <typename Backing = system_allocator>
+class tracking_allocator {
+    struct alignas(std::max_align_t) header {
+        size_t size;
+    };
+
+    Backing m_backing;
+    allocation_stats* m_stats = nullptr;
+
+    static header* header_of(void* p) noexcept {
+        return static_cast<header*>(p) - 1;
+    }
+
+public:
+    tracking_allocator() noexcept = default;
+    tracking_allocator(allocation_stats& stats,
+                       const Backing& backing = Backing()) noexcept
+        : m_backing(backing),
+          m_stats(&stats) {}
+
+    result<void*, out_of_memory> allocate(size_t size) noexcept {
+        assert(size > 0);
+
+        auto res = m_backing.allocate(sizeof(header) + size);
+        if (!res) {
+            if (m_stats) {
+                m_stats->on_failure();
+            }
+            return res;
+        }
+
+        auto* h = static_cast<header*>(res.ok());
+        h->size = size;
+        if (m_stats) {
+            m_stats->on_allocate(size);
+        }
+        return {static_cast<void*>(h + 1)};
+    }
+
+    result<void*, out_of_memory> reallocate(void* p, size_t new_size) noexcept {
+        assert(new_size > 0);
+
+        if (!p) {
+            return allocate(new_size);
+        }
+
+        header* old = header_of(p);
+        size_t old_size = old->size;
+        // old must not be used once reallocated, not even in comparisons
+        auto old_addr = reinterpret_cast<uintptr_t>(p);
+        auto res = m_backing.reallocate(old, sizeof(header) + new_size);
+        if (!res) {
+            if (m_stats) {
+                m_stats->on_failure();
+            }
+            return res;
+        }
+
+        auto* h = static_cast<header*>(res.ok());
+        h->size = new_size;
+        if (m_stats) {
+            m_stats->on_reallocate(old_size, new_size,
+                                   reinterpret_cast<uintptr_t>(h + 1)
+                                       != old_addr);
+        }
+        return {static_cast<void*>(h + 1)};
+    }
+
+    void free(void* p) noexcept {
+        if (!p) {
+            return;
+        }
+
+        header* h = header_of(p);
+        if (m_stats) {
+            m_stats->on_free(h->size);
+        }
+        m_backing.free(h);
+    }
+
+    // Backing may have handed out more than requested
+    template <typename B = Backing,
+              typename = std::enable_if_t<has_usable_size<B>>>
+    size_t usable_size(void* p) const noexcept {
+        return m_backing.usable_size(header_of(p)) - sizeof(header);
+    }
+
+    [[nodiscard]] allocation_stats* stats() const noexcept { return m_stats; }
+
+    [[nodiscard]] bool operator==(const tracking_allocator& other) const
+        noexcept {
+        return m_stats == other.m_stats;
+    }
+
+    [[nodiscard]] bool operator!=(const tracking_allocator& other) const
+        noexcept {
+        return !(*this == other);
+    }
+};
+
+}  // namespace nestl
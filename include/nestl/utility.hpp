@@ -88,4 +88,22 @@ struct tag {
     using type = T;
 };
 
+/*
+ * A type is trivially relocatable if moving an object to a new address and
+ * destroying the source is equivalent to copying its bytes. Containers use
+ * memmove/realloc for such types instead of per-element move + destroy.
+ *
+ * Trivially copyable types qualify automatically. Other types (e.g. ones that
+ * own a heap buffer, but do not point into themselves) may opt in by
+ * specializing this template.
+ */
+template <typename T>
+struct is_trivially_relocatable : std::is_trivially_copyable<T> {};
+
+template <typename T>
+constexpr bool is_trivially_relocatable_v = is_trivially_relocatable<T>::value;
+
+static_assert(is_trivially_relocatable_v<int>);
+static_assert(is_trivially_relocatable_v<int*>);
+
 }  // namespace nestl
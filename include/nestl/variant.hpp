@@ -6,9 +6,12 @@
 //
 #pragma once
 
+#include <cassert>
 #include <cstddef>
 
+#include <array>
 #include <functional>
+#include <tuple>
 #include <type_traits>
 #include <utility>
 
@@ -35,44 +38,182 @@ public:
         [[nodiscard]] result<std::reference_wrapper<T>, variant_type_error>
         get() & noexcept {
         static_assert(is_one_of<T, Ts...>);
-        return get_impl<T, 0, Ts...>();
+        return get_impl<T>();
     }
 
     template <typename T>
         [[nodiscard]] result<std::reference_wrapper<T>, variant_type_error>
         get() && noexcept {
         static_assert(is_one_of<T, Ts...>);
-        return get_impl<T, 0, Ts...>();
+        return get_impl<T>();
     }
 
     template <typename T>
     [[nodiscard]] result<std::reference_wrapper<const T>, variant_type_error>
     get() const noexcept {
         static_assert(is_one_of<T, Ts...>);
-        return const_cast<variant*>(this)->get_impl<const T, 0, Ts...>();
+        return const_cast<variant*>(this)->get_impl<const T>();
     }
 
 private:
-    template <typename T, size_t N, typename First, typename... Rest>
+    template <typename T>
     [[nodiscard]] inline result<std::reference_wrapper<T>, variant_type_error>
     get_impl() noexcept {
-        if (this->m_current == N) {
-            if (std::is_same_v<std::remove_const_t<T>, First>) {
-                return {std::reference_wrapper<T>{
-                    this->m_storage.template as<std::remove_const_t<T>>()}};
-            } else {
-                return {variant_type_error{}};
-            }
+        using U = std::remove_const_t<T>;
+        if (this->current() == type_index<U, Ts...>) {
+            return {std::reference_wrapper<T>{
+                this->m_storage.template as<U>()}};
         } else {
-            return get_impl<T, N + 1, Rest...>();
+            return {variant_type_error{}};
         }
     }
+};
 
-    template <typename T, size_t>
-    [[nodiscard]] inline result<std::reference_wrapper<T>, variant_type_error>
-    get_impl() noexcept {
-        return {variant_type_error{}};
+template <typename V>
+struct variant_size;
+
+template <typename... Ts>
+struct variant_size<variant<Ts...>>
+    : std::integral_constant<size_t, sizeof...(Ts)> {};
+
+template <typename V>
+constexpr size_t variant_size_v = variant_size<std::remove_cv_t<V>>::value;
+
+template <size_t I, typename V>
+struct variant_alternative;
+
+template <size_t I, typename... Ts>
+struct variant_alternative<I, variant<Ts...>> {
+    using type = std::tuple_element_t<I, std::tuple<Ts...>>;
+};
+
+template <size_t I, typename V>
+using variant_alternative_t =
+    typename variant_alternative<I, std::remove_cv_t<V>>::type;
+
+namespace detail {
+
+/*
+ * Table of functions invoking F on every combination of alternatives held
+ * by Vs, laid out row-major: the last variant's index changes fastest.
+ */
+template <typename F, typename... Vs>
+struct visit_table {
+    static constexpr size_t sizes[] = {
+        variant_size_v<std::remove_reference_t<Vs>>...};
+    static constexpr size_t count =
+        (variant_size_v<std::remove_reference_t<Vs>> * ... * 1);
+
+    template <size_t I, typename V>
+    using alternative_t = variant_alternative_t<I, std::remove_reference_t<V>>;
+
+    template <size_t I, typename V>
+    using alternative_ref =
+        decltype(variant_access::get<alternative_t<I, V>>(std::declval<V>()));
+
+    // index of the alternative of the K-th variant in the Flat-th entry
+    template <size_t Flat, size_t K>
+    static constexpr size_t alternative_index() noexcept {
+        size_t stride = 1;
+        for (size_t i = K + 1; i < sizeof...(Vs); ++i) {
+            stride *= sizes[i];
+        }
+        return Flat / stride % sizes[K];
+    }
+
+    template <size_t... Is>
+    static constexpr bool nothrow_entry =
+        std::is_nothrow_invocable_v<F, alternative_ref<Is, Vs>...>;
+
+    template <size_t Flat, size_t... Ks>
+    static constexpr bool nothrow_at(std::index_sequence<Ks...>) noexcept {
+        return nothrow_entry<alternative_index<Flat, Ks>()...>;
+    }
+
+    template <size_t... Flat>
+    static constexpr bool all_nothrow(std::index_sequence<Flat...>) noexcept {
+        return (nothrow_at<Flat>(std::index_sequence_for<Vs...>{}) && ...);
+    }
+
+    static constexpr bool is_nothrow =
+        all_nothrow(std::make_index_sequence<count>{});
+
+    using return_type = std::invoke_result_t<F, alternative_ref<0, Vs>...>;
+
+    template <size_t... Is>
+    static return_type invoke(F&& f, Vs&&... vs) noexcept(is_nothrow) {
+        static_assert(
+            std::is_same_v<
+                std::invoke_result_t<F, alternative_ref<Is, Vs>...>,
+                return_type>,
+            "visitor must return the same type for all alternatives");
+
+        return std::invoke(std::forward<F>(f),
+                           variant_access::get<alternative_t<Is, Vs>>(
+                               std::forward<Vs>(vs))...);
+    }
+
+    using entry = return_type (*)(F&&, Vs&&...) noexcept(is_nothrow);
+
+    template <size_t Flat, size_t... Ks>
+    static constexpr entry entry_at(std::index_sequence<Ks...>) noexcept {
+        return &invoke<alternative_index<Flat, Ks>()...>;
+    }
+
+    template <size_t... Flat>
+    static constexpr auto make_entries(std::index_sequence<Flat...>) noexcept {
+        return std::array<entry, count>{
+            {entry_at<Flat>(std::index_sequence_for<Vs...>{})...}};
+    }
+
+    static constexpr auto entries =
+        make_entries(std::make_index_sequence<count>{});
+
+    // A few alternatives are cheaper to tell apart with comparisons, which
+    // keep the visitor inlinable (see variant_core::dispatch).
+    static constexpr bool use_chain = sizeof...(Vs) == 1 && count <= 3;
+
+    template <size_t I = 0>
+    static return_type invoke_chain(size_t idx, F&& f,
+                                    Vs&&... vs) noexcept(is_nothrow) {
+        if constexpr (I + 1 < count) {
+            if (idx != I) {
+                return invoke_chain<I + 1>(idx, std::forward<F>(f),
+                                           std::forward<Vs>(vs)...);
+            }
+        }
+        return invoke<I>(std::forward<F>(f), std::forward<Vs>(vs)...);
     }
 };
 
+}  // namespace detail
+
+/*
+ * Calls f with the values held by all of vs, forwarding their value
+ * category. The held alternatives select an entry of a precomputed table
+ * covering all their combinations, so the cost does not depend on the
+ * number of alternatives.
+ *
+ * f must return the same type for every combination of alternatives, and
+ * none of vs may be moved-from.
+ */
+template <typename F, typename... Vs>
+decltype(auto) visit(F&& f, Vs&&... vs) noexcept(
+    detail::visit_table<F, Vs...>::is_nothrow) {
+    using table = detail::visit_table<F, Vs...>;
+
+    size_t idx = 0;
+    ((assert(vs.index() != invalid_type_index),
+      idx = idx * variant_size_v<std::remove_reference_t<Vs>>
+            + detail::variant_access::index(vs)),
+     ...);
+    if constexpr (table::use_chain) {
+        return table::invoke_chain(idx, std::forward<F>(f),
+                                   std::forward<Vs>(vs)...);
+    } else {
+        return table::entries[idx](std::forward<F>(f),
+                                   std::forward<Vs>(vs)...);
+    }
+}
+
 }  // namespace nestl
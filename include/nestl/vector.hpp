@@ -8,6 +8,7 @@
 
 #include <cassert>
 #include <cstddef>
+#include <cstring>
 
 #include <algorithm>
 #include <functional>
@@ -15,22 +16,33 @@
 #include <iterator>
 #include <limits>
 #include <new>
+#include <type_traits>
 #include <utility>
 
 #include <nestl/allocator.hpp>
+#include <nestl/growth_policy.hpp>
 #include <nestl/result.hpp>
+#include <nestl/utility.hpp>
 
+#include <nestl/detail/relocate.hpp>
 #include <nestl/detail/reverse_iterator.hpp>
+#include <nestl/detail/simd_search.hpp>
 
 namespace nestl {
 
 class out_of_bounds {};
 
-template <typename T, typename Allocator = system_allocator>
+/*
+ * GrowthPolicy decides how much to allocate when an insertion runs out of
+ * capacity, see growth_policy.hpp.
+ */
+template <typename T, typename Allocator = system_allocator,
+          typename GrowthPolicy = geometric_growth<>>
 class vector {
 public:
     using value_type = T;
     using allocator_type = Allocator;
+    using growth_policy = GrowthPolicy;
     using size_type = size_t;
     using difference_type = ptrdiff_t;
     using reference = value_type&;
@@ -49,22 +61,46 @@ private:
     size_t m_size = 0;
     size_t m_capacity = 0;
 
+    // the allocator may have handed out more than asked for
+    void set_buffer(void* p, size_t new_size) noexcept {
+        m_data = static_cast<T*>(p);
+        m_capacity = new_size;
+        if constexpr (has_usable_size<Allocator>) {
+            m_capacity =
+                std::max(new_size, m_allocator.usable_size(p) / sizeof(T));
+        }
+    }
+
     [[nodiscard]] result<void, out_of_memory> grow(size_t new_size) {
-        if (auto res = m_allocator.reallocate(m_data, new_size * sizeof(T))) {
-            m_data = static_cast<T*>(res.ok());
-            m_capacity = new_size;
-            return {ok_t{}};
+        if constexpr (is_trivially_relocatable_v<T>) {
+            if (auto res =
+                    m_allocator.reallocate(m_data, new_size * sizeof(T))) {
+                set_buffer(res.ok(), new_size);
+                return {ok_t{}};
+            } else {
+                return {std::move(res).err()};
+            }
         } else {
-            return {std::move(res).err()};
+            // realloc would move the bytes without running move ctors
+            if (auto res = m_allocator.allocate(new_size * sizeof(T))) {
+                T* new_data = static_cast<T*>(res.ok());
+                detail::relocate(begin(), end(), new_data);
+                m_allocator.free(m_data);
+                set_buffer(new_data, new_size);
+                return {ok_t{}};
+            } else {
+                return {std::move(res).err()};
+            }
         }
     }
 
-        [[nodiscard]] result<void, out_of_memory> grow() {
-        if (capacity() == 0) {
-            return grow(10);
-        } else {
-            return grow(capacity() * 3 / 2);
+    // like reserve(), but leaves room for further insertions
+    [[nodiscard]] result<void, out_of_memory> reserve_for(size_t new_size) {
+        if (new_size <= m_capacity) {
+            return {ok_t{}};
         }
+        return grow(
+            GrowthPolicy::next_capacity(m_capacity, new_size, sizeof(T)));
     }
 
     template <typename... Args>
@@ -74,15 +110,26 @@ private:
         ++m_size;
     }
 
+    // leaves trivial types uninitialized
+    void default_init_back_unchecked(size_t count) noexcept {
+        assert(size() + count <= capacity());
+        if constexpr (!std::is_trivially_default_constructible_v<T>) {
+            for (T* p = end(); p != end() + count; ++p) {
+                new (p) T;
+            }
+        }
+        m_size += count;
+    }
+
     enum class compare_result { less, equal, greater };
 
     [[nodiscard]] compare_result compare(const vector& other) const {
-        auto mismatch = std::mismatch(begin(), end(), other.begin());
-        if (mismatch.first == end() && mismatch.second == other.end()) {
-            return compare_result::equal;
-        } else if (std::lexicographical_compare(mismatch.first, end(),
-                                                mismatch.second)) {
+        int order = detail::ranges_compare(data(), size(), other.data(),
+                                           other.size());
+        if (order < 0) {
             return compare_result::less;
+        } else if (order == 0) {
+            return compare_result::equal;
         } else {
             return compare_result::greater;
         }
@@ -108,16 +155,40 @@ private:
     vector(const vector&) = delete;
     vector& operator=(const vector&) = delete;
 
-    [[nodiscard]] result<vector, out_of_memory> copy() noexcept {
-        vector copy;
-        if (auto res = copy.reserve(m_size)) {
-            for (const T& e : *this) {
-                copy.push_back(e);
-            }
-            return {copy};
-        } else {
+    [[nodiscard]] result<vector, out_of_memory> copy() const noexcept {
+        return copy(m_allocator);
+    }
+
+    // copy that allocates from alloc instead
+    [[nodiscard]] result<vector, out_of_memory> copy(
+        const Allocator& alloc) const noexcept {
+        vector copy{alloc};
+        if (auto res = copy.reserve(m_size); !res) {
             return {res.err()};
         }
+
+        detail::copy_construct(begin(), end(), copy.m_data);
+        copy.m_size = m_size;
+        return {std::move(copy)};
+    }
+
+    /*
+     * Replaces the contents of dst with copies of the elements, reusing its
+     * buffer if it is big enough. On failure dst is left empty.
+     */
+    result<void, out_of_memory> copy_into(vector& dst) const noexcept {
+        if (this == &dst) {
+            return {ok_t{}};
+        }
+
+        dst.clear();
+        if (auto res = dst.reserve(m_size); !res) {
+            return res;
+        }
+
+        detail::copy_construct(begin(), end(), dst.m_data);
+        dst.m_size = m_size;
+        return {ok_t{}};
     }
 
     ~vector() noexcept {
@@ -217,6 +288,18 @@ private:
         return rend();
     }
 
+    // first element equal to value, or end()
+    [[nodiscard]] iterator find(const T& value) noexcept {
+        return m_data + detail::range_find(m_data, m_size, value);
+    }
+    [[nodiscard]] const_iterator find(const T& value) const noexcept {
+        return m_data + detail::range_find(m_data, m_size, value);
+    }
+
+    [[nodiscard]] size_t count(const T& value) const noexcept {
+        return detail::range_count(m_data, m_size, value);
+    }
+
     [[nodiscard]] bool empty() const noexcept { return m_size == 0; }
     [[nodiscard]] size_t max_size() const noexcept {
         return std::numeric_limits<size_t>::max();
@@ -234,7 +317,14 @@ private:
     [[nodiscard]] size_t capacity() const { return m_capacity; }
 
     void shrink_to_fit() noexcept {
-        m_allocator.reallocate(m_data, m_size * sizeof(T));
+        if (m_size == 0) {
+            m_allocator.free(m_data);
+            m_data = nullptr;
+            m_capacity = 0;
+        } else if (m_size < m_capacity) {
+            // on failure the old, bigger buffer is still valid
+            (void)grow(m_size);
+        }
     }
 
     void clear() { erase(begin(), end()); }
@@ -253,18 +343,18 @@ private:
         assert(begin() <= pos && pos <= end());
 
         size_t idx = static_cast<size_t>(pos - begin());
-        if (auto res = reserve(size() + count); !res) {
+        if (auto res = reserve_for(size() + count); !res) {
             return {res.err()};
         }
 
-        pos = begin() + idx;
-        std::move_backward(const_cast<iterator>(pos), end(), end() + count);
+        iterator at = begin() + idx;
+        detail::relocate(at, end(), at + count);
         for (size_t i = 0; i < count; ++i) {
-            new (const_cast<iterator>(pos + i)) T(e);
+            new (at + i) T(e);
         }
 
         m_size += count;
-        return {const_cast<iterator>(pos)};
+        return {at};
     }
 
     template <typename It>
@@ -275,18 +365,18 @@ private:
 
         size_t idx = static_cast<size_t>(pos - begin());
         size_t count = static_cast<size_t>(last - first);
-        if (auto res = reserve(size() + count); !res) {
+        if (auto res = reserve_for(size() + count); !res) {
             return {res.err()};
         }
 
-        pos = begin() + idx;
-        std::move_backward(const_cast<iterator>(pos), end(), end() + count);
-        for (const_iterator at = pos; first != last; ++first, ++at) {
-            new (const_cast<iterator>(at)) T(*first);
+        iterator at = begin() + idx;
+        detail::relocate(at, end(), at + count);
+        for (iterator dst = at; first != last; ++first, ++dst) {
+            new (dst) T(*first);
         }
 
         m_size += count;
-        return {const_cast<iterator>(pos)};
+        return {at};
     }
 
     result<iterator, out_of_memory> insert(
@@ -300,15 +390,15 @@ private:
         assert(begin() <= pos && pos <= end());
 
         size_t idx = static_cast<size_t>(pos - begin());
-        if (auto res = reserve(size() + 1); !res) {
+        if (auto res = reserve_for(size() + 1); !res) {
             return {out_of_memory{}};
         }
 
-        pos = begin() + idx;
-        std::move_backward(const_cast<iterator>(pos), end(), end() + 1);
-        new (const_cast<iterator>(pos)) T(std::forward<Args>(args)...);
+        iterator at = begin() + idx;
+        detail::relocate(at, end(), at + 1);
+        new (at) T(std::forward<Args>(args)...);
         ++m_size;
-        return {const_cast<iterator>(pos)};
+        return {at};
     }
 
     iterator erase(const_iterator pos) noexcept { return erase(pos, pos + 1); }
@@ -319,16 +409,53 @@ private:
         assert(first <= last);
 
         size_t count = static_cast<size_t>(last - first);
-        for (const_iterator p = first; p != last; ++p) {
-            p->~T();
-        }
-
-        std::move(const_cast<iterator>(last), end(),
-                  const_cast<iterator>(first));
+        detail::destroy(const_cast<iterator>(first),
+                        const_cast<iterator>(last));
+        detail::relocate(const_cast<iterator>(last), end(),
+                         const_cast<iterator>(first));
         m_size -= count;
         return const_cast<iterator>(first);
     }
 
+    /*
+     * Erases the element at pos by relocating the last element into its
+     * place. O(1), but does not preserve the order of elements. Returns an
+     * iterator to the element that took pos' place, or end().
+     */
+    iterator unordered_erase(const_iterator pos) noexcept {
+        assert(begin() <= pos && pos < end());
+
+        auto at = const_cast<iterator>(pos);
+        at->~T();
+        detail::relocate(end() - 1, end(), at);
+        --m_size;
+        return at;
+    }
+
+    /*
+     * Erases all elements for which pred returns false, preserving the order
+     * of the rest. Single pass: every element is relocated at most once.
+     * Returns the number of erased elements.
+     */
+    template <typename Pred>
+    size_t retain(Pred pred) noexcept {
+        auto erase_pred = [&pred](const T& e) { return !pred(e); };
+        return erase_if(erase_pred);
+    }
+
+    /*
+     * Erases all elements for which pred returns true, preserving the order
+     * of the rest. Single pass: every element is relocated at most once.
+     * Returns the number of erased elements.
+     */
+    template <typename Pred>
+    size_t erase_if(Pred pred) noexcept {
+        iterator new_end = detail::relocate_remove_if(begin(), end(), pred);
+        size_t count = static_cast<size_t>(end() - new_end);
+        m_size -= count;
+        return count;
+    }
+
     result<std::reference_wrapper<T>, out_of_memory> push_back(T&& e) noexcept {
         return emplace_back(std::forward<T>(e));
     }
@@ -341,7 +468,7 @@ private:
     template <typename... Args>
     result<std::reference_wrapper<T>, out_of_memory> emplace_back(
         Args&&... args) noexcept {
-        if (auto res = reserve(size() + 1); !res) {
+        if (auto res = reserve_for(size() + 1); !res) {
             return {out_of_memory{}};
         }
 
@@ -349,6 +476,52 @@ private:
         return {std::reference_wrapper<T>{back()}};
     }
 
+    /*
+     * Appends copies of [first, last) after a single capacity check. Ranges
+     * of T in contiguous memory are copied with one memcpy if T is
+     * trivially copyable. Returns an iterator to the first appended element.
+     */
+    template <typename It>
+    result<iterator, out_of_memory> append_range(It first, It last) noexcept {
+        auto count = static_cast<size_t>(std::distance(first, last));
+        if (auto res = reserve_for(size() + count); !res) {
+            return {res.err()};
+        }
+
+        size_t idx = size();
+        if constexpr (std::is_trivially_copyable_v<T> && std::is_pointer_v<It>
+                      && std::is_same_v<
+                             std::remove_cv_t<std::remove_pointer_t<It>>, T>) {
+            if (count > 0) {
+                std::memcpy(static_cast<void*>(end()),
+                            static_cast<const void*>(first),
+                            count * sizeof(T));
+                m_size += count;
+            }
+        } else {
+            for (; first != last; ++first) {
+                emplace_back_unchecked(*first);
+            }
+        }
+        return {begin() + idx};
+    }
+
+    /*
+     * Appends count default-initialized elements - left uninitialized if T
+     * is trivial - for the caller to fill in, e.g. with read(). Returns an
+     * iterator to the first of them.
+     */
+    result<iterator, out_of_memory> append_n_uninitialized(
+        size_t count) noexcept {
+        if (auto res = reserve_for(size() + count); !res) {
+            return {res.err()};
+        }
+
+        size_t idx = size();
+        default_init_back_unchecked(count);
+        return {begin() + idx};
+    }
+
     void pop_back() noexcept {
         back().~T();
         --m_size;
@@ -360,7 +533,7 @@ private:
             return {ok_t{}};
         }
 
-        auto res = grow(new_size);
+        auto res = reserve(new_size);
         if (res) {
             while (size() < new_size) {
                 emplace_back_unchecked();
@@ -369,6 +542,24 @@ private:
         return res;
     }
 
+    /*
+     * Like resize(), but new elements are default-initialized instead of
+     * value-initialized, so trivial types are not zeroed.
+     */
+    result<void, out_of_memory> resize_default_init(size_t new_size) noexcept {
+        if (new_size <= size()) {
+            erase(begin() + new_size, end());
+            return {ok_t{}};
+        }
+
+        if (auto res = reserve(new_size); !res) {
+            return res;
+        }
+
+        default_init_back_unchecked(new_size - size());
+        return {ok_t{}};
+    }
+
     void swap(vector& other) noexcept {
         std::swap(m_allocator, other.m_allocator);
         std::swap(m_data, other.m_data);
@@ -377,12 +568,8 @@ private:
     }
 
     [[nodiscard]] bool operator==(const vector& other) const {
-        if (size() != other.size()) {
-            return false;
-        }
-
-        auto mismatch = std::mismatch(begin(), end(), other.begin());
-        return mismatch.first == end();
+        return detail::ranges_equal(data(), size(), other.data(),
+                                    other.size());
     }
 
     [[nodiscard]] bool operator!=(const vector& other) const {
@@ -406,4 +593,9 @@ private:
     }
 };
 
+template <typename T, typename Allocator, typename GrowthPolicy, typename Pred>
+size_t erase_if(vector<T, Allocator, GrowthPolicy>& v, Pred pred) noexcept {
+    return v.erase_if(std::move(pred));
+}
+
 }  // namespace nestl
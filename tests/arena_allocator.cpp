@@ -0,0 +1,126 @@
+//
+// Copyright 2018 Marcin Radomski. All rights reserved.
+//
+// Licensed under the MIT license. See LICENSE file in the project root for
+// details.
+//
+#include <doctest.h>
+
+#include <cstddef>
+#include <cstdint>
+
+#include <nestl/arena_allocator.hpp>
+#include <nestl/vector.hpp>
+
+TEST_SUITE("arena_allocator") {
+    using nestl::arena;
+    using nestl::arena_allocator;
+
+    // NOLINTNEXTLINE (cert-err58-cpp)
+    TEST_CASE("allocates from a caller-provided buffer") {
+        alignas(std::max_align_t) unsigned char buffer[256];
+        arena<> a{buffer, sizeof(buffer)};
+
+        auto p = a.allocate(16);
+        REQUIRE(p.is_ok());
+        REQUIRE(static_cast<unsigned char*>(p.ok()) >= buffer);
+        REQUIRE(static_cast<unsigned char*>(p.ok()) < buffer + sizeof(buffer));
+    }
+
+    // NOLINTNEXTLINE (cert-err58-cpp)
+    TEST_CASE("reports out_of_memory when the buffer is exhausted") {
+        alignas(std::max_align_t) unsigned char buffer[256];
+        arena<> a{buffer, sizeof(buffer)};
+
+        REQUIRE(a.allocate(128).is_ok());
+        REQUIRE(a.allocate(128).is_err());
+    }
+
+    // NOLINTNEXTLINE (cert-err58-cpp)
+    TEST_CASE("rejects requests whose rounded size overflows") {
+        arena<> a;
+        // would wrap to a small block, rather than fail in the backing
+        for (size_t size : {SIZE_MAX, SIZE_MAX - 1, SIZE_MAX - 16}) {
+            REQUIRE(a.allocate(size).is_err());
+        }
+
+        void* p = a.allocate(16).ok();
+        REQUIRE(a.reallocate(p, SIZE_MAX).is_err());
+        REQUIRE(a.reallocate(p, SIZE_MAX - 8).is_err());
+        REQUIRE(a.reallocate(p, 32).ok() == p);
+
+        alignas(std::max_align_t) unsigned char buffer[256];
+        arena<> fixed{buffer, sizeof(buffer)};
+        REQUIRE(fixed.allocate(SIZE_MAX - 8).is_err());
+        REQUIRE(fixed.allocate(64).is_ok());
+    }
+
+    // NOLINTNEXTLINE (cert-err58-cpp)
+    TEST_CASE("grows the last allocation in place") {
+        arena<> a;
+
+        void* p = a.allocate(16).ok();
+        auto res = a.reallocate(p, 1024);
+        REQUIRE(res.is_ok());
+        REQUIRE(res.ok() == p);
+    }
+
+    // NOLINTNEXTLINE (cert-err58-cpp)
+    TEST_CASE("copies when reallocating an older allocation") {
+        arena<> a;
+
+        auto* p = static_cast<int*>(a.allocate(sizeof(int)).ok());
+        *p = 42;
+        REQUIRE(a.allocate(16).is_ok());
+
+        auto res = a.reallocate(p, 64 * sizeof(int));
+        REQUIRE(res.is_ok());
+        REQUIRE(res.ok() != p);
+        REQUIRE(*static_cast<int*>(res.ok()) == 42);
+    }
+
+    // NOLINTNEXTLINE (cert-err58-cpp)
+    TEST_CASE("allocates new chunks when needed") {
+        arena<> a{64};
+
+        REQUIRE(a.allocate(48).is_ok());
+        REQUIRE(a.allocate(48).is_ok());
+        REQUIRE(a.allocate(1024).is_ok());
+    }
+
+    // NOLINTNEXTLINE (cert-err58-cpp)
+    TEST_CASE("release makes the buffer reusable") {
+        alignas(std::max_align_t) unsigned char buffer[256];
+        arena<> a{buffer, sizeof(buffer)};
+
+        void* p = a.allocate(128).ok();
+        REQUIRE(a.allocate(128).is_err());
+
+        a.release();
+        REQUIRE(a.allocate(128).ok() == p);
+    }
+
+    // NOLINTNEXTLINE (cert-err58-cpp)
+    TEST_CASE("backs a vector without copying on growth") {
+        arena<> a;
+        nestl::vector<int, arena_allocator<>> v{arena_allocator<>{a}};
+
+        REQUIRE(v.push_back(0).is_ok());
+        const int* data = v.data();
+        for (int i = 1; i < 1000; ++i) {
+            REQUIRE(v.push_back(i).is_ok());
+        }
+
+        REQUIRE(v.data() == data);
+        for (size_t i = 0; i < v.size(); ++i) {
+            REQUIRE(v[i] == static_cast<int>(i));
+        }
+    }
+
+    // NOLINTNEXTLINE (cert-err58-cpp)
+    TEST_CASE("default-constructed allocator does not allocate") {
+        arena_allocator<> alloc;
+        REQUIRE(alloc.allocate(1).is_err());
+        alloc.free(nullptr);
+    }
+}
@@ -0,0 +1,191 @@
+//
+// Copyright 2018 Marcin Radomski. All rights reserved.
+//
+// Licensed under the MIT license. See LICENSE file in the project root for
+// details.
+//
+#include <doctest.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <nestl/caching_allocator.hpp>
+#include <nestl/result.hpp>
+#include <nestl/vector.hpp>
+
+namespace {
+
+std::atomic<size_t> backing_frees{0};
+
+// Stateless, as caching_allocator requires, counting the blocks it frees.
+class counting_allocator : public nestl::system_allocator {
+public:
+    void free(void* p) noexcept {
+        if (p) {
+            ++backing_frees;
+        }
+        nestl::system_allocator::free(p);
+    }
+};
+
+using counting_cache = nestl::caching_allocator<counting_allocator>;
+
+// Destroyed after the thread's cache if constructed before it.
+struct frees_on_exit {
+    void* block = nullptr;
+    std::atomic<size_t>* frees_at_exit = nullptr;
+
+    ~frees_on_exit() {
+        counting_cache alloc;
+        size_t before = backing_frees;
+        alloc.free(block);
+        // a block allocated and freed here must not be cached either
+        alloc.free(alloc.allocate(16).ok());
+        *frees_at_exit = backing_frees - before;
+    }
+};
+
+}  // namespace
+
+TEST_SUITE("caching_allocator") {
+    using nestl::caching_allocator;
+
+    // NOLINTNEXTLINE (cert-err58-cpp)
+    TEST_CASE("reuses freed blocks of the same size class") {
+        using alloc_t = caching_allocator<>;
+        alloc_t alloc;
+        alloc_t::flush_thread_cache();
+
+        auto a = alloc.allocate(20);
+        REQUIRE(a.is_ok());
+        REQUIRE(alloc.usable_size(a.ok()) == 32);
+        alloc.free(a.ok());
+        REQUIRE(alloc_t::thread_cache_size() == 1);
+
+        auto b = alloc.allocate(32);
+        REQUIRE(b.is_ok());
+        REQUIRE(b.ok() == a.ok());
+        REQUIRE(alloc_t::thread_cache_size() == 0);
+
+        auto c = alloc.allocate(33);
+        REQUIRE(c.is_ok());
+        REQUIRE(c.ok() != a.ok());
+
+        alloc.free(b.ok());
+        alloc.free(c.ok());
+        alloc.free(nullptr);
+        alloc_t::flush_thread_cache();
+        REQUIRE(alloc_t::thread_cache_size() == 0);
+    }
+
+    // NOLINTNEXTLINE (cert-err58-cpp)
+    TEST_CASE("bounds the number of cached blocks") {
+        using alloc_t = caching_allocator<nestl::system_allocator, 64, 4>;
+        alloc_t alloc;
+
+        void* blocks[10];
+        for (void*& p : blocks) {
+            p = alloc.allocate(16).ok();
+        }
+        for (void* p : blocks) {
+            alloc.free(p);
+        }
+        REQUIRE(alloc_t::thread_cache_size() == 4);
+
+        // not cached at all
+        auto large = alloc.allocate(65);
+        REQUIRE(large.is_ok());
+        alloc.free(large.ok());
+        REQUIRE(alloc_t::thread_cache_size() == 4);
+
+        alloc_t::flush_thread_cache();
+        REQUIRE(alloc_t::thread_cache_size() == 0);
+    }
+
+    // NOLINTNEXTLINE (cert-err58-cpp)
+    TEST_CASE("reallocate keeps contents across size classes") {
+        caching_allocator<nestl::system_allocator, 64> alloc;
+
+        auto res = alloc.reallocate(nullptr, 10);
+        REQUIRE(res.is_ok());
+        std::memcpy(res.ok(), "123456789", 10);
+
+        void* same = res.ok();
+        res = alloc.reallocate(res.ok(), 16);
+        REQUIRE(res.ok() == same);
+
+        res = alloc.reallocate(res.ok(), 40);
+        REQUIRE(res.is_ok());
+        REQUIRE(std::memcmp(res.ok(), "123456789", 10) == 0);
+
+        res = alloc.reallocate(res.ok(), 1000);
+        REQUIRE(res.is_ok());
+        REQUIRE(alloc.usable_size(res.ok()) == 1000);
+        res = alloc.reallocate(res.ok(), 2000);
+        REQUIRE(res.is_ok());
+        REQUIRE(std::memcmp(res.ok(), "123456789", 10) == 0);
+
+        res = alloc.reallocate(res.ok(), 8);
+        REQUIRE(res.is_ok());
+        REQUIRE(std::memcmp(res.ok(), "12345678", 8) == 0);
+        alloc.free(res.ok());
+    }
+
+    // NOLINTNEXTLINE (cert-err58-cpp)
+    TEST_CASE("blocks may be freed by another thread") {
+        using alloc_t = caching_allocator<>;
+        alloc_t alloc;
+
+        std::vector<void*> blocks;
+        for (int i = 0; i < 100; ++i) {
+            blocks.push_back(alloc.allocate(64).ok());
+        }
+
+        size_t cached = 0;
+        std::thread([&] {
+            for (void* p : blocks) {
+                alloc.free(p);
+            }
+            cached = alloc_t::thread_cache_size();
+        }).join();
+        REQUIRE(cached == alloc_t::max_blocks_per_class);
+    }
+
+    // NOLINTNEXTLINE (cert-err58-cpp)
+    TEST_CASE("frees after the thread cache is gone go to Backing") {
+        std::atomic<size_t> frees{0};
+        std::thread([&frees] {
+            thread_local frees_on_exit on_exit;
+            on_exit.frees_at_exit = &frees;
+            // constructs the cache after on_exit
+            on_exit.block = counting_cache{}.allocate(16).ok();
+        }).join();
+        REQUIRE(frees == 2);
+    }
+
+    // NOLINTNEXTLINE (cert-err58-cpp)
+    TEST_CASE("backs vectors in many threads") {
+        std::atomic<int> failures{0};
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 8; ++t) {
+            threads.emplace_back([t, &failures] {
+                for (int round = 0; round < 100; ++round) {
+                    nestl::vector<int, caching_allocator<>> v;
+                    for (int i = 0; i < 50; ++i) {
+                        failures += v.push_back(t * i).is_err();
+                    }
+                    failures += v[49] != t * 49;
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        REQUIRE(failures == 0);
+    }
+}
@@ -0,0 +1,35 @@
+//
+// Copyright 2018 Marcin Radomski. All rights reserved.
+//
+// Licensed under the MIT license. See LICENSE file in the project root for
+// details.
+//
+
+/*
+ * Compiled to assembly by the codegen test, which fails if any of these
+ * functions accesses its argument or return value through a pointer - that
+ * is, if results or variants of trivial types are not passed and returned
+ * in registers.
+ */
+#include <nestl/allocator.hpp>
+#include <nestl/result.hpp>
+#include <nestl/variant.hpp>
+
+extern "C" {
+
+nestl::result<int*, nestl::out_of_memory> codegen_return_result(int* p) {
+    return {p};
+}
+
+int* codegen_take_result(nestl::result<int*, nestl::out_of_memory> r) {
+    return r.is_ok() ? r.ok() : nullptr;
+}
+
+nestl::variant<int, float> codegen_return_variant(float f) {
+    return {f};
+}
+
+int codegen_take_variant(nestl::variant<int, float> v) {
+    return v.is<int>() ? 1 : 2;
+}
+}
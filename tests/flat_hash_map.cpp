@@ -0,0 +1,228 @@
+//
+// Copyright 2018 Marcin Radomski. All rights reserved.
+//
+// Licensed under the MIT license. See LICENSE file in the project root for
+// details.
+//
+#include <doctest.h>
+
+#include <cstddef>
+
+#include <functional>
+
+#include <memory>
+#include <utility>
+
+#include <nestl/arena_allocator.hpp>
+#include <nestl/flat_hash_map.hpp>
+#include <nestl/result.hpp>
+
+namespace {
+
+struct BadHash {
+    size_t operator()(int) const noexcept { return 0; }
+};
+
+// Counts the calls that may allocate.
+class counting_allocator : public nestl::system_allocator {
+    size_t* m_calls;
+
+public:
+    explicit counting_allocator(size_t& calls) noexcept : m_calls(&calls) {}
+
+    nestl::result<void*, nestl::out_of_memory> allocate(size_t size) noexcept {
+        ++*m_calls;
+        return nestl::system_allocator::allocate(size);
+    }
+
+    nestl::result<void*, nestl::out_of_memory> reallocate(
+        void* p, size_t new_size) noexcept {
+        ++*m_calls;
+        return nestl::system_allocator::reallocate(p, new_size);
+    }
+};
+
+template <typename Hash>
+void check_in_place_cleanup() {
+    size_t calls = 0;
+    nestl::flat_hash_map<int, int, Hash, std::equal_to<int>,
+                         counting_allocator>
+        m{counting_allocator{calls}};
+    REQUIRE(m.reserve(100).is_ok());
+    size_t capacity = m.capacity();
+    calls = 0;
+
+    // keeps 20 live elements while churning through many more keys
+    for (int i = 0; i < 5000; ++i) {
+        REQUIRE(m.insert({i, -i}).is_ok());
+        if (i >= 20) {
+            REQUIRE(m.erase(i - 20) == 1);
+        }
+    }
+
+    REQUIRE(calls == 0);
+    REQUIRE(m.capacity() == capacity);
+    REQUIRE(m.size() == 20);
+    for (int i = 4980; i < 5000; ++i) {
+        REQUIRE(m.at(i).ok() == -i);
+    }
+    REQUIRE(m.find(4979) == m.end());
+}
+
+}  // namespace
+
+TEST_SUITE("flat_hash_map") {
+    using nestl::flat_hash_map;
+
+    // NOLINTNEXTLINE (cert-err58-cpp)
+    TEST_CASE("is empty by default") {
+        flat_hash_map<int, int> m;
+        REQUIRE(m.empty());
+        REQUIRE(m.begin() == m.end());
+        REQUIRE(m.find(1) == m.end());
+        REQUIRE(m.at(1).is_err());
+        REQUIRE(m.erase(1) == 0);
+    }
+
+    // NOLINTNEXTLINE (cert-err58-cpp)
+    TEST_CASE("insert and find") {
+        flat_hash_map<int, int> m;
+        for (int i = 0; i < 1000; ++i) {
+            auto res = m.insert({i, i * 2});
+            REQUIRE(res.is_ok());
+            REQUIRE(res.ok().second);
+            REQUIRE(res.ok().first->first == i);
+        }
+
+        REQUIRE(m.size() == 1000);
+        for (int i = 0; i < 1000; ++i) {
+            REQUIRE(m.at(i).ok() == i * 2);
+        }
+        REQUIRE(!m.contains(1000));
+        REQUIRE(!m.contains(-1));
+    }
+
+    // NOLINTNEXTLINE (cert-err58-cpp)
+    TEST_CASE("does not overwrite existing keys") {
+        flat_hash_map<int, int> m;
+        REQUIRE(m.insert({1, 1}).ok().second);
+
+        auto res = m.emplace(1, 2);
+        REQUIRE(!res.ok().second);
+        REQUIRE(res.ok().first->second == 1);
+        REQUIRE(m.size() == 1);
+    }
+
+    // NOLINTNEXTLINE (cert-err58-cpp)
+    TEST_CASE("erase") {
+        flat_hash_map<int, int> m;
+        for (int i = 0; i < 100; ++i) {
+            REQUIRE(m.insert({i, i}).is_ok());
+        }
+
+        for (int i = 0; i < 100; i += 2) {
+            REQUIRE(m.erase(i) == 1);
+        }
+        REQUIRE(m.size() == 50);
+        for (int i = 0; i < 100; ++i) {
+            REQUIRE(m.contains(i) == (i % 2 == 1));
+        }
+
+        m.erase(m.find(1));
+        REQUIRE(!m.contains(1));
+        REQUIRE(m.size() == 49);
+    }
+
+    // NOLINTNEXTLINE (cert-err58-cpp)
+    TEST_CASE("reuses tombstones without growing") {
+        flat_hash_map<int, int> m;
+        REQUIRE(m.reserve(100).is_ok());
+        size_t capacity = m.capacity();
+
+        for (int i = 0; i < 10000; ++i) {
+            REQUIRE(m.insert({i, i}).is_ok());
+            REQUIRE(m.erase(i) == 1);
+        }
+        REQUIRE(m.empty());
+        REQUIRE(m.capacity() == capacity);
+    }
+
+    // NOLINTNEXTLINE (cert-err58-cpp)
+    TEST_CASE("drops tombstones without allocating") {
+        check_in_place_cleanup<std::hash<int>>();
+        check_in_place_cleanup<BadHash>();
+    }
+
+    // NOLINTNEXTLINE (cert-err58-cpp)
+    TEST_CASE("handles colliding hashes") {
+        flat_hash_map<int, int, BadHash> m;
+        for (int i = 0; i < 100; ++i) {
+            REQUIRE(m.insert({i, -i}).is_ok());
+        }
+        for (int i = 0; i < 100; ++i) {
+            REQUIRE(m.at(i).ok() == -i);
+        }
+    }
+
+    // NOLINTNEXTLINE (cert-err58-cpp)
+    TEST_CASE("iterates over all elements") {
+        flat_hash_map<int, int> m;
+        for (int i = 0; i < 100; ++i) {
+            REQUIRE(m.insert({i, 1}).is_ok());
+        }
+
+        int sum = 0;
+        for (const auto& e : m) {
+            sum += e.second;
+        }
+        REQUIRE(sum == 100);
+    }
+
+    // NOLINTNEXTLINE (cert-err58-cpp)
+    TEST_CASE("holds move-only values") {
+        flat_hash_map<int, std::unique_ptr<int>> m;
+        for (int i = 0; i < 100; ++i) {
+            REQUIRE(m.emplace(i, std::make_unique<int>(i)).is_ok());
+        }
+        for (int i = 0; i < 100; ++i) {
+            REQUIRE(*m.at(i).ok().get() == i);
+        }
+
+        auto m2 = std::move(m);
+        REQUIRE(m.empty());  // NOLINT (bugprone-use-after-move)
+        REQUIRE(m2.size() == 100);
+    }
+
+    // NOLINTNEXTLINE (cert-err58-cpp)
+    TEST_CASE("copy") {
+        flat_hash_map<int, int> m;
+        for (int i = 0; i < 100; ++i) {
+            REQUIRE(m.insert({i, i}).is_ok());
+        }
+
+        auto copy = m.copy();
+        REQUIRE(copy.is_ok());
+        REQUIRE(copy.ok().size() == 100);
+        for (int i = 0; i < 100; ++i) {
+            REQUIRE(copy.ok().at(i).ok() == i);
+        }
+    }
+
+    // NOLINTNEXTLINE (cert-err58-cpp)
+    TEST_CASE("reports out_of_memory") {
+        alignas(std::max_align_t) unsigned char buffer[512];
+        nestl::arena<> arena{buffer, sizeof(buffer)};
+        flat_hash_map<int, int, std::hash<int>, std::equal_to<int>,
+                      nestl::arena_allocator<>>
+            m{nestl::arena_allocator<>{arena}};
+
+        bool failed = false;
+        for (int i = 0; i < 1000 && !failed; ++i) {
+            failed = m.insert({i, i}).is_err();
+        }
+        REQUIRE(failed);
+        for (auto& e : m) {
+            REQUIRE(m.at(e.first).ok() == e.second);
+        }
+    }
+}
@@ -0,0 +1,282 @@
+//
+// Copyright 2018 Marcin Radomski. All rights reserved.
+//
+// Licensed under the MIT license. See LICENSE file in the project root for
+// details.
+//
+#include <doctest.h>
+
+#include <cstddef>
+
+#include <algorithm>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <utility>
+
+#include <nestl/arena_allocator.hpp>
+#include <nestl/flat_map.hpp>
+#include <nestl/flat_set.hpp>
+#include <nestl/result.hpp>
+
+namespace {
+
+template <typename S>
+bool equals(const S& s, std::initializer_list<int> ilist) {
+    return std::equal(s.begin(), s.end(), ilist.begin(), ilist.end());
+}
+
+template <typename M>
+bool has_keys(const M& m, std::initializer_list<int> ilist) {
+    return std::equal(m.keys().begin(), m.keys().end(), ilist.begin(),
+                      ilist.end());
+}
+
+}  // namespace
+
+TEST_SUITE("flat_set") {
+    using nestl::flat_set;
+
+    // NOLINTNEXTLINE (cert-err58-cpp)
+    TEST_CASE("is empty by default") {
+        flat_set<int> s;
+        REQUIRE(s.empty());
+        REQUIRE(s.find(1) == s.end());
+        REQUIRE(!s.contains(1));
+        REQUIRE(s.erase(1) == 0);
+    }
+
+    // NOLINTNEXTLINE (cert-err58-cpp)
+    TEST_CASE("keeps keys sorted and unique") {
+        flat_set<int> s;
+        for (int i : {5, 1, 4, 1, 3, 5, 2}) {
+            REQUIRE(s.insert(i).is_ok());
+        }
+        REQUIRE(equals(s, {1, 2, 3, 4, 5}));
+
+        auto res = s.insert(3);
+        REQUIRE(!res.ok().second);
+        REQUIRE(*res.ok().first == 3);
+    }
+
+    // NOLINTNEXTLINE (cert-err58-cpp)
+    TEST_CASE("lookup") {
+        flat_set<int> s;
+        for (int i = 0; i < 1000; i += 2) {
+            REQUIRE(s.insert(i).is_ok());
+        }
+
+        for (int i = -1; i < 1001; ++i) {
+            REQUIRE(s.contains(i) == (i >= 0 && i < 1000 && i % 2 == 0));
+            REQUIRE(s.lower_bound(i)
+                    == std::lower_bound(s.begin(), s.end(), i));
+        }
+    }
+
+    // NOLINTNEXTLINE (cert-err58-cpp)
+    TEST_CASE("custom comparator") {
+        flat_set<int, std::greater<int>> s;
+        for (int i : {1, 3, 2}) {
+            REQUIRE(s.insert(i).is_ok());
+        }
+        REQUIRE(equals(s, {3, 2, 1}));
+        REQUIRE(s.contains(2));
+    }
+
+    // NOLINTNEXTLINE (cert-err58-cpp)
+    TEST_CASE("erase") {
+        flat_set<int> s;
+        int keys[] = {1, 2, 3, 4};
+        REQUIRE(s.insert_sorted_range(std::begin(keys), std::end(keys))
+                    .is_ok());
+        REQUIRE(s.erase(2) == 1);
+        REQUIRE(s.erase(2) == 0);
+        REQUIRE(*s.erase(s.begin()) == 3);
+        REQUIRE(equals(s, {3, 4}));
+    }
+
+    // NOLINTNEXTLINE (cert-err58-cpp)
+    TEST_CASE("insert_sorted_range") {
+        flat_set<int> s;
+        for (int i : {2, 4, 6}) {
+            REQUIRE(s.insert(i).is_ok());
+        }
+
+        int keys[] = {1, 2, 2, 3, 7};
+        REQUIRE(s.insert_sorted_range(std::begin(keys), std::end(keys))
+                    .is_ok());
+        REQUIRE(equals(s, {1, 2, 3, 4, 6, 7}));
+    }
+
+    // NOLINTNEXTLINE (cert-err58-cpp)
+    TEST_CASE("insert_sorted_range moves from move_iterator") {
+        flat_set<std::unique_ptr<int>> s;
+        std::unique_ptr<int> keys[2] = {};
+        keys[1] = std::make_unique<int>(1);
+        std::sort(std::begin(keys), std::end(keys));
+
+        REQUIRE(s.insert_sorted_range(std::make_move_iterator(std::begin(keys)),
+                                      std::make_move_iterator(std::end(keys)))
+                    .is_ok());
+        REQUIRE(s.size() == 2);
+        REQUIRE(!keys[0]);
+        REQUIRE(!keys[1]);
+    }
+
+    // NOLINTNEXTLINE (cert-err58-cpp)
+    TEST_CASE("reports allocation failure") {
+        unsigned char buffer[128];
+        nestl::arena<> arena{buffer, sizeof(buffer)};
+        flat_set<int, std::less<int>, nestl::arena_allocator<>> s{
+            nestl::arena_allocator<>{arena}};
+
+        int i = 0;
+        while (s.insert(i).is_ok()) {
+            ++i;
+        }
+        REQUIRE(i > 0);
+        REQUIRE(s.size() == static_cast<size_t>(i));
+
+        int keys[] = {-2, -1};
+        REQUIRE(s.insert_sorted_range(std::begin(keys), std::end(keys))
+                    .is_err());
+        REQUIRE(s.size() == static_cast<size_t>(i));
+        REQUIRE(!s.contains(-1));
+    }
+
+    // NOLINTNEXTLINE (cert-err58-cpp)
+    TEST_CASE("copy") {
+        flat_set<int> s;
+        REQUIRE(s.insert(1).is_ok());
+
+        auto copy = s.copy();
+        REQUIRE(copy.is_ok());
+        REQUIRE(copy.ok() == s);
+    }
+}
+
+TEST_SUITE("flat_map") {
+    using nestl::flat_map;
+
+    // NOLINTNEXTLINE (cert-err58-cpp)
+    TEST_CASE("is empty by default") {
+        flat_map<int, int> m;
+        REQUIRE(m.empty());
+        REQUIRE(m.begin() == m.end());
+        REQUIRE(m.find(1) == m.end());
+        REQUIRE(m.erase(1) == 0);
+    }
+
+    // NOLINTNEXTLINE (cert-err58-cpp)
+    TEST_CASE("insert and find") {
+        flat_map<int, int> m;
+        for (int i = 999; i >= 0; --i) {
+            auto res = m.insert({i, i * 2});
+            REQUIRE(res.is_ok());
+            REQUIRE(res.ok().second);
+            REQUIRE(res.ok().first->first == i);
+        }
+
+        REQUIRE(m.size() == 1000);
+        REQUIRE(std::is_sorted(m.keys().begin(), m.keys().end()));
+        for (int i = 0; i < 1000; ++i) {
+            REQUIRE(m.find(i)->second == i * 2);
+        }
+        REQUIRE(!m.contains(1000));
+        REQUIRE(!m.contains(-1));
+    }
+
+    // NOLINTNEXTLINE (cert-err58-cpp)
+    TEST_CASE("does not overwrite existing keys") {
+        flat_map<int, int> m;
+        REQUIRE(m.insert({1, 1}).ok().second);
+
+        auto res = m.emplace(1, 2);
+        REQUIRE(!res.ok().second);
+        REQUIRE(res.ok().first->second == 1);
+        REQUIRE(m.size() == 1);
+    }
+
+    // NOLINTNEXTLINE (cert-err58-cpp)
+    TEST_CASE("values are mutable through iterators") {
+        flat_map<int, int> m;
+        REQUIRE(m.insert({1, 1}).is_ok());
+        REQUIRE(m.insert({2, 2}).is_ok());
+
+        for (auto [key, value] : m) {
+            value = key * 10;
+        }
+        m.find(2)->second += 1;
+
+        REQUIRE(m.values()[0] == 10);
+        REQUIRE(m.values()[1] == 21);
+        REQUIRE(m.end() - m.begin() == 2);
+        REQUIRE(m.begin()[1].first == 2);
+    }
+
+    // NOLINTNEXTLINE (cert-err58-cpp)
+    TEST_CASE("erase") {
+        flat_map<int, int> m;
+        for (int i = 0; i < 10; ++i) {
+            REQUIRE(m.insert({i, -i}).is_ok());
+        }
+
+        for (int i = 0; i < 10; i += 2) {
+            REQUIRE(m.erase(i) == 1);
+        }
+        REQUIRE(has_keys(m, {1, 3, 5, 7, 9}));
+
+        auto it = m.erase(m.find(3));
+        REQUIRE(it->first == 5);
+        REQUIRE(it->second == -5);
+        REQUIRE(has_keys(m, {1, 5, 7, 9}));
+    }
+
+    // NOLINTNEXTLINE (cert-err58-cpp)
+    TEST_CASE("insert_sorted_range") {
+        flat_map<int, int> m;
+        REQUIRE(m.insert({2, 2}).is_ok());
+        REQUIRE(m.insert({4, 4}).is_ok());
+
+        std::pair<int, int> elems[] = {{1, 10}, {2, 20}, {3, 30},
+                                       {3, 31}, {5, 50}};
+        REQUIRE(m.insert_sorted_range(std::begin(elems), std::end(elems))
+                    .is_ok());
+
+        REQUIRE(has_keys(m, {1, 2, 3, 4, 5}));
+        REQUIRE(m.find(1)->second == 10);
+        REQUIRE(m.find(2)->second == 2);
+        REQUIRE(m.find(3)->second == 30);
+        REQUIRE(m.find(4)->second == 4);
+        REQUIRE(m.find(5)->second == 50);
+    }
+
+    // NOLINTNEXTLINE (cert-err58-cpp)
+    TEST_CASE("reports allocation failure") {
+        unsigned char buffer[256];
+        nestl::arena<> arena{buffer, sizeof(buffer)};
+        flat_map<int, int, std::less<int>, nestl::arena_allocator<>> m{
+            nestl::arena_allocator<>{arena}};
+
+        int i = 0;
+        while (m.emplace(i, i).is_ok()) {
+            ++i;
+        }
+        REQUIRE(i > 0);
+        REQUIRE(m.keys().size() == m.values().size());
+        REQUIRE(m.size() == static_cast<size_t>(i));
+        REQUIRE(!m.contains(i));
+    }
+
+    // NOLINTNEXTLINE (cert-err58-cpp)
+    TEST_CASE("copy") {
+        flat_map<int, int> m;
+        REQUIRE(m.insert({1, 2}).is_ok());
+
+        auto copy = m.copy();
+        REQUIRE(copy.is_ok());
+        REQUIRE(copy.ok() == m);
+        REQUIRE(copy.ok().find(1)->second == 2);
+    }
+}
@@ -0,0 +1,108 @@
+//
+// Copyright 2018 Marcin Radomski. All rights reserved.
+//
+// Licensed under the MIT license. See LICENSE file in the project root for
+// details.
+//
+#include <doctest.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <nestl/growth_policy.hpp>
+#include <nestl/mmap_allocator.hpp>
+#include <nestl/result.hpp>
+#include <nestl/vector.hpp>
+
+TEST_SUITE("mmap_allocator") {
+    using nestl::mmap_allocator;
+
+    constexpr size_t threshold = 16 * 1024;
+
+    // NOLINTNEXTLINE (cert-err58-cpp)
+    TEST_CASE("maps large requests and forwards small ones") {
+        mmap_allocator<> alloc{threshold};
+
+        auto small = alloc.allocate(64);
+        REQUIRE(small.is_ok());
+        REQUIRE(!alloc.is_mapped(small.ok()));
+        REQUIRE(alloc.usable_size(small.ok()) >= 64);
+        std::memset(small.ok(), 0xAB, 64);
+
+        auto large = alloc.allocate(threshold + 1);
+        REQUIRE(large.is_ok());
+        REQUIRE(alloc.is_mapped(large.ok()));
+        REQUIRE(alloc.usable_size(large.ok()) >= threshold + 1);
+        std::memset(large.ok(), 0xCD, alloc.usable_size(large.ok()));
+
+        alloc.free(small.ok());
+        alloc.free(large.ok());
+        alloc.free(nullptr);
+    }
+
+    // NOLINTNEXTLINE (cert-err58-cpp)
+    TEST_CASE("keeps contents when a block moves to and within a mapping") {
+        mmap_allocator<> alloc{threshold};
+
+        auto res = alloc.reallocate(nullptr, 1000);
+        REQUIRE(res.is_ok());
+        auto* bytes = static_cast<unsigned char*>(res.ok());
+        for (size_t i = 0; i < 1000; ++i) {
+            bytes[i] = static_cast<unsigned char>(i);
+        }
+
+        res = alloc.reallocate(bytes, 2 * threshold);
+        REQUIRE(res.is_ok());
+        REQUIRE(alloc.is_mapped(res.ok()));
+        bytes = static_cast<unsigned char*>(res.ok());
+        bytes[2 * threshold - 1] = 0x42;
+
+        res = alloc.reallocate(bytes, 64 * threshold);
+        REQUIRE(res.is_ok());
+        bytes = static_cast<unsigned char*>(res.ok());
+        for (size_t i = 0; i < 1000; ++i) {
+            REQUIRE(bytes[i] == static_cast<unsigned char>(i));
+        }
+        REQUIRE(bytes[2 * threshold - 1] == 0x42);
+
+        // shrinking stays mapped
+        res = alloc.reallocate(bytes, 10);
+        REQUIRE(res.is_ok());
+        REQUIRE(alloc.is_mapped(res.ok()));
+        REQUIRE(static_cast<unsigned char*>(res.ok())[9] == 9);
+
+        alloc.free(res.ok());
+    }
+
+    // NOLINTNEXTLINE (cert-err58-cpp)
+    TEST_CASE("backs a growing vector") {
+        mmap_allocator<> alloc{threshold};
+        nestl::vector<uint64_t, mmap_allocator<>> v{alloc};
+        for (uint64_t i = 0; i < 100000; ++i) {
+            REQUIRE(v.push_back(i).is_ok());
+        }
+        REQUIRE(v.get_allocator().is_mapped(v.data()));
+        // capacity covers the whole mapping
+        REQUIRE((v.capacity() * sizeof(uint64_t) + 16) % 4096 == 0);
+        for (uint64_t i = 0; i < 100000; ++i) {
+            REQUIRE(v[i] == i);
+        }
+    }
+
+    // NOLINTNEXTLINE (cert-err58-cpp)
+    TEST_CASE("falls back to regular pages without huge pages") {
+        using alloc_t = mmap_allocator<>;
+        alloc_t alloc{threshold, nestl::huge_pages::explicit_pool};
+
+        auto res = alloc.allocate(threshold);
+        REQUIRE(res.is_ok());
+        REQUIRE(alloc.usable_size(res.ok()) + 16 == alloc_t::huge_page_size);
+        static_cast<char*>(res.ok())[threshold - 1] = 1;
+
+        res = alloc.reallocate(res.ok(), alloc_t::huge_page_size);
+        REQUIRE(res.is_ok());
+        REQUIRE(static_cast<char*>(res.ok())[threshold - 1] == 1);
+        alloc.free(res.ok());
+    }
+}
@@ -0,0 +1,123 @@
+//
+// Copyright 2018 Marcin Radomski. All rights reserved.
+//
+// Licensed under the MIT license. See LICENSE file in the project root for
+// details.
+//
+#include <doctest.h>
+
+#include <cstddef>
+#include <cstdint>
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <nestl/arena_allocator.hpp>
+#include <nestl/mpmc_queue.hpp>
+#include <nestl/result.hpp>
+
+TEST_SUITE("mpmc_queue") {
+    using nestl::mpmc_queue;
+
+    // NOLINTNEXTLINE (cert-err58-cpp)
+    TEST_CASE("push and pop") {
+        mpmc_queue<int> q;
+        REQUIRE(q.capacity() == 0);
+        REQUIRE(q.init(3).is_ok());
+        REQUIRE(q.capacity() == 4);
+        REQUIRE(q.try_pop().is_err());
+
+        for (int lap = 0; lap < 3; ++lap) {
+            for (int i = 0; i < 4; ++i) {
+                REQUIRE(q.try_push(i).is_ok());
+            }
+            REQUIRE(q.try_push(4).is_err());
+            REQUIRE(q.size_approx() == 4);
+            for (int i = 0; i < 4; ++i) {
+                REQUIRE(q.try_pop().ok() == i);
+            }
+            REQUIRE(q.try_pop().is_err());
+        }
+
+        q.push(5);
+        REQUIRE(q.pop() == 5);
+    }
+
+    // NOLINTNEXTLINE (cert-err58-cpp)
+    TEST_CASE("move-only elements") {
+        mpmc_queue<std::unique_ptr<std::string>> q;
+        REQUIRE(q.init(2).is_ok());
+        REQUIRE(q.try_emplace(new std::string("a")).is_ok());
+        q.push(std::make_unique<std::string>("b"));
+        auto full = std::make_unique<std::string>("c");
+        REQUIRE(q.try_push(std::move(full)).is_err());
+        REQUIRE(*q.pop() == "a");
+        // "b" is destroyed with the queue
+    }
+
+    // NOLINTNEXTLINE (cert-err58-cpp)
+    TEST_CASE("reports allocation failure") {
+        alignas(std::max_align_t) unsigned char buffer[64];
+        nestl::arena<> arena{buffer, sizeof(buffer)};
+        mpmc_queue<uint64_t, nestl::arena_allocator<>> q{
+            nestl::arena_allocator<>{arena}};
+        REQUIRE(q.init(16).is_err());
+        REQUIRE(q.capacity() == 0);
+        REQUIRE(q.try_push(1).is_err());
+        REQUIRE(q.try_pop().is_err());
+    }
+
+    // NOLINTNEXTLINE (cert-err58-cpp)
+    TEST_CASE("is full and empty before init") {
+        mpmc_queue<std::string> q;
+        REQUIRE(q.try_push("a").is_err());
+        REQUIRE(q.try_emplace(3, 'b').is_err());
+        REQUIRE(q.try_pop().is_err());
+        REQUIRE(q.size_approx() == 0);
+    }
+
+    // NOLINTNEXTLINE (cert-err58-cpp)
+    TEST_CASE("delivers every element once to many threads") {
+        constexpr uint64_t per_producer = 20000;
+        constexpr int producers = 4;
+        constexpr int consumers = 4;
+        mpmc_queue<uint64_t> q;
+        REQUIRE(q.init(16).is_ok());
+
+        std::vector<std::atomic<uint8_t>> seen(per_producer * producers);
+        std::atomic<uint64_t> duplicates{0};
+        std::vector<std::thread> threads;
+        for (int p = 0; p < producers; ++p) {
+            threads.emplace_back([&q, p] {
+                for (uint64_t i = 0; i < per_producer; ++i) {
+                    uint64_t e = static_cast<uint64_t>(p) * per_producer + i;
+                    if (i % 2 == 0) {
+                        q.push(e);
+                    } else {
+                        while (!q.try_push(e)) {
+                            std::this_thread::yield();
+                        }
+                    }
+                }
+            });
+        }
+        for (int c = 0; c < consumers; ++c) {
+            threads.emplace_back([&] {
+                for (uint64_t i = 0; i < per_producer; ++i) {
+                    if (seen[q.pop()].fetch_add(1) != 0) {
+                        ++duplicates;
+                    }
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+
+        REQUIRE(duplicates == 0);
+        REQUIRE(q.try_pop().is_err());
+    }
+}
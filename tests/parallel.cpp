@@ -0,0 +1,150 @@
+//
+// Copyright 2018 Marcin Radomski. All rights reserved.
+//
+// Licensed under the MIT license. See LICENSE file in the project root for
+// details.
+//
+#include <doctest.h>
+
+#include <cstddef>
+#include <cstdint>
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <random>
+#include <string>
+
+#include <nestl/arena_allocator.hpp>
+#include <nestl/parallel.hpp>
+#include <nestl/result.hpp>
+#include <nestl/thread_pool.hpp>
+#include <nestl/vector.hpp>
+
+namespace {
+
+nestl::vector<uint32_t> random_values(size_t count, uint32_t max) {
+    std::mt19937 rng{42};
+    std::uniform_int_distribution<uint32_t> dist{0, max};
+    nestl::vector<uint32_t> v;
+    REQUIRE(v.reserve(count).is_ok());
+    for (size_t i = 0; i < count; ++i) {
+        REQUIRE(v.push_back(dist(rng)).is_ok());
+    }
+    return v;
+}
+
+}  // namespace
+
+TEST_SUITE("parallel") {
+    using nestl::thread_pool;
+
+    // NOLINTNEXTLINE (cert-err58-cpp)
+    TEST_CASE("for_each and transform visit every element once") {
+        thread_pool<> pool;
+        REQUIRE(pool.start(4).is_ok());
+
+        nestl::vector<uint32_t> v;
+        REQUIRE(v.resize(100000).is_ok());
+        nestl::par::for_each(pool, v, [](uint32_t& e) { ++e; });
+        REQUIRE(std::all_of(v.begin(), v.end(),
+                            [](uint32_t e) { return e == 1; }));
+
+        nestl::vector<uint64_t> out;
+        REQUIRE(out.resize(v.size()).is_ok());
+        for (size_t i = 0; i < v.size(); ++i) {
+            v[i] = static_cast<uint32_t>(i);
+        }
+        nestl::par::transform(pool, v, out, [](uint32_t e) {
+            return uint64_t{e} * 3;
+        });
+        for (size_t i = 0; i < out.size(); ++i) {
+            REQUIRE(out[i] == i * 3);
+        }
+
+        nestl::vector<uint32_t> empty;
+        nestl::par::for_each(pool, empty, [](uint32_t&) { FAIL("called"); });
+    }
+
+    // NOLINTNEXTLINE (cert-err58-cpp)
+    TEST_CASE("reduce") {
+        thread_pool<> pool;
+        REQUIRE(pool.start(4).is_ok());
+
+        nestl::vector<uint64_t> v;
+        for (uint64_t i = 1; i <= 100000; ++i) {
+            REQUIRE(v.push_back(i).is_ok());
+        }
+        REQUIRE(nestl::par::reduce(pool, v, uint64_t{7})
+                == 7 + uint64_t{100000} * 100001 / 2);
+        REQUIRE(nestl::par::reduce(pool, v, uint64_t{0},
+                                   [](uint64_t a, uint64_t b) {
+                                       return std::max(a, b);
+                                   })
+                == 100000);
+
+        nestl::vector<uint64_t> empty;
+        REQUIRE(nestl::par::reduce(pool, empty, uint64_t{7}) == 7);
+    }
+
+    // NOLINTNEXTLINE (cert-err58-cpp)
+    TEST_CASE("sort") {
+        thread_pool<> pool;
+        REQUIRE(pool.start(4).is_ok());
+
+        SUBCASE("many duplicates, uneven blocks") {
+            auto v = random_values(300007, 1000);
+            auto expected = v.copy().ok();
+            std::sort(expected.begin(), expected.end());
+            REQUIRE(nestl::par::sort(pool, v).is_ok());
+            REQUIRE(v == expected);
+        }
+
+        SUBCASE("custom order") {
+            auto v = random_values(100000, 0xffffffff);
+            REQUIRE(nestl::par::sort(pool, v, std::greater<>()).is_ok());
+            REQUIRE(std::is_sorted(v.begin(), v.end(), std::greater<>()));
+        }
+
+        SUBCASE("small ranges are sorted in place") {
+            auto v = random_values(1000, 100);
+            REQUIRE(nestl::par::sort(pool, v).is_ok());
+            REQUIRE(std::is_sorted(v.begin(), v.end()));
+        }
+
+        SUBCASE("non-trivial type") {
+            nestl::vector<std::unique_ptr<std::string>> v;
+            auto keys = random_values(70000, 50000);
+            for (uint32_t k : keys) {
+                REQUIRE(v.push_back(std::make_unique<std::string>(
+                                        std::to_string(k)))
+                            .is_ok());
+            }
+            REQUIRE(nestl::par::sort(pool, v, [](const auto& a,
+                                                 const auto& b) {
+                        return *a < *b;
+                    }).is_ok());
+            REQUIRE(std::is_sorted(
+                v.begin(), v.end(),
+                [](const auto& a, const auto& b) { return *a < *b; }));
+            REQUIRE(std::all_of(v.begin(), v.end(),
+                                [](const auto& e) { return e != nullptr; }));
+        }
+    }
+
+    // NOLINTNEXTLINE (cert-err58-cpp)
+    TEST_CASE("sort reports scratch allocation failure") {
+        // room for the pool, but not for the scratch buffer
+        static unsigned char buffer[256 * 1024];
+        nestl::arena<> arena{buffer, sizeof(buffer)};
+        thread_pool<nestl::arena_allocator<>> pool{
+            nestl::arena_allocator<>{arena}, 64};
+        REQUIRE(pool.start(2).is_ok());
+
+        auto v = random_values(100000, 1000);
+        auto original = v.copy().ok();
+        REQUIRE(nestl::par::sort(pool, v).is_err());
+        REQUIRE(v == original);
+    }
+}
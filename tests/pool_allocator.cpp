@@ -0,0 +1,84 @@
+//
+// Copyright 2018 Marcin Radomski. All rights reserved.
+//
+// Licensed under the MIT license. See LICENSE file in the project root for
+// details.
+//
+#include <doctest.h>
+
+#include <cstddef>
+
+#include <nestl/pool_allocator.hpp>
+#include <nestl/vector.hpp>
+
+TEST_SUITE("pool_allocator") {
+    using nestl::pool_allocator;
+    using nestl::slab_pool;
+
+    // NOLINTNEXTLINE (cert-err58-cpp)
+    TEST_CASE("reuses freed blocks of the same size class") {
+        slab_pool<> pool{64 * 1024};
+
+        void* p = pool.allocate(20).ok();
+        pool.free(p);
+        REQUIRE(pool.allocate(32).ok() == p);
+    }
+
+    // NOLINTNEXTLINE (cert-err58-cpp)
+    TEST_CASE("keeps size classes apart") {
+        slab_pool<> pool{64 * 1024, 1024};
+
+        auto* small = static_cast<unsigned char*>(pool.allocate(16).ok());
+        auto* big = static_cast<unsigned char*>(pool.allocate(512).ok());
+        REQUIRE((small + 1024 <= big || big + 1024 <= small));
+    }
+
+    // NOLINTNEXTLINE (cert-err58-cpp)
+    TEST_CASE("reports out_of_memory when exhausted") {
+        slab_pool<> pool{2 * 1024, 1024};
+
+        REQUIRE(pool.allocate(1024).is_ok());
+        REQUIRE(pool.allocate(1024).is_ok());
+        REQUIRE(pool.allocate(1024).is_err());
+        REQUIRE(pool.allocate(16).is_err());
+    }
+
+    // NOLINTNEXTLINE (cert-err58-cpp)
+    TEST_CASE("rejects blocks bigger than a slab") {
+        slab_pool<> pool{64 * 1024, 1024};
+
+        REQUIRE(pool.max_block_size() == 1024);
+        REQUIRE(pool.allocate(1025).is_err());
+    }
+
+    // NOLINTNEXTLINE (cert-err58-cpp)
+    TEST_CASE("reallocate keeps the block while it fits") {
+        slab_pool<> pool{64 * 1024, 1024};
+
+        auto* p = static_cast<int*>(pool.allocate(sizeof(int)).ok());
+        *p = 42;
+        REQUIRE(pool.reallocate(p, 16).ok() == p);
+
+        auto res = pool.reallocate(p, 64);
+        REQUIRE(res.is_ok());
+        REQUIRE(res.ok() != p);
+        REQUIRE(*static_cast<int*>(res.ok()) == 42);
+    }
+
+    // NOLINTNEXTLINE (cert-err58-cpp)
+    TEST_CASE("backs vectors") {
+        slab_pool<> pool{1024 * 1024};
+
+        nestl::vector<int, pool_allocator<>> v1{pool_allocator<>{pool}};
+        nestl::vector<int, pool_allocator<>> v2{pool_allocator<>{pool}};
+        for (int i = 0; i < 100; ++i) {
+            REQUIRE(v1.push_back(i).is_ok());
+            REQUIRE(v2.push_back(-i).is_ok());
+        }
+
+        for (size_t i = 0; i < 100; ++i) {
+            REQUIRE(v1[i] == static_cast<int>(i));
+            REQUIRE(v2[i] == -static_cast<int>(i));
+        }
+    }
+}
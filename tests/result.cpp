@@ -8,7 +8,14 @@
 
 #include <doctest.h>
 
+#include <nestl/allocator.hpp>
+
+#include <cstdint>
+
+#include <functional>
+#include <memory>
 #include <stdexcept>
+#include <type_traits>
 
 #include "test_utils.hpp"
 
@@ -213,4 +220,78 @@ TEST_SUITE("result") {
         REQUIRE(!noexcept(result<void, int>::err(1).map_err(int_except)));
         REQUIRE(noexcept(result<void, int>::err(1).map_err(int_no_except)));
     }
+
+    // NOLINTNEXTLINE (cert-err58-cpp)
+    TEST_CASE("is trivial if T and E are") {
+        struct Error {};
+
+        static_assert(std::is_trivially_copyable_v<result<int*, Error>>);
+        static_assert(std::is_trivially_destructible_v<result<int*, Error>>);
+        static_assert(std::is_trivially_copyable_v<result<void, Error>>);
+        static_assert(std::is_trivially_copyable_v<result<void, void>>);
+        static_assert(!std::is_copy_constructible_v<result<int*, Error>>);
+
+        using owning = result<std::unique_ptr<int>, Error>;
+        static_assert(!std::is_trivially_copyable_v<owning>);
+        static_assert(!std::is_trivially_destructible_v<owning>);
+        static_assert(std::is_nothrow_move_constructible_v<owning>);
+
+        auto a = owning::ok(std::make_unique<int>(1));
+        auto b = std::move(a);
+        REQUIRE(*b.ok() == 1);
+        a = std::move(b);
+        REQUIRE(*a.ok() == 1);
+    }
+
+    // NOLINTNEXTLINE (cert-err58-cpp)
+    TEST_CASE("stores the Err state in a niche of T if E is empty") {
+        struct Error {};
+        using nestl::out_of_memory;
+
+        static_assert(sizeof(result<void*, out_of_memory>) == sizeof(void*));
+        static_assert(sizeof(result<int*, out_of_memory>) == sizeof(int*));
+        static_assert(sizeof(result<std::reference_wrapper<int>, Error>)
+                      == sizeof(int*));
+        static_assert(sizeof(result<int*, int>) > sizeof(int*));
+        static_assert(sizeof(result<int, Error>) > sizeof(int));
+
+        int value = 1;
+
+        auto null = result<int*, out_of_memory>::ok(nullptr);
+        REQUIRE(null.is_ok());
+        REQUIRE(null.ok() == nullptr);
+
+        auto ptr = result<int*, out_of_memory>::ok(&value);
+        REQUIRE(ptr.is_ok());
+        REQUIRE(ptr.ok() == &value);
+
+        auto err = result<int*, out_of_memory>::err(out_of_memory{});
+        REQUIRE(err.is_err());
+        auto moved = std::move(err);
+        REQUIRE(moved.is_err());
+        moved = std::move(ptr);
+        REQUIRE(moved.is_ok());
+        REQUIRE(*moved.ok() == 1);
+
+        using ref = result<std::reference_wrapper<int>, Error>;
+        auto r = ref::ok(std::ref(value));
+        REQUIRE(r.is_ok());
+        r.ok().get() = 2;
+        REQUIRE(value == 2);
+        REQUIRE(ref::err(Error{}).is_err());
+    }
+
+    // NOLINTNEXTLINE (cert-err58-cpp)
+    TEST_CASE("pointers only use the niche if the error type opts in") {
+        struct Error {};
+
+        // e.g. MAP_FAILED, or a sentinel
+        auto* all_ones = reinterpret_cast<int*>(~uintptr_t{0});
+
+        static_assert(sizeof(result<int*, Error>) > sizeof(int*));
+        auto r = result<int*, Error>::ok(std::move(all_ones));
+        REQUIRE(r.is_ok());
+        REQUIRE(r.ok() == all_ones);
+        REQUIRE(result<int*, Error>::err(Error{}).is_err());
+    }
 }
@@ -0,0 +1,200 @@
+//
+// Copyright 2018 Marcin Radomski. All rights reserved.
+//
+// Licensed under the MIT license. See LICENSE file in the project root for
+// details.
+//
+#include <doctest.h>
+
+#include <cstddef>
+
+#include <algorithm>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <utility>
+
+#include <nestl/allocator.hpp>
+#include <nestl/growth_policy.hpp>
+#include <nestl/result.hpp>
+#include <nestl/small_vector.hpp>
+
+namespace {
+
+class counting_allocator : public nestl::system_allocator {
+public:
+    std::shared_ptr<size_t> allocations = std::make_shared<size_t>(0);
+
+    nestl::result<void*, nestl::out_of_memory> allocate(size_t size) noexcept {
+        ++*allocations;
+        return system_allocator::allocate(size);
+    }
+
+    nestl::result<void*, nestl::out_of_memory> reallocate(
+        void* p, size_t new_size) noexcept {
+        ++*allocations;
+        return system_allocator::reallocate(p, new_size);
+    }
+};
+
+template <typename V>
+bool equals(const V& v, std::initializer_list<int> ilist) {
+    return std::equal(v.begin(), v.end(), ilist.begin(), ilist.end());
+}
+
+}  // namespace
+
+TEST_SUITE("small_vector") {
+    using nestl::small_vector;
+
+    // NOLINTNEXTLINE (cert-err58-cpp)
+    TEST_CASE("does not allocate until inline capacity is exceeded") {
+        counting_allocator alloc;
+        small_vector<int, 4, counting_allocator> v{alloc};
+
+        for (int i = 0; i < 4; ++i) {
+            REQUIRE(v.push_back(i).is_ok());
+        }
+        REQUIRE(v.is_inline());
+        REQUIRE(*alloc.allocations == 0);
+
+        REQUIRE(v.push_back(4).is_ok());
+        REQUIRE(!v.is_inline());
+        REQUIRE(*alloc.allocations == 1);
+        REQUIRE(equals(v, {0, 1, 2, 3, 4}));
+    }
+
+    // NOLINTNEXTLINE (cert-err58-cpp)
+    TEST_CASE("bulk insertions grow geometrically") {
+        counting_allocator alloc;
+        small_vector<int, 4, counting_allocator> v{alloc};
+
+        const int values[] = {1, 2, 3};
+        for (int i = 0; i < 100; ++i) {
+            REQUIRE(v.insert(v.end(), std::begin(values), std::end(values))
+                        .is_ok());
+            REQUIRE(v.insert(v.end(), size_t{2}, 0).is_ok());
+            REQUIRE(v.resize(v.size() + 1).is_ok());
+        }
+        REQUIRE(v.size() == 600);
+        // 4 -> 6 -> 9 -> ... -> 600+, instead of one call per insertion
+        REQUIRE(*alloc.allocations < 20);
+    }
+
+    // NOLINTNEXTLINE (cert-err58-cpp)
+    TEST_CASE("takes a growth policy") {
+        small_vector<int, 2, nestl::system_allocator, nestl::exact_growth> v;
+        for (int i = 0; i < 5; ++i) {
+            REQUIRE(v.push_back(i).is_ok());
+            REQUIRE(v.capacity() == std::max<size_t>(2, v.size()));
+        }
+
+        small_vector<int, 2, nestl::system_allocator,
+                     nestl::geometric_growth<2, 1>>
+            doubling;
+        for (int i = 0; i < 5; ++i) {
+            REQUIRE(doubling.push_back(i).is_ok());
+        }
+        REQUIRE(doubling.capacity() == 8);
+    }
+
+    // NOLINTNEXTLINE (cert-err58-cpp)
+    TEST_CASE("insert and erase") {
+        small_vector<int, 2> v;
+        REQUIRE(v.assign({1, 4}).is_ok());
+        REQUIRE(v.insert(v.begin() + 1, {2, 3}).is_ok());
+        REQUIRE(equals(v, {1, 2, 3, 4}));
+
+        v.erase(v.begin(), v.begin() + 2);
+        REQUIRE(equals(v, {3, 4}));
+
+        REQUIRE(v.emplace(v.begin(), 0).ok() == v.begin());
+        REQUIRE(equals(v, {0, 3, 4}));
+    }
+
+    // NOLINTNEXTLINE (cert-err58-cpp)
+    TEST_CASE("shrink_to_fit moves elements back inline") {
+        small_vector<int, 2> v;
+        REQUIRE(v.assign({1, 2, 3}).is_ok());
+        REQUIRE(!v.is_inline());
+
+        v.pop_back();
+        v.shrink_to_fit();
+        REQUIRE(v.is_inline());
+        REQUIRE(v.capacity() == 2);
+        REQUIRE(equals(v, {1, 2}));
+    }
+
+    // NOLINTNEXTLINE (cert-err58-cpp)
+    TEST_CASE("is movable") {
+        SUBCASE("inline") {
+            small_vector<std::unique_ptr<int>, 2> v1;
+            REQUIRE(v1.push_back(std::make_unique<int>(1)).is_ok());
+
+            auto v2 = std::move(v1);
+            REQUIRE(v1.empty());  // NOLINT (bugprone-use-after-move)
+            REQUIRE(v2.size() == 1);
+            REQUIRE(*v2[0] == 1);
+        }
+
+        SUBCASE("spilled") {
+            small_vector<int, 1> v1;
+            REQUIRE(v1.assign({1, 2, 3}).is_ok());
+            const int* data = v1.data();
+
+            small_vector<int, 1> v2;
+            REQUIRE(v2.push_back(4).is_ok());
+            v2 = std::move(v1);
+            REQUIRE(v2.data() == data);
+            REQUIRE(equals(v2, {1, 2, 3}));
+            REQUIRE(v1.empty());  // NOLINT (bugprone-use-after-move)
+            REQUIRE(v1.is_inline());
+        }
+    }
+
+    // NOLINTNEXTLINE (cert-err58-cpp)
+    TEST_CASE("swap") {
+        small_vector<int, 2> v1;
+        REQUIRE(v1.assign({1}).is_ok());
+
+        small_vector<int, 2> v2;
+        REQUIRE(v2.assign({2, 3, 4}).is_ok());
+
+        v1.swap(v2);
+        REQUIRE(equals(v1, {2, 3, 4}));
+        REQUIRE(equals(v2, {1}));
+    }
+
+    // NOLINTNEXTLINE (cert-err58-cpp)
+    TEST_CASE("copy") {
+        small_vector<int, 2> v;
+        REQUIRE(v.assign({1, 2, 3}).is_ok());
+
+        auto copy = v.copy();
+        REQUIRE(copy.is_ok());
+        REQUIRE(copy.ok() == v);
+    }
+
+    // NOLINTNEXTLINE (cert-err58-cpp)
+    TEST_CASE("compare") {
+        small_vector<int, 2> a;
+        REQUIRE(a.assign({1, 2}).is_ok());
+        small_vector<int, 2> b;
+        REQUIRE(b.assign({1, 2, 3}).is_ok());
+
+        REQUIRE(a != b);
+        REQUIRE(a < b);
+        REQUIRE(b > a);
+        REQUIRE(a <= a);
+        REQUIRE(a >= a);
+    }
+
+    // NOLINTNEXTLINE (cert-err58-cpp)
+    TEST_CASE("resize") {
+        small_vector<int, 2> v;
+        REQUIRE(v.resize(3).is_ok());
+        REQUIRE(equals(v, {0, 0, 0}));
+        REQUIRE(v.resize(1).is_ok());
+        REQUIRE(equals(v, {0}));
+    }
+}
@@ -0,0 +1,163 @@
+//
+// Copyright 2018 Marcin Radomski. All rights reserved.
+//
+// Licensed under the MIT license. See LICENSE file in the project root for
+// details.
+//
+#include <doctest.h>
+
+#include <cstddef>
+#include <cstdint>
+
+#include <string>
+#include <thread>
+
+#include <nestl/arena_allocator.hpp>
+#include <nestl/result.hpp>
+#include <nestl/spsc_queue.hpp>
+
+TEST_SUITE("spsc_queue") {
+    using nestl::spsc_queue;
+
+    // NOLINTNEXTLINE (cert-err58-cpp)
+    TEST_CASE("push and pop") {
+        spsc_queue<int> q;
+        REQUIRE(q.capacity() == 0);
+        REQUIRE(q.init(3).is_ok());
+        REQUIRE(q.capacity() == 4);
+        REQUIRE(q.try_pop().is_err());
+
+        for (int i = 0; i < 4; ++i) {
+            REQUIRE(q.try_push(i).is_ok());
+        }
+        REQUIRE(q.try_push(4).is_err());
+        REQUIRE(q.size_approx() == 4);
+
+        REQUIRE(q.try_pop().ok() == 0);
+        REQUIRE(q.try_push(4).is_ok());
+        for (int i = 1; i < 5; ++i) {
+            REQUIRE(q.try_pop().ok() == i);
+        }
+        REQUIRE(q.try_pop().is_err());
+        REQUIRE(q.empty_approx());
+    }
+
+    // NOLINTNEXTLINE (cert-err58-cpp)
+    TEST_CASE("batches wrap around the ring") {
+        spsc_queue<int> q;
+        REQUIRE(q.init(8).is_ok());
+
+        int in[6] = {0, 1, 2, 3, 4, 5};
+        int out[8] = {};
+        REQUIRE(q.push_n(in, 6) == 6);
+        REQUIRE(q.pop_n(out, 4) == 4);
+        REQUIRE(out[3] == 3);
+
+        // 2 left, room for 6 more
+        REQUIRE(q.push_n(in, 6) == 6);
+        REQUIRE(q.push_n(in, 6) == 0);
+        REQUIRE(q.pop_n(out, 8) == 8);
+        int expected[8] = {4, 5, 0, 1, 2, 3, 4, 5};
+        for (size_t i = 0; i < 8; ++i) {
+            REQUIRE(out[i] == expected[i]);
+        }
+        REQUIRE(q.pop_n(out, 8) == 0);
+
+        REQUIRE(q.push_n(in, 3) == 3);
+        REQUIRE(q.push_n(in, 6) == 5);
+    }
+
+    // NOLINTNEXTLINE (cert-err58-cpp)
+    TEST_CASE("big batches of trivial types wrap around the ring") {
+        spsc_queue<uint32_t> q;
+        REQUIRE(q.init(64).is_ok());
+
+        uint32_t in[48];
+        uint32_t out[64];
+        uint32_t next_in = 0;
+        uint32_t next_out = 0;
+        for (int round = 0; round < 10; ++round) {
+            for (uint32_t& e : in) {
+                e = next_in++;
+            }
+            REQUIRE(q.push_n(in, 48) == 48);
+            REQUIRE(q.pop_n(out, 40) == 40);
+            for (size_t i = 0; i < 40; ++i) {
+                REQUIRE(out[i] == next_out++);
+            }
+            REQUIRE(q.pop_n(out, 8) == 8);
+            next_out += 8;
+        }
+        REQUIRE(q.pop_n(out, 64) == 0);
+    }
+
+    // NOLINTNEXTLINE (cert-err58-cpp)
+    TEST_CASE("destroys elements left in the queue") {
+        spsc_queue<std::string> q;
+        REQUIRE(q.init(4).is_ok());
+        REQUIRE(q.try_push(std::string(100, 'a')).is_ok());
+        REQUIRE(q.try_emplace(100, 'b').is_ok());
+        REQUIRE(q.try_pop().ok() == std::string(100, 'a'));
+        REQUIRE(q.try_push(std::string(100, 'c')).is_ok());
+    }
+
+    // NOLINTNEXTLINE (cert-err58-cpp)
+    TEST_CASE("reports allocation failure") {
+        alignas(std::max_align_t) unsigned char buffer[64];
+        nestl::arena<> arena{buffer, sizeof(buffer)};
+        spsc_queue<uint64_t, nestl::arena_allocator<>> q{
+            nestl::arena_allocator<>{arena}};
+        REQUIRE(q.init(16).is_err());
+        REQUIRE(q.capacity() == 0);
+    }
+
+    // NOLINTNEXTLINE (cert-err58-cpp)
+    TEST_CASE("hands elements over between threads in order") {
+        constexpr uint64_t count = 200000;
+        spsc_queue<uint64_t> q;
+        REQUIRE(q.init(64).is_ok());
+
+        std::thread producer([&q] {
+            uint64_t batch[7];
+            uint64_t next = 0;
+            while (next < count) {
+                if (next % 3 == 0) {
+                    if (q.try_push(next)) {
+                        ++next;
+                    } else {
+                        std::this_thread::yield();
+                    }
+                    continue;
+                }
+                size_t n = 0;
+                for (; n < 7 && next + n < count; ++n) {
+                    batch[n] = next + n;
+                }
+                size_t pushed = q.push_n(batch, n);
+                if (pushed == 0) {
+                    std::this_thread::yield();
+                }
+                next += pushed;
+            }
+        });
+
+        uint64_t expected = 0;
+        bool in_order = true;
+        uint64_t batch[5];
+        while (expected < count) {
+            size_t n = q.pop_n(batch, 5);
+            for (size_t i = 0; i < n; ++i) {
+                in_order = in_order && batch[i] == expected++;
+            }
+            if (auto res = q.try_pop()) {
+                in_order = in_order && res.ok() == expected++;
+            } else if (n == 0) {
+                std::this_thread::yield();
+            }
+        }
+        producer.join();
+
+        REQUIRE(in_order);
+        REQUIRE(q.try_pop().is_err());
+    }
+}
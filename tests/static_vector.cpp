@@ -0,0 +1,110 @@
+//
+// Copyright 2018 Marcin Radomski. All rights reserved.
+//
+// Licensed under the MIT license. See LICENSE file in the project root for
+// details.
+//
+#include <doctest.h>
+
+#include <algorithm>
+#include <initializer_list>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+#include <nestl/result.hpp>
+#include <nestl/static_vector.hpp>
+
+namespace {
+
+template <typename V>
+bool equals(const V& v, std::initializer_list<int> ilist) {
+    return std::equal(v.begin(), v.end(), ilist.begin(), ilist.end());
+}
+
+}  // namespace
+
+TEST_SUITE("static_vector") {
+    using nestl::static_vector;
+
+    static_assert(std::is_trivially_copyable_v<static_vector<int, 4>>);
+    static_assert(
+        !std::is_trivially_copyable_v<static_vector<std::unique_ptr<int>, 4>>);
+    static_assert(static_vector<int, 4>{nestl::zero_fill_t{}}.capacity() == 4);
+    static_assert(static_vector<int, 4>{nestl::zero_fill_t{}}.empty());
+    static_assert(
+        !std::is_constructible_v<static_vector<std::unique_ptr<int>, 4>,
+                                 nestl::zero_fill_t>);
+
+    // NOLINTNEXTLINE (cert-err58-cpp)
+    TEST_CASE("fails with out_of_memory when full") {
+        static_vector<int, 2> v;
+        REQUIRE(v.push_back(1).is_ok());
+        REQUIRE(v.push_back(2).is_ok());
+        REQUIRE(v.push_back(3).is_err());
+        REQUIRE(v.insert(v.begin(), 0).is_err());
+        REQUIRE(v.insert(v.begin(), {0, 0}).is_err());
+        REQUIRE(v.resize(3).is_err());
+        REQUIRE(equals(v, {1, 2}));
+    }
+
+    // NOLINTNEXTLINE (cert-err58-cpp)
+    TEST_CASE("insert and erase") {
+        static_vector<int, 8> v;
+        REQUIRE(v.assign({1, 4}).is_ok());
+        REQUIRE(v.insert(v.begin() + 1, {2, 3}).is_ok());
+        REQUIRE(equals(v, {1, 2, 3, 4}));
+
+        v.erase(v.begin(), v.begin() + 2);
+        REQUIRE(equals(v, {3, 4}));
+
+        REQUIRE(v.emplace(v.begin(), 0).ok() == v.begin());
+        REQUIRE(equals(v, {0, 3, 4}));
+    }
+
+    // NOLINTNEXTLINE (cert-err58-cpp)
+    TEST_CASE("trivially copyable when T is") {
+        static_vector<int, 4> v1;
+        REQUIRE(v1.assign({1, 2}).is_ok());
+
+        auto v2 = v1;
+        REQUIRE(v2 == v1);
+        v2[0] = 3;
+        REQUIRE(v2 != v1);
+        REQUIRE(v1 < v2);
+    }
+
+    // NOLINTNEXTLINE (cert-err58-cpp)
+    TEST_CASE("holds non-trivial types") {
+        static_vector<std::unique_ptr<int>, 4> v1;
+        REQUIRE(v1.push_back(std::make_unique<int>(1)).is_ok());
+        REQUIRE(v1.emplace(v1.begin(), std::make_unique<int>(0)).is_ok());
+
+        auto v2 = std::move(v1);
+        REQUIRE(v1.empty());  // NOLINT (bugprone-use-after-move)
+        REQUIRE(v2.size() == 2);
+        REQUIRE(*v2[0] == 0);
+        REQUIRE(*v2[1] == 1);
+
+        v2.erase(v2.begin());
+        REQUIRE(*v2.front() == 1);
+    }
+
+    // NOLINTNEXTLINE (cert-err58-cpp)
+    TEST_CASE("swap") {
+        static_vector<std::unique_ptr<int>, 4> v1;
+        REQUIRE(v1.push_back(std::make_unique<int>(1)).is_ok());
+        static_vector<std::unique_ptr<int>, 4> v2;
+
+        v1.swap(v2);
+        REQUIRE(v1.empty());
+        REQUIRE(*v2[0] == 1);
+    }
+
+    // NOLINTNEXTLINE (cert-err58-cpp)
+    TEST_CASE("copy") {
+        static_vector<int, 4> v;
+        REQUIRE(v.assign({1, 2, 3}).is_ok());
+        REQUIRE(v.copy().ok() == v);
+    }
+}
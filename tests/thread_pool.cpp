@@ -0,0 +1,126 @@
+//
+// Copyright 2018 Marcin Radomski. All rights reserved.
+//
+// Licensed under the MIT license. See LICENSE file in the project root for
+// details.
+//
+#include <doctest.h>
+
+#include <cstddef>
+#include <cstdint>
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <nestl/arena_allocator.hpp>
+#include <nestl/result.hpp>
+#include <nestl/thread_pool.hpp>
+#include <nestl/tracking_allocator.hpp>
+
+namespace {
+
+// Sums [first, last) by splitting it in halves, one of them as a subtask.
+template <typename Pool>
+uint64_t parallel_sum(Pool& pool, uint64_t first, uint64_t last) {
+    if (last - first <= 64) {
+        uint64_t sum = 0;
+        for (uint64_t i = first; i < last; ++i) {
+            sum += i;
+        }
+        return sum;
+    }
+
+    uint64_t mid = first + (last - first) / 2;
+    auto right = pool.submit(
+        [&pool, mid, last] { return parallel_sum(pool, mid, last); });
+    uint64_t left = parallel_sum(pool, first, mid);
+    return left + right.ok().get();
+}
+
+}  // namespace
+
+TEST_SUITE("thread_pool") {
+    using nestl::thread_pool;
+
+    // NOLINTNEXTLINE (cert-err58-cpp)
+    TEST_CASE("runs submitted tasks and returns their results") {
+        thread_pool<> pool;
+        REQUIRE(pool.start(3).is_ok());
+        REQUIRE(pool.thread_count() == 3);
+
+        auto answer = pool.submit([] { return 42; });
+        REQUIRE(answer.is_ok());
+        REQUIRE(answer.ok().valid());
+        REQUIRE(answer.ok().get() == 42);
+        REQUIRE(!answer.ok().valid());
+
+        std::atomic<int> runs{0};
+        std::vector<nestl::future<void>> futures;
+        for (int i = 0; i < 1000; ++i) {
+            futures.push_back(std::move(pool.submit([&runs] { ++runs; }).ok()));
+        }
+        for (auto& f : futures) {
+            f.wait();
+            REQUIRE(f.is_ready());
+        }
+        REQUIRE(runs == 1000);
+
+        auto text = pool.submit([s = std::string(100, 'x')] { return s; });
+        REQUIRE(text.ok().get() == std::string(100, 'x'));
+    }
+
+    // NOLINTNEXTLINE (cert-err58-cpp)
+    TEST_CASE("dropping a future does not cancel the task") {
+        std::atomic<bool> ran{false};
+        {
+            thread_pool<> pool;
+            REQUIRE(pool.start(2).is_ok());
+            (void)pool.submit([&ran] {
+                ran = true;
+                return std::make_unique<int>(1);
+            });
+        }
+        REQUIRE(ran);
+    }
+
+    // NOLINTNEXTLINE (cert-err58-cpp)
+    TEST_CASE("tasks waiting for subtasks do not starve the pool") {
+        thread_pool<> pool{nestl::system_allocator{}, 16};
+        REQUIRE(pool.start(2).is_ok());
+
+        auto sum = pool.submit(
+            [&pool] { return parallel_sum(pool, 0, 100000); });
+        REQUIRE(sum.ok().get() == uint64_t{100000} * 99999 / 2);
+    }
+
+    // NOLINTNEXTLINE (cert-err58-cpp)
+    TEST_CASE("allocates tasks through the allocator") {
+        nestl::allocation_stats stats;
+        {
+            thread_pool<nestl::tracking_allocator<>> pool{
+                nestl::tracking_allocator<>{stats}};
+            REQUIRE(pool.start(2).is_ok());
+            size_t before = stats.snapshot().allocations;
+
+            for (int i = 0; i < 10; ++i) {
+                REQUIRE(pool.submit([i] { return i; }).ok().get() == i);
+            }
+            REQUIRE(stats.snapshot().allocations == before + 10);
+        }
+        auto s = stats.snapshot();
+        REQUIRE(s.live_bytes == 0);
+    }
+
+    // NOLINTNEXTLINE (cert-err58-cpp)
+    TEST_CASE("reports allocation failure") {
+        alignas(std::max_align_t) unsigned char buffer[256];
+        nestl::arena<> arena{buffer, sizeof(buffer)};
+        thread_pool<nestl::arena_allocator<>> pool{
+            nestl::arena_allocator<>{arena}, 1024};
+        REQUIRE(pool.start(4).is_err());
+        REQUIRE(pool.thread_count() == 0);
+    }
+}
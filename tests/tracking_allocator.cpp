@@ -0,0 +1,207 @@
+//
+// Copyright 2018 Marcin Radomski. All rights reserved.
+//
+// Licensed under the MIT license. See LICENSE file in the project root for
+// details.
+//
+#include <doctest.h>
+
+#include <cstddef>
+#include <cstdint>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <nestl/arena_allocator.hpp>
+#include <nestl/result.hpp>
+#include <nestl/tracking_allocator.hpp>
+#include <nestl/vector.hpp>
+
+namespace {
+
+std::atomic<size_t> moves_seen{0};
+
+void count_move(size_t, size_t) { ++moves_seen; }
+
+// Rounds requests up to a whole number of granules, like malloc does, and
+// reports the rounded size, unlike malloc whose slack depends on the heap.
+class rounding_allocator {
+    static constexpr size_t granule = alignof(std::max_align_t);
+
+    struct alignas(std::max_align_t) header {
+        size_t size;
+    };
+
+    nestl::system_allocator m_alloc;
+
+    static size_t round_up(size_t size) noexcept {
+        return (size + granule - 1) / granule * granule;
+    }
+
+    static void* init(void* p, size_t size) noexcept {
+        auto* h = static_cast<header*>(p);
+        h->size = size;
+        return h + 1;
+    }
+
+public:
+    nestl::result<void*, nestl::out_of_memory> allocate(size_t size) noexcept {
+        size = round_up(size);
+        auto res = m_alloc.allocate(sizeof(header) + size);
+        if (!res) {
+            return res;
+        }
+        return {init(res.ok(), size)};
+    }
+
+    nestl::result<void*, nestl::out_of_memory> reallocate(
+        void* p, size_t new_size) noexcept {
+        if (!p) {
+            return allocate(new_size);
+        }
+
+        new_size = round_up(new_size);
+        auto res = m_alloc.reallocate(static_cast<header*>(p) - 1,
+                                      sizeof(header) + new_size);
+        if (!res) {
+            return res;
+        }
+        return {init(res.ok(), new_size)};
+    }
+
+    void free(void* p) noexcept {
+        if (p) {
+            m_alloc.free(static_cast<header*>(p) - 1);
+        }
+    }
+
+    size_t usable_size(void* p) const noexcept {
+        return (static_cast<header*>(p) - 1)->size;
+    }
+};
+
+}  // namespace
+
+TEST_SUITE("tracking_allocator") {
+    using nestl::allocation_stats;
+    using nestl::tracking_allocator;
+
+    // NOLINTNEXTLINE (cert-err58-cpp)
+    TEST_CASE("counts calls and live bytes") {
+        allocation_stats stats;
+        tracking_allocator<> alloc{stats};
+
+        void* a = alloc.allocate(100).ok();
+        void* b = alloc.allocate(3).ok();
+        auto s = stats.snapshot();
+        REQUIRE(s.allocations == 2);
+        REQUIRE(s.live_bytes == 103);
+        REQUIRE(s.peak_live_bytes == 103);
+        REQUIRE(s.histogram[6] == 1);
+        REQUIRE(s.histogram[1] == 1);
+
+        a = alloc.reallocate(a, 1000).ok();
+        s = stats.snapshot();
+        REQUIRE(s.reallocations == 1);
+        REQUIRE(s.live_bytes == 1003);
+        REQUIRE(s.histogram[9] == 1);
+
+        a = alloc.reallocate(a, 10).ok();
+        alloc.free(b);
+        s = stats.snapshot();
+        REQUIRE(s.frees == 1);
+        REQUIRE(s.live_bytes == 10);
+        REQUIRE(s.peak_live_bytes == 1003);
+
+        alloc.free(a);
+        alloc.free(nullptr);
+        s = stats.snapshot();
+        REQUIRE(s.frees == 2);
+        REQUIRE(s.live_bytes == 0);
+    }
+
+    // NOLINTNEXTLINE (cert-err58-cpp)
+    TEST_CASE("records reallocations that moved the block") {
+        alignas(std::max_align_t) unsigned char buffer[1024];
+        nestl::arena<> arena{buffer, sizeof(buffer)};
+
+        allocation_stats stats;
+        stats.set_move_hook(&count_move);
+        moves_seen = 0;
+        tracking_allocator<nestl::arena_allocator<>> alloc{
+            stats, nestl::arena_allocator<>{arena}};
+
+        // the arena grows its most recent block in place
+        void* a = alloc.allocate(16).ok();
+        a = alloc.reallocate(a, 32).ok();
+        REQUIRE(stats.snapshot().moved_reallocations == 0);
+
+        void* b = alloc.allocate(16).ok();
+        a = alloc.reallocate(a, 64).ok();
+        REQUIRE(stats.snapshot().moved_reallocations == 1);
+        REQUIRE(moves_seen == 1);
+
+        REQUIRE(alloc.allocate(4096).is_err());
+        REQUIRE(stats.snapshot().failures == 1);
+
+        alloc.free(a);
+        alloc.free(b);
+    }
+
+    // NOLINTNEXTLINE (cert-err58-cpp)
+    TEST_CASE("tracks vectors in many threads") {
+        allocation_stats stats;
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; ++t) {
+            threads.emplace_back([&stats] {
+                for (int round = 0; round < 100; ++round) {
+                    nestl::vector<int, tracking_allocator<>> v{
+                        tracking_allocator<>{stats}};
+                    for (int i = 0; i < 20; ++i) {
+                        (void)v.push_back(i);
+                    }
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+
+        auto s = stats.snapshot();
+        REQUIRE(s.live_bytes == 0);
+        REQUIRE(s.frees == 400);
+        // first push_back allocates through reallocate(nullptr, ...)
+        REQUIRE(s.allocations == 400);
+        // capacity 10 -> 15 -> 22
+        REQUIRE(s.reallocations == 800);
+    }
+
+    // NOLINTNEXTLINE (cert-err58-cpp)
+    TEST_CASE("does not change vector capacities") {
+        using tracking = tracking_allocator<rounding_allocator>;
+        static_assert(nestl::has_usable_size<tracking>);
+        static_assert(nestl::has_usable_size<tracking_allocator<>>
+                      == nestl::has_usable_size<nestl::system_allocator>);
+        static_assert(
+            !nestl::has_usable_size<
+                tracking_allocator<nestl::arena_allocator<>>>);
+
+        allocation_stats stats;
+        nestl::vector<uint8_t, rounding_allocator> plain;
+        nestl::vector<uint8_t, tracking> tracked{tracking{stats}};
+        for (uint8_t i = 0; i < 200; ++i) {
+            REQUIRE(plain.push_back(i).is_ok());
+            REQUIRE(tracked.push_back(i).is_ok());
+            REQUIRE(plain.capacity() == tracked.capacity());
+        }
+    }
+
+    // NOLINTNEXTLINE (cert-err58-cpp)
+    TEST_CASE("default-constructed allocator records nothing") {
+        tracking_allocator<> alloc;
+        REQUIRE(alloc.stats() == nullptr);
+        void* p = alloc.allocate(8).ok();
+        alloc.free(p);
+    }
+}
@@ -7,6 +7,7 @@
 #include <doctest.h>
 
 #include <functional>
+#include <memory>
 #include <type_traits>
 #include <utility>
 
@@ -25,6 +26,9 @@ TEST_SUITE("variant") {
         auto v1 = variant<int, const char*, Movable>{1};
         auto v2 = variant<int, const char*, Movable>{"foo"};
         auto v3 = variant<int, const char*, Movable>{Movable{}};
+        REQUIRE(v1.is<int>());
+        REQUIRE(v2.is<const char*>());
+        REQUIRE(v3.is<Movable>());
     }
 
     // NOLINTNEXTLINE (cert-err58-cpp)
@@ -50,6 +54,7 @@ TEST_SUITE("variant") {
             Foo(int _a, double _b) : a(_a), b(_b) {}
         };
         auto v = variant<Foo, int>::emplace<Foo>(1, 2.0);
+        REQUIRE(v.get<Foo>().ok().get().a == 1);
     }
 
     // NOLINTNEXTLINE (cert-err58-cpp)
@@ -57,6 +62,9 @@ TEST_SUITE("variant") {
         auto v1 = variant<int>{1};
         auto v2 = variant<int, const char*>{1};
         auto v3 = variant<int, const char*, Test>{1};
+        REQUIRE(v1.is<int>());
+        REQUIRE(v2.is<int>());
+        REQUIRE(v3.is<int>());
     }
 
     // NOLINTNEXTLINE (cert-err58-cpp)
@@ -100,11 +108,168 @@ TEST_SUITE("variant") {
     TEST_CASE("can be safely moved-from") {
         auto a = variant<Movable, Mock>{Movable{}};
         auto b = std::move(a).get<Movable>();
+        REQUIRE(b.is_ok());
     }
 
     // NOLINTNEXTLINE (cert-err58-cpp)
     TEST_CASE("can be safely copied-from") {
         auto a = variant<Movable, Mock>{Movable{}};
         auto b = a.get<Movable>();
+        REQUIRE(b.is_ok());
+    }
+
+    // NOLINTNEXTLINE (cert-err58-cpp)
+    TEST_CASE("moves, copies and destroys the held alternative") {
+        using V = variant<int, double, std::shared_ptr<int>, const char*>;
+        auto p = std::make_shared<int>(1);
+        {
+            auto v1 = V{p};
+            REQUIRE(p.use_count() == 2);
+
+            auto v2 = v1;
+            REQUIRE(p.use_count() == 3);
+
+            auto v3 = std::move(v1);
+            REQUIRE(p.use_count() == 3);
+            REQUIRE(v3.get<std::shared_ptr<int>>().ok().get() == p);
+
+            v2 = V{1.0};
+            REQUIRE(p.use_count() == 2);
+            REQUIRE(v2.get<double>().ok() == 1.0);
+        }
+        REQUIRE(p.use_count() == 1);
+    }
+
+    // NOLINTNEXTLINE (cert-err58-cpp)
+    TEST_CASE("index") {
+        auto v = variant<int, const char*, Test>{Test{}};
+        REQUIRE(v.index() == 2);
+
+        // trivially copyable variants are copied on move
+        auto moved = std::move(v);
+        REQUIRE(moved.index() == 2);
+        REQUIRE(v.index() == 2);
+    }
+
+    // NOLINTNEXTLINE (cert-err58-cpp)
+    TEST_CASE("moved-from variant without trivial moves has no value") {
+        auto v = variant<int, std::shared_ptr<int>>{std::make_shared<int>(1)};
+        auto moved = std::move(v);
+        REQUIRE(moved.index() == 1);
+        REQUIRE(v.index() == nestl::invalid_type_index);
+    }
+
+    static_assert(std::is_trivially_copyable_v<variant<int, float>>);
+    static_assert(std::is_trivially_destructible_v<variant<int, float>>);
+    static_assert(std::is_trivially_copyable_v<variant<int, Movable>>);
+    static_assert(
+        !std::is_trivially_copyable_v<variant<int, std::shared_ptr<int>>>);
+    static_assert(
+        !std::is_trivially_destructible_v<variant<int, std::shared_ptr<int>>>);
+
+    // NOLINTNEXTLINE (cert-err58-cpp)
+    TEST_CASE("visit calls the visitor with the held value") {
+        struct Visitor {
+            int operator()(int i) const noexcept { return i; }
+            int operator()(const char*) const noexcept { return -1; }
+            int operator()(Test) const noexcept { return -2; }
+        };
+
+        auto v = variant<int, const char*, Test>{42};
+        REQUIRE(nestl::visit(Visitor{}, v) == 42);
+        v = variant<int, const char*, Test>{"foo"};
+        REQUIRE(nestl::visit(Visitor{}, v) == -1);
+        v = variant<int, const char*, Test>{Test{}};
+        REQUIRE(nestl::visit(Visitor{}, v) == -2);
+
+        auto throwing = [](auto) { return 0; };
+        static_assert(noexcept(nestl::visit(Visitor{}, v)));
+        static_assert(!noexcept(nestl::visit(throwing, v)));
+    }
+
+    // NOLINTNEXTLINE (cert-err58-cpp)
+    TEST_CASE("visit forwards value category") {
+        auto v = variant<int, double>{1};
+        nestl::visit([](auto& value) { value *= 2; }, v);
+        REQUIRE(v.get<int>().ok() == 2);
+
+        const auto& cv = v;
+        nestl::visit(
+            [](auto& value) {
+                static_assert(
+                    std::is_const_v<std::remove_reference_t<decltype(value)>>);
+            },
+            cv);
+
+        auto m = variant<Movable, int>{Movable{}};
+        nestl::visit(
+            [](auto&& value) {
+                static_assert(std::is_rvalue_reference_v<decltype(value)>);
+                auto moved = std::move(value);
+                (void)moved;
+            },
+            std::move(m));
+    }
+
+    // NOLINTNEXTLINE (cert-err58-cpp)
+    TEST_CASE("visit supports multiple variants") {
+        auto a = variant<int, double, const char*>{2.5};
+        auto b = variant<int, long>{3L};
+        auto c = variant<int, char>{'x'};
+
+        auto sum = [](auto x, auto y, auto z) -> size_t {
+            return sizeof(x) * 100 + sizeof(y) * 10 + sizeof(z);
+        };
+        REQUIRE(nestl::visit(sum, a, b, c)
+                == sizeof(double) * 100 + sizeof(long) * 10 + sizeof(char));
+
+        a = variant<int, double, const char*>{1};
+        b = variant<int, long>{1};
+        c = variant<int, char>{1};
+        REQUIRE(nestl::visit(sum, a, b, c)
+                == sizeof(int) * 100 + sizeof(int) * 10 + sizeof(int));
+    }
+
+    // NOLINTNEXTLINE (cert-err58-cpp)
+    TEST_CASE("keeps the index in unused tail bytes of the storage") {
+        struct Name {
+            char chars[6];
+        };
+        using Node = variant<Name, int32_t>;
+
+        static_assert(sizeof(Node) == 2 * sizeof(int32_t));
+        static_assert(sizeof(variant<int32_t, float>)
+                      == 2 * sizeof(int32_t));
+
+        auto name = Node{Name{{'a', 'b', 'c', 'd', 'e', 'f'}}};
+        REQUIRE(name.index() == 0);
+        REQUIRE(name.get<Name>().ok().get().chars[5] == 'f');
+
+        auto number = Node{42};
+        REQUIRE(number.index() == 1);
+
+        number = name;
+        REQUIRE(number.index() == 0);
+        REQUIRE(number.get<Name>().ok().get().chars[5] == 'f');
+
+        // assigning the held value in place leaves the index alone
+        number.get<Name>().ok().get() = Name{{'g', 'h', 'i', 'j', 'k', 'l'}};
+        REQUIRE(number.index() == 0);
+        REQUIRE(number.get<Name>().ok().get().chars[5] == 'l');
+
+        name = Node{7};
+        REQUIRE(name.index() == 1);
+        REQUIRE(name.get<int32_t>().ok() == 7);
+
+        struct LongName {
+            char chars[9];
+        };
+        using Owning = variant<std::unique_ptr<int>, LongName>;
+        static_assert(sizeof(Owning) == 2 * sizeof(void*));
+
+        auto owning = Owning{std::make_unique<int>(3)};
+        auto moved = std::move(owning);
+        REQUIRE(owning.index() == nestl::invalid_type_index);
+        REQUIRE(*moved.get<std::unique_ptr<int>>().ok().get() == 3);
     }
 }
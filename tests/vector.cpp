@@ -6,11 +6,20 @@
 //
 #include <doctest.h>
 
+#include <cstddef>
+#include <cstdint>
+
+#include <algorithm>
 #include <functional>
 #include <initializer_list>
 #include <iostream>
+#include <list>
+#include <string>
+#include <type_traits>
 #include <utility>
+#include <vector>
 
+#include <nestl/arena_allocator.hpp>
 #include <nestl/result.hpp>
 #include <nestl/vector.hpp>
 
@@ -23,10 +32,98 @@ struct V : public nestl::vector<T> {
     }
 };
 
+// Not trivially relocatable: remembers its own address.
+struct SelfRef {
+    static int live;
+
+    const SelfRef* self;
+    int value;
+
+    SelfRef(int v) : self(this), value(v) { ++live; }
+    SelfRef(SelfRef&& src) : self(this), value(src.value) {
+        REQUIRE(src.self == &src);
+        ++live;
+    }
+    SelfRef& operator=(SelfRef&& src) {
+        REQUIRE(self == this);
+        REQUIRE(src.self == &src);
+        value = src.value;
+        return *this;
+    }
+    ~SelfRef() {
+        REQUIRE(self == this);
+        --live;
+    }
+
+    SelfRef(const SelfRef&) = delete;
+    SelfRef& operator=(const SelfRef&) = delete;
+};
+
+int SelfRef::live = 0;
+
+// Non-trivial, but opted into relocation by memmove.
+struct Relocatable {
+    int value;
+
+    Relocatable(int v) : value(v) {}
+    Relocatable(Relocatable&&) { FAIL("unexpected move ctor call"); }
+    Relocatable& operator=(Relocatable&&) {
+        FAIL("unexpected move-assign call");
+        return *this;
+    }
+    ~Relocatable() {}
+};
+
+// Reports no usable size, so capacity is exactly what vector asked for.
+class plain_allocator {
+    nestl::system_allocator m_alloc;
+
+public:
+    nestl::result<void*, nestl::out_of_memory> allocate(size_t size) noexcept {
+        return m_alloc.allocate(size);
+    }
+
+    nestl::result<void*, nestl::out_of_memory> reallocate(
+        void* p, size_t new_size) noexcept {
+        return m_alloc.reallocate(p, new_size);
+    }
+
+    void free(void* p) noexcept { m_alloc.free(p); }
+};
+
+// Hands out 64-byte blocks for any request up to 64 bytes.
+class slack_allocator : public plain_allocator {
+public:
+    static constexpr size_t block_size = 64;
+
+    nestl::result<void*, nestl::out_of_memory> allocate(size_t size) noexcept {
+        REQUIRE(size <= block_size);
+        return plain_allocator::allocate(block_size);
+    }
+
+    nestl::result<void*, nestl::out_of_memory> reallocate(
+        void* p, size_t new_size) noexcept {
+        REQUIRE(new_size <= block_size);
+        return plain_allocator::reallocate(p, block_size);
+    }
+
+    size_t usable_size(void*) const noexcept { return block_size; }
+};
+
+template <typename T>
+bool has_values(const nestl::vector<T>& v, std::initializer_list<int> values) {
+    return v.size() == values.size()
+           && std::equal(v.begin(), v.end(), values.begin(),
+                         [](const T& e, int val) { return e.value == val; });
+}
+
 }  // namespace
 
 namespace nestl {
 
+template <>
+struct is_trivially_relocatable<Relocatable> : std::true_type {};
+
 template <typename T>
 // NOLINTNEXTLINE (fuchsia-overloaded-operator)
 std::ostream& operator<<(std::ostream& os, const nestl::vector<T>& v) {
@@ -183,6 +280,53 @@ TEST_SUITE("vector") {
         }
     }
 
+    // NOLINTNEXTLINE (cert-err58-cpp)
+    TEST_CASE("unordered_erase") {
+        vector<int> v;
+        v.assign({1, 2, 3, 4});
+        auto it = v.unordered_erase(v.begin() + 1);
+        REQUIRE(it == v.begin() + 1);
+        REQUIRE(v == V{1, 4, 3});
+
+        it = v.unordered_erase(v.end() - 1);
+        REQUIRE(it == v.end());
+        REQUIRE(v == V{1, 4});
+    }
+
+    // NOLINTNEXTLINE (cert-err58-cpp)
+    TEST_CASE("erase_if") {
+        SUBCASE("keeps order of the rest") {
+            vector<int> v;
+            v.assign({1, 2, 3, 4, 5, 6, 7});
+            auto odd = [](int e) { return e % 2 != 0; };
+            REQUIRE(nestl::erase_if(v, odd) == 4);
+            REQUIRE(v == V{2, 4, 6});
+            REQUIRE(nestl::erase_if(v, odd) == 0);
+            REQUIRE(v == V{2, 4, 6});
+        }
+
+        SUBCASE("retain") {
+            vector<int> v;
+            v.assign({1, 2, 3, 4, 5});
+            REQUIRE(v.retain([](int e) { return e > 3; }) == 3);
+            REQUIRE(v == V{4, 5});
+            REQUIRE(v.retain([](int) { return false; }) == 2);
+            REQUIRE(v.empty());
+        }
+
+        SUBCASE("calls the predicate once per element") {
+            vector<int> v;
+            v.assign({1, 2, 3, 4, 5});
+            size_t calls = 0;
+            v.erase_if([&calls](int e) {
+                ++calls;
+                return e == 2 || e == 3;
+            });
+            REQUIRE(calls == 5);
+            REQUIRE(v == V{1, 4, 5});
+        }
+    }
+
     // NOLINTNEXTLINE (cert-err58-cpp)
     TEST_CASE("emplace") {
         SUBCASE("at begin") {
@@ -285,6 +429,78 @@ TEST_SUITE("vector") {
         REQUIRE(v == V{});
     }
 
+    // NOLINTNEXTLINE (cert-err58-cpp)
+    TEST_CASE("copy") {
+        SUBCASE("keeps the allocator") {
+            alignas(std::max_align_t) unsigned char buffer[256];
+            nestl::arena<> arena{buffer, sizeof(buffer)};
+            vector<int, nestl::arena_allocator<>> v{
+                nestl::arena_allocator<>{arena}};
+            REQUIRE(v.assign({1, 2, 3}).is_ok());
+
+            const auto& cv = v;
+            auto copy = cv.copy();
+            REQUIRE(copy.is_ok());
+            REQUIRE(copy.ok() == v);
+            REQUIRE(copy.ok().get_allocator() == v.get_allocator());
+            REQUIRE(copy.ok().capacity() == 3);
+
+            auto other = cv.copy(nestl::arena_allocator<>{});
+            REQUIRE(other.is_err());
+        }
+
+        SUBCASE("non-trivial type") {
+            {
+                vector<std::string> v;
+                REQUIRE(v.assign({"a", "b"}).is_ok());
+                auto copy = v.copy();
+                REQUIRE(copy.is_ok());
+                REQUIRE(copy.ok() == v);
+                copy.ok()[0] = "c";
+                REQUIRE(v[0] == "a");
+            }
+        }
+
+        SUBCASE("empty") {
+            vector<int> v;
+            auto copy = v.copy();
+            REQUIRE(copy.is_ok());
+            REQUIRE(copy.ok().empty());
+        }
+    }
+
+    // NOLINTNEXTLINE (cert-err58-cpp)
+    TEST_CASE("copy_into") {
+        vector<std::string> src;
+        REQUIRE(src.assign({"a", "b"}).is_ok());
+
+        vector<std::string> dst;
+        REQUIRE(dst.assign({"x", "y", "z"}).is_ok());
+        const std::string* buffer = dst.data();
+
+        REQUIRE(src.copy_into(dst).is_ok());
+        REQUIRE(dst == src);
+        REQUIRE(dst.data() == buffer);
+
+        REQUIRE(src.push_back("c").is_ok());
+        REQUIRE(src.push_back("d").is_ok());
+        REQUIRE(src.copy_into(dst).is_ok());
+        REQUIRE(dst == src);
+
+        REQUIRE(src.copy_into(src).is_ok());
+        REQUIRE(src.size() == 4);
+
+        alignas(std::max_align_t) unsigned char storage[64];
+        nestl::arena<> arena{storage, sizeof(storage)};
+        vector<int, nestl::arena_allocator<>> small{
+            nestl::arena_allocator<>{arena}};
+        REQUIRE(small.push_back(1).is_ok());
+        vector<int, nestl::arena_allocator<>> big;
+        REQUIRE(big.get_allocator() != small.get_allocator());
+        REQUIRE(big.copy_into(small).is_ok());
+        REQUIRE(small.empty());
+    }
+
     // NOLINTNEXTLINE (cert-err58-cpp)
     TEST_CASE("resize") {
         SUBCASE("same size") {
@@ -309,6 +525,163 @@ TEST_SUITE("vector") {
         }
     }
 
+    // NOLINTNEXTLINE (cert-err58-cpp)
+    TEST_CASE("resize_default_init") {
+        vector<int> v;
+        v.assign({1, 2});
+        REQUIRE(v.resize_default_init(4).is_ok());
+        REQUIRE(v.size() == 4);
+        REQUIRE(v[0] == 1);
+        REQUIRE(v[1] == 2);
+
+        REQUIRE(v.resize_default_init(1).is_ok());
+        REQUIRE(v == V{1});
+
+        vector<std::string> strings;
+        REQUIRE(strings.resize_default_init(2).is_ok());
+        REQUIRE(strings.size() == 2);
+        REQUIRE(strings[1].empty());
+    }
+
+    // NOLINTNEXTLINE (cert-err58-cpp)
+    TEST_CASE("append_range") {
+        SUBCASE("contiguous trivially copyable range") {
+            vector<int> v;
+            v.assign({1});
+            const int values[] = {2, 3, 4};
+            auto res = v.append_range(std::begin(values), std::end(values));
+            REQUIRE(res.is_ok());
+            REQUIRE(res.ok() == v.begin() + 1);
+            REQUIRE(v == V{1, 2, 3, 4});
+
+            REQUIRE(v.append_range(values, values).is_ok());
+            REQUIRE(v == V{1, 2, 3, 4});
+        }
+
+        SUBCASE("forward iterators") {
+            std::list<int> values{2, 3};
+            vector<int> v;
+            v.assign({1});
+            REQUIRE(v.append_range(values.begin(), values.end()).is_ok());
+            REQUIRE(v == V{1, 2, 3});
+        }
+
+        SUBCASE("non-trivial type") {
+            const int values[] = {1, 2, 3};
+            {
+                vector<SelfRef> v;
+                REQUIRE(v.emplace_back(0).is_ok());
+                REQUIRE(v.append_range(std::begin(values), std::end(values))
+                            .is_ok());
+                REQUIRE(has_values(v, {0, 1, 2, 3}));
+            }
+            REQUIRE(SelfRef::live == 0);
+        }
+
+        SUBCASE("out of memory") {
+            alignas(std::max_align_t) unsigned char buffer[64];
+            nestl::arena<> arena{buffer, sizeof(buffer)};
+            vector<int, nestl::arena_allocator<>> v{
+                nestl::arena_allocator<>{arena}};
+            REQUIRE(v.push_back(1).is_ok());
+
+            const int values[100] = {};
+            REQUIRE(v.append_range(std::begin(values), std::end(values))
+                        .is_err());
+            REQUIRE(v.size() == 1);
+            REQUIRE(v[0] == 1);
+        }
+    }
+
+    // NOLINTNEXTLINE (cert-err58-cpp)
+    TEST_CASE("append_n_uninitialized") {
+        vector<char> v;
+        REQUIRE(v.push_back('a').is_ok());
+
+        auto res = v.append_n_uninitialized(3);
+        REQUIRE(res.is_ok());
+        REQUIRE(res.ok() == v.begin() + 1);
+        REQUIRE(v.size() == 4);
+        std::fill(res.ok(), v.end(), 'b');
+        REQUIRE(std::string(v.begin(), v.end()) == "abbb");
+
+        REQUIRE(v.append_n_uninitialized(0).ok() == v.end());
+        REQUIRE(v.size() == 4);
+    }
+
+    // NOLINTNEXTLINE (cert-err58-cpp)
+    TEST_CASE("growth policies") {
+        using nestl::exact_growth;
+        using nestl::geometric_growth;
+        using nestl::page_growth;
+
+        REQUIRE(geometric_growth<>::next_capacity(0, 1, 4) == 10);
+        REQUIRE(geometric_growth<>::next_capacity(10, 11, 4) == 15);
+        REQUIRE(geometric_growth<>::next_capacity(10, 100, 4) == 100);
+        REQUIRE(geometric_growth<2, 1, 1>::next_capacity(0, 1, 4) == 1);
+        REQUIRE(geometric_growth<2, 1, 1>::next_capacity(4, 5, 4) == 8);
+
+        // small capacities still grow, rounding up
+        REQUIRE(geometric_growth<3, 2, 1>::next_capacity(1, 2, 4) == 2);
+        REQUIRE(geometric_growth<3, 2, 1>::next_capacity(2, 3, 4) == 3);
+        REQUIRE(geometric_growth<3, 2, 1>::next_capacity(3, 4, 4) == 5);
+        REQUIRE(geometric_growth<5, 4, 2>::next_capacity(2, 3, 4) == 3);
+        REQUIRE(geometric_growth<5, 4, 2>::next_capacity(4, 5, 4) == 5);
+        REQUIRE(geometric_growth<5, 4, 2>::next_capacity(5, 6, 4) == 7);
+
+        // saturates instead of overflowing
+        REQUIRE(geometric_growth<>::next_capacity(SIZE_MAX / 4, 1, 8)
+                == SIZE_MAX / 8);
+        REQUIRE(geometric_growth<>::next_capacity(SIZE_MAX / 4 * 3, 1, 1)
+                == SIZE_MAX);
+        REQUIRE(geometric_growth<>::next_capacity(10, SIZE_MAX, 8)
+                == SIZE_MAX);
+        REQUIRE(page_growth<>::next_capacity(SIZE_MAX / 8 - 1, 1, 8)
+                == SIZE_MAX / 8);
+
+        REQUIRE(page_growth<>::next_capacity(10, 11, 4) == 15);
+        // 1500 * 4 bytes, rounded up to 2 pages
+        REQUIRE(page_growth<>::next_capacity(1000, 1001, 4) == 2048);
+
+        REQUIRE(exact_growth::next_capacity(10, 11, 4) == 11);
+    }
+
+    // NOLINTNEXTLINE (cert-err58-cpp)
+    TEST_CASE("grows by the policy on insertion, exactly on reserve") {
+        vector<int, plain_allocator> geometric;
+        REQUIRE(geometric.push_back(1).is_ok());
+        REQUIRE(geometric.capacity() == 10);
+        for (int i = 0; i < 10; ++i) {
+            REQUIRE(geometric.push_back(i).is_ok());
+        }
+        REQUIRE(geometric.capacity() == 15);
+        REQUIRE(geometric.reserve(16).is_ok());
+        REQUIRE(geometric.capacity() == 16);
+
+        vector<int, plain_allocator, nestl::exact_growth> exact;
+        REQUIRE(exact.push_back(1).is_ok());
+        REQUIRE(exact.push_back(2).is_ok());
+        REQUIRE(exact.capacity() == 2);
+        REQUIRE(exact.resize(5).is_ok());
+        REQUIRE(exact.capacity() == 5);
+    }
+
+    // NOLINTNEXTLINE (cert-err58-cpp)
+    TEST_CASE("uses slack reported by the allocator") {
+        static_assert(nestl::has_usable_size<slack_allocator>);
+        static_assert(!nestl::has_usable_size<plain_allocator>);
+
+        vector<int, slack_allocator, nestl::exact_growth> v;
+        REQUIRE(v.push_back(1).is_ok());
+        REQUIRE(v.capacity() == slack_allocator::block_size / sizeof(int));
+
+        for (int i = 2; i <= 16; ++i) {
+            REQUIRE(v.push_back(i).is_ok());
+        }
+        REQUIRE(v.size() == 16);
+        REQUIRE(v.back() == 16);
+    }
+
     // NOLINTNEXTLINE (cert-err58-cpp)
     TEST_CASE("swap") {
         vector<int> v1;
@@ -323,6 +696,126 @@ TEST_SUITE("vector") {
         REQUIRE(v2 == V{1, 2});
     }
 
+    // NOLINTNEXTLINE (cert-err58-cpp)
+    TEST_CASE("comparison") {
+        SUBCASE("prefix orders first, either way round") {
+            REQUIRE(V{1, 2} < V{1, 2, 3});
+            REQUIRE(V{1, 2, 3} > V{1, 2});
+            REQUIRE(V{1, 2} != V{1, 2, 3});
+            REQUIRE(V<int>{} < V{0});
+            REQUIRE(V<int>{} == V<int>{});
+            REQUIRE(V{-1, 5} < V{1});
+            REQUIRE(V{1, 2} <= V{1, 2});
+            REQUIRE(V{1, 2} >= V{1, 2});
+        }
+
+        SUBCASE("matches std::vector at every length and position") {
+            auto check = [](auto zero) {
+                using T = decltype(zero);
+                for (size_t size = 0; size < 80; ++size) {
+                    for (size_t pos = 0; pos <= size; ++pos) {
+                        vector<T> a;
+                        REQUIRE(a.resize(size).is_ok());
+                        auto b = a.copy().ok();
+                        std::vector<T> sa(size);
+                        std::vector<T> sb(size);
+                        if (pos < size) {
+                            // differs in the top byte only
+                            b[pos] = static_cast<T>(T{1} << (sizeof(T) * 8
+                                                             - 2));
+                            sb[pos] = b[pos];
+                        }
+                        REQUIRE((a == b) == (sa == sb));
+                        REQUIRE((a < b) == (sa < sb));
+                        REQUIRE((b < a) == (sb < sa));
+                        if (pos < size) {
+                            REQUIRE(b.find(b[pos]) == b.begin() + pos);
+                        }
+                    }
+                }
+            };
+            check(uint8_t{});
+            check(uint16_t{});
+            check(uint32_t{});
+            check(int64_t{});
+        }
+
+        SUBCASE("bytes order unsigned") {
+            vector<unsigned char> a;
+            a.assign({1, 0x80});
+            vector<unsigned char> b;
+            b.assign({1, 0x7f});
+            REQUIRE(b < a);
+            REQUIRE(!(a < b));
+        }
+
+        SUBCASE("non-trivial type") {
+            vector<std::string> a;
+            a.assign({"a", "b"});
+            vector<std::string> b;
+            b.assign({"a", "b", "c"});
+            REQUIRE(a < b);
+            REQUIRE(a != b);
+            b.pop_back();
+            REQUIRE(a == b);
+        }
+    }
+
+    // NOLINTNEXTLINE (cert-err58-cpp)
+    TEST_CASE("find and count") {
+        vector<uint32_t> v;
+        for (uint32_t i = 0; i < 100; ++i) {
+            REQUIRE(v.push_back(i % 7).is_ok());
+        }
+        REQUIRE(v.find(0) == v.begin());
+        REQUIRE(v.find(6) == v.begin() + 6);
+        REQUIRE(v.find(7) == v.end());
+        REQUIRE(v.count(2) == 14);
+        REQUIRE(v.count(3) == 14);
+        REQUIRE(v.count(99) == 0);
+
+        // a match in the low half of an 8-byte element is no match
+        vector<uint64_t> w;
+        REQUIRE(w.resize(40).is_ok());
+        w[37] = 5;
+        REQUIRE(w.find(uint64_t{5} << 32) == w.end());
+        REQUIRE(w.find(5) == w.begin() + 37);
+        REQUIRE(w.count(0) == 39);
+
+        vector<std::string> s;
+        s.assign({"a", "b", "a"});
+        REQUIRE(s.find("b") == s.begin() + 1);
+        REQUIRE(s.count("a") == 2);
+
+        vector<int> empty;
+        REQUIRE(empty.find(1) == empty.end());
+        REQUIRE(empty.count(1) == 0);
+
+        SUBCASE("every kernel agrees with std") {
+            auto check = [](auto kernel) {
+                vector<uint16_t> data;
+                for (uint16_t i = 0; i < 300; ++i) {
+                    REQUIRE(data.push_back(i % 37 == 0 ? 0x100 : i).is_ok());
+                }
+                for (uint16_t value : {0x100, 0x1, 0x0, 299}) {
+                    auto expected = std::count(data.begin(), data.end(),
+                                               value);
+                    REQUIRE(kernel(data, value)
+                            == static_cast<size_t>(expected));
+                }
+            };
+            using nestl::detail::count_with;
+            using nestl::detail::native_block;
+            using nestl::detail::swar_block;
+            check([](const vector<uint16_t>& d, uint16_t value) {
+                return count_with<swar_block>(d.data(), d.size(), value);
+            });
+            check([](const vector<uint16_t>& d, uint16_t value) {
+                return count_with<native_block>(d.data(), d.size(), value);
+            });
+        }
+    }
+
     TEST_CASE("2d vector") {
         // just make sure this compiles
         vector<vector<int>> vvi;
@@ -397,4 +890,79 @@ TEST_SUITE("vector") {
             REQUIRE(it == v.crend());
         }
     }
+
+    TEST_CASE("relocation") {
+        SUBCASE("non-trivially relocatable type survives growth") {
+            {
+                vector<SelfRef> v;
+                for (int i = 0; i < 100; ++i) {
+                    REQUIRE(v.emplace_back(i).is_ok());
+                }
+                REQUIRE(SelfRef::live == 100);
+                for (size_t i = 0; i < v.size(); ++i) {
+                    REQUIRE(v[i].self == &v[i]);
+                    REQUIRE(v[i].value == static_cast<int>(i));
+                }
+            }
+            REQUIRE(SelfRef::live == 0);
+        }
+
+        SUBCASE("non-trivially relocatable type: insert and erase") {
+            {
+                vector<SelfRef> v;
+                REQUIRE(v.emplace_back(1).is_ok());
+                REQUIRE(v.emplace_back(4).is_ok());
+                REQUIRE(v.emplace(v.begin() + 1, 3).is_ok());
+                REQUIRE(v.emplace(v.begin() + 1, 2).is_ok());
+                REQUIRE(v.emplace(v.begin(), 0).is_ok());
+                REQUIRE(has_values(v, {0, 1, 2, 3, 4}));
+
+                v.erase(v.begin() + 1, v.begin() + 3);
+                REQUIRE(has_values(v, {0, 3, 4}));
+                REQUIRE(SelfRef::live == 3);
+
+                v.erase(v.begin());
+                REQUIRE(has_values(v, {3, 4}));
+
+                v.shrink_to_fit();
+                REQUIRE(v.capacity() == 2);
+                REQUIRE(has_values(v, {3, 4}));
+                REQUIRE(SelfRef::live == 2);
+            }
+            REQUIRE(SelfRef::live == 0);
+        }
+
+        SUBCASE("non-trivially relocatable type: erase_if") {
+            {
+                vector<SelfRef> v;
+                for (int i = 0; i < 10; ++i) {
+                    REQUIRE(v.emplace_back(i).is_ok());
+                }
+                REQUIRE(v.erase_if([](const SelfRef& e) {
+                    return e.value < 2 || e.value % 3 == 0;
+                }) == 5);
+                REQUIRE(has_values(v, {2, 4, 5, 7, 8}));
+                REQUIRE(SelfRef::live == 5);
+
+                v.unordered_erase(v.begin());
+                REQUIRE(has_values(v, {8, 4, 5, 7}));
+                REQUIRE(SelfRef::live == 4);
+            }
+            REQUIRE(SelfRef::live == 0);
+        }
+
+        SUBCASE("opted-in type is relocated without moves") {
+            static_assert(nestl::is_trivially_relocatable_v<Relocatable>);
+
+            vector<Relocatable> v;
+            for (int i = 0; i < 20; ++i) {
+                REQUIRE(v.emplace_back(i).is_ok());
+            }
+            REQUIRE(v.emplace(v.begin(), -1).is_ok());
+            v.erase(v.begin() + 1, v.begin() + 19);
+            REQUIRE(has_values(v, {-1, 18, 19}));
+            v.erase_if([](const Relocatable& e) { return e.value == 18; });
+            REQUIRE(has_values(v, {-1, 19}));
+        }
+    }
 }